@@ -0,0 +1,162 @@
+#pragma once
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Static analysis of a loaded program
+ *
+ * Follows control flow from PROGRAM_START without running the program
+ * (recursive descent) and recovers:
+ * - the reachable instructions, split into basic blocks with their
+ *   successors: 1NNN jumps, 2NNN calls (whose return site is a successor
+ *   too), 00EE returns and both outcomes of skips;
+ * - BNNN jumps, whose targets depend on a register at run time, listed
+ *   as indirect;
+ * - the code and data regions of the program image: bytes that no path
+ *   reaches are data (sprites, tables, padding);
+ * - FX33, FX55 and 5XY2 stores that write over code (self-modifying
+ *   code). A target is known when I was set by ANNN or F000 NNNN earlier
+ *   in the same block; other stores are listed as unresolved.
+ *
+ * A path stops at an unknown opcode, which is listed as invalid. Code only
+ * reached through indirect jumps is not found; it still runs, execution
+ * backends just discover it at run time (see CPU::translate()).
+ */
+class Analyzer
+{
+public:
+    /**
+     * @brief Straight-line run of instructions with one entry and one exit
+     */
+    struct Block
+    {
+        std::uint16_t start;                     // Address of the first instruction
+        std::uint32_t end;                       // Address after the last instruction
+        std::vector<std::uint16_t> instructions; // Address of every instruction, in order
+        std::vector<std::uint16_t> successors;   // Blocks execution continues at
+        bool returns;                            // Ends in 00EE; continues after the call
+        bool indirect;                           // Ends in BNNN; successors unknown
+        bool halts;                              // Ends in 00FD or a 1NNN jump to itself
+    };
+
+    /**
+     * @brief Memory write by FX33, FX55 or 5XY2
+     */
+    struct Store
+    {
+        std::uint16_t address; // Address of the storing instruction
+        bool resolved;         // Target known statically
+        std::uint16_t first;   // First byte written (when resolved)
+        std::uint16_t last;    // Last byte written (when resolved)
+        bool modifiesCode;     // Target overlaps a reachable instruction
+    };
+
+    /**
+     * @brief Half-open address range [start, end)
+     */
+    struct Range
+    {
+        std::uint16_t start;
+        std::uint32_t end;
+    };
+
+    /**
+     * @brief Analyze the program in memory
+     *
+     * Replaces the results of any earlier analysis.
+     * @param memory Memory holding a program loaded with loadROM() or loadProgram()
+     * @param quirks Variant the program runs on (affects how FX55 leaves I)
+     */
+    void analyze(const Memory &memory, CPU::Quirks quirks = CPU::QUIRKS_NONE);
+
+    /**
+     * @brief Basic blocks ordered by start address
+     */
+    const std::vector<Block> &getBlocks() const { return blocks; }
+
+    /**
+     * @brief Stores found in reachable code, ordered by address
+     */
+    const std::vector<Store> &getStores() const { return stores; }
+
+    /**
+     * @brief Parts of the program image no path reaches, ordered by address
+     */
+    const std::vector<Range> &getDataRegions() const { return dataRegions; }
+
+    /**
+     * @brief Addresses of reachable unknown opcodes
+     */
+    const std::vector<std::uint16_t> &getInvalid() const { return invalid; }
+
+    /**
+     * @brief Whether an instruction starts at the address
+     */
+    bool isInstruction(std::uint16_t address) const { return (flags[address] & INSTRUCTION) != 0; }
+
+    /**
+     * @brief Whether the byte belongs to a reachable instruction
+     */
+    bool isCode(std::uint16_t address) const { return (flags[address] & CODE) != 0; }
+
+    /**
+     * @brief Whether any reachable store writes over code
+     */
+    bool isSelfModifying() const;
+
+    /**
+     * @brief Disassemble the instruction at an address
+     * @param memory Memory holding the instruction
+     * @param address Address of the instruction
+     * @return Mnemonic and operands, e.g. "LD V0, 0x1F" or "DRW V0, V1, 5";
+     *         unknown opcodes are written as "DW 0xNNNN"
+     */
+    static std::string disassemble(const Memory &memory, std::uint16_t address);
+
+    /**
+     * @brief Bytes taken by the instruction at an address (4 for F000 NNNN, otherwise 2)
+     */
+    static std::uint16_t instructionLength(const Memory &memory, std::uint16_t address);
+
+    /**
+     * @brief Write a commented disassembly listing
+     *
+     * Blocks are listed with their successors, data regions as hex bytes,
+     * in address order, after a summary of the analysis.
+     * @param out Destination
+     * @param memory Memory that was analyzed
+     * @param name Name of the program for the header, e.g. the ROM path
+     */
+    void writeText(std::ostream &out, const Memory &memory, const std::string &name) const;
+
+    /**
+     * @brief Write the analysis as a JSON object
+     * @param out Destination
+     * @param memory Memory that was analyzed
+     * @param name Name of the program, e.g. the ROM path
+     */
+    void writeJson(std::ostream &out, const Memory &memory, const std::string &name) const;
+
+private:
+    // Per-address flags
+    static constexpr std::uint8_t INSTRUCTION = 1 << 0; // An instruction starts here
+    static constexpr std::uint8_t CODE = 1 << 1;        // Part of an instruction
+    static constexpr std::uint8_t LEADER = 1 << 2;      // A block starts here
+
+    std::array<std::uint8_t, Memory::MEMORY_SIZE> flags{};
+    std::vector<Block> blocks;
+    std::vector<Store> stores;
+    std::vector<Range> dataRegions;
+    std::vector<std::uint16_t> invalid;
+    std::size_t codeBytes = 0;
+
+    void traceCode(const Memory &memory);
+    void buildBlocks(const Memory &memory);
+    void findStores(const Memory &memory, CPU::Quirks quirks);
+    void findDataRegions(const Memory &memory);
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * @file AotAbi.hpp
+ * @brief Interface between recompiled ROM modules and the emulator
+ *
+ * chip8_recompile writes C++ source that includes only this header, so a
+ * module can be compiled without the rest of the emulator. The emulator
+ * finds the module table through the exported CHIP8_AOT_ENTRY_POINT
+ * function and refuses modules built for another CHIP8_AOT_ABI_VERSION.
+ * Bump the version whenever anything below changes.
+ */
+
+#define CHIP8_AOT_ABI_VERSION 2
+#define CHIP8_AOT_ENTRY_POINT chip8_aot_module
+
+#if defined(_WIN32)
+#define CHIP8_AOT_EXPORT __declspec(dllexport)
+#else
+#define CHIP8_AOT_EXPORT __attribute__((visibility("default")))
+#endif
+
+extern "C"
+{
+    /**
+     * @brief Guest state seen by recompiled blocks
+     *
+     * A copy of the CPU registers the backend keeps while blocks run. The
+     * helpers carry out the instructions that touch the display, memory or
+     * the random generator on the CPU the state belongs to, and report key
+     * indices above 0xF; each takes the address of its instruction, where
+     * faults are reported.
+     */
+    struct Chip8AotState
+    {
+        std::uint8_t registers[16];  // V0-VF
+        std::uint16_t indexRegister; // I
+        std::uint16_t programCounter;
+        std::uint8_t delayTimer;
+        std::uint8_t soundTimer;
+        const std::uint8_t *keys; // The 16 key states, read in place
+        void *host;               // CPU the helpers work on
+
+        // Helpers for 00E0, FN01, CXNN, DXYN (sets VF) and FX65
+        void (*clearDisplay)(Chip8AotState *state);
+        void (*selectPlanes)(Chip8AotState *state, std::uint8_t mask);
+        void (*random)(Chip8AotState *state, std::uint8_t x, std::uint8_t mask);
+        void (*draw)(Chip8AotState *state, std::uint16_t address, std::uint8_t x, std::uint8_t y, std::uint8_t height);
+        void (*load)(Chip8AotState *state, std::uint16_t address, std::uint8_t x);
+
+        // Reports the key index fault of an EX9E/EXA1 with Vx above 0xF
+        void (*keyIndex)(Chip8AotState *state, std::uint16_t address);
+    };
+
+    /**
+     * @brief Recompiled basic block
+     *
+     * The function runs the block from instruction first (counted from 0)
+     * until it ends or budget instructions (at least 1) have run, leaves
+     * the program counter at the next instruction and returns the number
+     * run. Every instruction is two bytes long, so the block can be entered
+     * at any of them. It is only valid while the size bytes from start
+     * still hold the values it was recompiled from.
+     */
+    struct Chip8AotBlock
+    {
+        std::uint16_t start;       // Address of the first instruction
+        std::uint16_t length;      // Instructions in the block
+        std::uint16_t size;        // Bytes the translation depends on, from start
+        const std::uint8_t *bytes; // Their values at recompile time
+        std::uint32_t (*function)(Chip8AotState *state, std::uint32_t first, std::uint32_t budget);
+    };
+
+    /**
+     * @brief Table exported by a recompiled module
+     */
+    struct Chip8AotModule
+    {
+        std::uint32_t abiVersion;    // CHIP8_AOT_ABI_VERSION the module was built with
+        std::uint32_t quirks;        // CPU::Quirks the blocks implement
+        std::uint64_t romHash;       // Memory::getROMHash() of the recompiled ROM
+        std::uint32_t blockCount;
+        const Chip8AotBlock *blocks; // Ordered by start address
+    };
+
+    typedef const Chip8AotModule *(*Chip8AotEntryPoint)();
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "ExecutionBackend.hpp"
+#include "AotAbi.hpp"
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class AotModule;
+
+/**
+ * @brief Backend that runs blocks recompiled ahead of time
+ *
+ * Runs the blocks of the module attached with CPU::setAotModule(), which
+ * chip8_recompile translated to C++ before the emulator started: no
+ * warm-up and no executable memory at run time. While blocks run, the
+ * registers live in a Chip8AotState copy that is written back before
+ * anything else touches the CPU.
+ *
+ * Blocks can be entered at any instruction and stop when the cycle budget
+ * runs out, so short frames stay in recompiled code. A block is checked
+ * against memory before its first use and again after every write that
+ * overlaps it, so self-modified code, another ROM or another quirk set
+ * simply runs without it. Code the module does not cover (indirect jump
+ * targets the analysis missed, calls, returns, key waits, memory writes,
+ * unknown opcodes) runs through the CPU's decoded interpreter, so
+ * execution stays cycle-exact with the reference interpreter.
+ */
+class AotBackend : public ExecutionBackend
+{
+public:
+    AotBackend();
+
+    void run(CPU &cpu, std::uint64_t cycles) override;
+    void invalidate(std::uint16_t address, std::size_t length) override;
+
+private:
+    // Whether a block may run
+    enum class Status : std::uint8_t
+    {
+        Unchecked, // Not compared with memory since the last overlapping write
+        Valid,     // Memory holds the recompiled bytes
+        Stale      // Memory differs; the interpreter runs the code
+    };
+
+    static constexpr std::uint16_t NO_BLOCK = 0xFFFF; // Blocks hold at least one of the 32K instructions
+
+    // Block instruction at an address
+    struct Entry
+    {
+        std::uint16_t block; // Index in the module table, NO_BLOCK if none
+        std::uint16_t index; // Instruction within the block
+    };
+
+    std::array<Entry, Memory::MEMORY_SIZE> entries;
+    std::vector<Status> statuses; // Per module block
+    const AotModule *module;      // Module the entries were built from
+    std::size_t reach;            // Largest block size, bounds the blocks a write can affect
+    Chip8AotState state;
+
+    void attach(const AotModule *newModule);
+    bool check(const CPU &cpu, std::uint16_t block);
+    static bool matches(const CPU &cpu, const Chip8AotBlock &block);
+
+    // Whether a block instruction starts at the entry and may run
+    bool isRunnable(const CPU &cpu, const Entry &entry)
+    {
+        return entry.block != NO_BLOCK && (statuses[entry.block] == Status::Valid || check(cpu, entry.block));
+    }
+
+    void loadState(CPU &cpu);
+    void storeState(CPU &cpu) const;
+
+    // Helpers called from recompiled code
+    static void helperClearDisplay(Chip8AotState *state);
+    static void helperSelectPlanes(Chip8AotState *state, std::uint8_t mask);
+    static void helperRandom(Chip8AotState *state, std::uint8_t x, std::uint8_t mask);
+    static void helperDraw(Chip8AotState *state, std::uint16_t address, std::uint8_t x, std::uint8_t y,
+                           std::uint8_t height);
+    static void helperLoad(Chip8AotState *state, std::uint16_t address, std::uint8_t x);
+    static void helperKeyIndex(Chip8AotState *state, std::uint16_t address);
+};
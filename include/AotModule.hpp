@@ -0,0 +1,74 @@
+#pragma once
+#include "AotAbi.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Recompiled ROM module loaded from a shared object
+ *
+ * Wraps a module built from chip8_recompile output (see AotAbi.hpp). The
+ * module stays loaded until the object is destroyed, so it must outlive
+ * every CPU it is attached to (CPU::setAotModule()).
+ *
+ * Only available where shared objects can be loaded at run time (Linux,
+ * macOS and other POSIX systems); see isSupported().
+ */
+class AotModule
+{
+public:
+    AotModule() = default;
+
+    /**
+     * @brief Destructor - unloads the shared object
+     */
+    ~AotModule();
+
+    AotModule(const AotModule &) = delete;
+    AotModule &operator=(const AotModule &) = delete;
+
+    /**
+     * @brief Check whether modules can be loaded on this platform
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Load a module, replacing any loaded one
+     * @param path Path to the shared object
+     * @param error Set to the reason on failure
+     * @return false if the file cannot be loaded, has no module table or was
+     *         built for another ABI version
+     */
+    bool load(const std::string &path, std::string &error);
+
+    /**
+     * @brief Whether a module is loaded
+     */
+    bool isLoaded() const { return table != nullptr; }
+
+    /**
+     * @brief Table of the loaded module, nullptr if none
+     */
+    const Chip8AotModule *getTable() const { return table; }
+
+    /**
+     * @brief Quirks the blocks implement (CPU::Quirks)
+     */
+    std::uint8_t getQuirks() const { return table ? static_cast<std::uint8_t>(table->quirks) : 0; }
+
+    /**
+     * @brief Hash of the ROM the module was recompiled from
+     */
+    std::uint64_t getROMHash() const { return table ? table->romHash : 0; }
+
+    /**
+     * @brief Number of recompiled blocks
+     */
+    std::size_t getBlockCount() const { return table ? table->blockCount : 0; }
+
+private:
+    void *handle = nullptr;                 // Shared object handle
+    const Chip8AotModule *table = nullptr;  // Module table inside it
+
+    void unload();
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include "CPU.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Turns a machine's sound state into PCM samples, one frame at a time
+ *
+ * While the sound timer is non-zero the 128-bit audio pattern plays in a
+ * loop, one bit per sample period at 4000*2^((pitch-64)/48) bits/s, as on
+ * XO-CHIP. reset() leaves a 0xF0 pattern at pitch 64, so classic ROMs get
+ * a 500Hz square wave beep. The volume ramps over a few samples when the
+ * tone starts and stops to avoid clicks.
+ *
+ * Output is 16-bit signed mono. Runs on the emulation thread and does not
+ * allocate; the samples go to a WavWriter or, in the GUI, through a
+ * lock-free ring to the audio device.
+ */
+class AudioGenerator
+{
+public:
+    static constexpr unsigned SAMPLE_RATE = 44100;
+    static constexpr unsigned FRAME_RATE = 60;
+    static constexpr std::size_t SAMPLES_PER_FRAME = SAMPLE_RATE / FRAME_RATE; // 735
+    static constexpr std::int16_t AMPLITUDE = 6000; // Peak of the tone, well below full scale
+
+    AudioGenerator();
+
+    /**
+     * @brief Restart from silence
+     */
+    void reset();
+
+    /**
+     * @brief Render one emulated frame of sound
+     *
+     * Call once per frame after running its cycles and before
+     * CPU::updateTimers(), so a sound timer of N plays for N frames.
+     * @param cpu Machine whose sound timer, pattern and pitch to play
+     * @param samples Receives SAMPLES_PER_FRAME samples
+     */
+    void renderFrame(const CPU &cpu, std::int16_t *samples);
+
+private:
+    static constexpr int RAMP_SAMPLES = 64; // Fade in/out length (about 1.5ms)
+
+    double phase; // Position in the pattern, in bits [0, 128)
+    int gain;     // Current volume in 1/RAMP_SAMPLES steps, 0 = silent
+};
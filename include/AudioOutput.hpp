@@ -0,0 +1,73 @@
+#pragma once
+#include "AudioGenerator.hpp"
+#include "SpscRing.hpp"
+#include "raylib.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Plays generated samples on the audio device
+ *
+ * The emulation thread push()es each frame's samples into a lock-free
+ * ring; raylib's audio thread pulls them from its stream callback. The
+ * callback never locks or allocates: when the ring runs dry it pads with
+ * silence and counts an underrun (an already empty ring is taken as a
+ * paused or idle emulator and is not counted). The producer keeps at most
+ * a few frames queued and drops whole frames beyond that, so latency stays
+ * bounded when emulation runs faster than the audio clock.
+ *
+ * raylib's stream callback has no user pointer, so only one AudioOutput
+ * can be initialized at a time.
+ */
+class AudioOutput
+{
+public:
+    static constexpr std::size_t RING_SAMPLES = 8192; // Ring capacity (about 186ms)
+    static constexpr std::size_t MAX_QUEUED = 4 * AudioGenerator::SAMPLES_PER_FRAME; // About 67ms of latency
+    static constexpr int DEVICE_BUFFER_SAMPLES = 1024; // Samples per callback
+
+    AudioOutput();
+    ~AudioOutput();
+
+    AudioOutput(const AudioOutput &) = delete;
+    AudioOutput &operator=(const AudioOutput &) = delete;
+
+    /**
+     * @brief Open the audio device and start the stream
+     * @return false if there is no usable audio device (push() then does nothing)
+     */
+    bool initialize();
+
+    /**
+     * @brief Stop the stream and close the audio device
+     */
+    void shutdown();
+
+    /**
+     * @brief Queue samples for playback (emulation thread)
+     * @param samples Samples at AudioGenerator::SAMPLE_RATE
+     * @param count Number of samples
+     */
+    void push(const std::int16_t *samples, std::size_t count);
+
+    /**
+     * @brief Callbacks that ran out of samples part way through
+     */
+    std::uint64_t getUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Samples dropped because too many were queued
+     */
+    std::uint64_t getDropped() const { return dropped; }
+
+private:
+    static void streamCallback(void *buffer, unsigned int frames);
+    static std::atomic<AudioOutput *> active; // Instance the callback feeds
+
+    SpscRing<std::int16_t, RING_SAMPLES> ring;
+    AudioStream stream;
+    bool ready;
+    std::atomic<std::uint64_t> underruns; // Written by the audio thread
+    std::uint64_t dropped;                // Written by the emulation thread
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include "CPU.hpp"
+#include "WorkStealingPool.hpp"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One headless run in a batch
+ */
+struct BatchJob
+{
+    std::string romPath;
+    std::string inputScriptPath; ///< Empty for no input
+    std::uint64_t frames = 600;
+    std::uint64_t cyclesPerFrame = 9;
+    CPU::Backend backend = CPU::Backend::Cached;
+    std::uint32_t seed = CPU::DEFAULT_RANDOM_SEED; ///< CXNN random seed
+    CPU::RandomGenerator random = CPU::RandomGenerator::Xorshift; ///< CXNN generator
+    CPU::Quirks quirks = CPU::QUIRKS_NONE;         ///< Variant behaviors
+};
+
+/**
+ * @brief Final machine state of a batch job
+ */
+struct BatchResult
+{
+    bool ok = false;
+    std::string error; ///< Why the job did not run (when !ok)
+    std::uint64_t framebufferHash = 0;
+    std::array<std::uint8_t, 16> registers{};
+    std::uint16_t indexRegister = 0;
+    std::uint16_t programCounter = 0;
+    std::uint64_t frames = 0;
+    std::uint64_t cycles = 0;
+    double seconds = 0.0; ///< Wall time spent on this job
+    std::uint64_t faults = 0; ///< Fault events raised (unknown opcodes, stack errors, ...)
+};
+
+/**
+ * @brief Runs many independent ROM instances in parallel
+ *
+ * Every job gets its own Memory and CPU, so jobs share no state and the
+ * results do not depend on the thread count or scheduling. Jobs are spread
+ * over a work-stealing pool with one worker per hardware thread by default.
+ */
+class BatchEngine
+{
+public:
+    /**
+     * @brief Constructor
+     * @param threads Worker count, 0 for one per hardware thread
+     */
+    explicit BatchEngine(std::size_t threads = 0);
+
+    std::size_t getThreadCount() const { return pool.getThreadCount(); }
+
+    /**
+     * @brief Run all jobs and wait for them to finish
+     * @param jobs Jobs to run
+     * @return One result per job, in job order
+     */
+    std::vector<BatchResult> run(const std::vector<BatchJob> &jobs);
+
+    /**
+     * @brief Run a single job on the calling thread
+     *
+     * When the input script is a recorded movie, its seed, quirks and
+     * cycles per frame replace the job's, and its ROM hash must match the ROM.
+     * @param job Job to run
+     * @return Job result
+     */
+    static BatchResult runJob(const BatchJob &job);
+
+    /**
+     * @brief Read a job list file
+     *
+     * One job per line: "<rom> <frames> [input_script [quirks]]". An input
+     * script of "-" means no input; quirks use CPU::parseQuirks() syntax.
+     * Blank lines and text after '#' are ignored.
+     * @param path Job list path
+     * @param defaults Values for fields the file does not set
+     * @param jobs Jobs read from the file are appended here
+     * @param error Set to a description of the problem on failure
+     * @return true if the whole file was read
+     */
+    static bool loadJobList(const std::string &path, const BatchJob &defaults,
+                            std::vector<BatchJob> &jobs, std::string &error);
+
+private:
+    WorkStealingPool pool;
+};
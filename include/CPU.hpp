@@ -1,9 +1,17 @@
 #pragma once
+#include "Memory.hpp"
+#include "SpscRing.hpp"
 #include <cstdint>
 #include <array>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <string>
 
-// Forward declaration
-class Memory;
+class Analyzer;
+class AotModule;
+class ExecutionBackend;
+class Profiler;
 
 /**
  * @brief CHIP-8 CPU implementation
@@ -14,20 +22,222 @@ class Memory;
  * - 16-bit program counter (PC)
  * - 16-level stack for subroutines
  * - Delay and sound timers
- * - 64x32 monochrome display
+ * - 64x32 display, or 128x64 in SUPER-CHIP high resolution, with two
+ *   XO-CHIP bitplanes, each stored as 64-bit words (two per row,
+ *   bit 63 = leftmost pixel)
+ * - SUPER-CHIP scrolling, 16x16 sprites, large font and RPL flags
+ * - XO-CHIP 64KB memory, long I loads, register ranges, plane selection
+ *   and the audio pattern buffer with its pitch register
  * - 16-key hexadecimal keypad
+ *
+ * Instructions are decoded once and kept in a cache indexed by address, so
+ * the common path is a single indirect call per cycle. Memory writes
+ * invalidate the affected cache entries, which keeps self-modifying
+ * programs correct. The cache is allocated on the first cached cycle from
+ * zeroed memory, so machines that only ever run the reference interpreter
+ * do not carry it, and the system only provides the parts that code runs
+ * from (which keeps forked machines cheap).
+ *
+ * Behaviors that differ between CHIP-8 variants are selected with quirk
+ * flags (setQuirks()). The decoded handlers and the threaded backend are
+ * instantiated for every combination of flags, so the selected variant
+ * runs without any per-instruction quirk checks.
+ *
+ * Faults (unknown opcodes, stack overflow/underflow, accesses that run
+ * past the end of memory, key numbers past 0xF) never stop or slow
+ * execution: they are pushed as events onto a lock-free ring that the
+ * front end drains, typically once per frame (see FaultLog).
  */
-class CPU
+class CPU : private Memory::Observer
 {
 public:
-    // Display constants
-    static constexpr std::size_t DISPLAY_WIDTH = 64;
-    static constexpr std::size_t DISPLAY_HEIGHT = 32;
+    // Display constants: 64x32 low resolution, 128x64 SUPER-CHIP high resolution
+    static constexpr std::size_t LORES_WIDTH = 64;
+    static constexpr std::size_t LORES_HEIGHT = 32;
+    static constexpr std::size_t HIRES_WIDTH = 128;
+    static constexpr std::size_t HIRES_HEIGHT = 64;
+    static constexpr std::size_t DISPLAY_WIDTH = HIRES_WIDTH;   // Largest resolution
+    static constexpr std::size_t DISPLAY_HEIGHT = HIRES_HEIGHT;
     static constexpr std::size_t DISPLAY_SIZE = DISPLAY_WIDTH * DISPLAY_HEIGHT;
+    static constexpr std::size_t DISPLAY_ROW_WORDS = DISPLAY_WIDTH / 64; // 64-bit words per row
+    static constexpr std::size_t DISPLAY_WORDS = DISPLAY_ROW_WORDS * DISPLAY_HEIGHT; // Per plane
+    static constexpr std::size_t DISPLAY_PLANES = 2;                                  // XO-CHIP bitplanes
+    static constexpr std::uint8_t ALL_PLANES = (1 << DISPLAY_PLANES) - 1;
+
+    // XO-CHIP audio: a 128-bit pattern played at 4000 * 2^((pitch - 64) / 48) bits per second
+    static constexpr std::size_t AUDIO_PATTERN_SIZE = 16;
+    static constexpr std::uint8_t DEFAULT_PITCH = 64;
+
+    // SUPER-CHIP RPL user flags saved and restored by FX75/FX85
+    static constexpr std::size_t FLAG_REGISTER_COUNT = 16;
 
     // Keyboard constants
     static constexpr std::size_t KEY_COUNT = 16;
 
+    // Longest loop body, in instructions, that run() skips as an idle loop
+    static constexpr std::uint64_t IDLE_LOOP_MAX_LENGTH = 8;
+
+    // Seed for the CXNN random number generator until setRandomSeed() is called
+    static constexpr std::uint32_t DEFAULT_RANDOM_SEED = 1;
+
+    // Size of a saved machine state (CPU fields followed by all of memory)
+    static constexpr std::size_t STATE_SIZE =
+        4 +                       // Format tag
+        2 + 2 + 2 + 16 +          // Opcode, I, PC, V0-VF
+        1 + 1 +                   // Delay and sound timers
+        2 * 16 + 1 +              // Stack and stack pointer
+        8 * DISPLAY_WORDS * DISPLAY_PLANES + // Display planes
+        1 + 1 +                   // Resolution and selected planes
+        FLAG_REGISTER_COUNT +     // RPL flags
+        AUDIO_PATTERN_SIZE + 1 +  // Audio pattern and pitch
+        KEY_COUNT +               // Keys
+        1 + 4 + 4 +               // Random generator, seed and state
+        Memory::MEMORY_SIZE;      // RAM
+
+    /**
+     * @brief Set of quirk flags (QUIRK_*)
+     *
+     * With no flags set the CPU behaves as it always has: 8XY6/8XYE shift
+     * VX, BNNN jumps to NNN + V0, FX55/FX65 leave I unchanged, 8XY1-8XY3
+     * leave VF alone and sprites wrap around the screen edges.
+     */
+    using Quirks = std::uint8_t;
+
+    static constexpr Quirks QUIRK_SHIFT_VY = 1 << 0;     // 8XY6/8XYE shift VY into VX
+    static constexpr Quirks QUIRK_JUMP_VX = 1 << 1;      // BXNN jumps to XNN + VX
+    static constexpr Quirks QUIRK_INCREMENT_I = 1 << 2;  // FX55/FX65 leave I at I + X + 1
+    static constexpr Quirks QUIRK_RESET_VF = 1 << 3;     // 8XY1/8XY2/8XY3 clear VF
+    static constexpr Quirks QUIRK_CLIP_SPRITES = 1 << 4; // Sprites stop at the screen edges
+    static constexpr Quirks QUIRKS_NONE = 0;
+    static constexpr Quirks QUIRKS_ALL = 0x1F;
+    static constexpr std::size_t QUIRK_COMBINATIONS = QUIRKS_ALL + 1;
+
+    /**
+     * @brief Kinds of fault event
+     */
+    enum class Fault : std::uint8_t
+    {
+        UnknownOpcode,  // Opcode with no meaning (includes 0NNN machine calls)
+        StackOverflow,  // CALL with 16 return addresses already stacked
+        StackUnderflow, // RET with an empty stack
+        AddressWrap,    // Memory access past 0xFFFF, wrapped to the start
+        PcWrap,         // Instruction fetch past 0xFFFF, wrapped to the start
+        KeyIndex        // EX9E/EXA1 with Vx past 0xF, masked to the low nibble
+    };
+
+    /**
+     * @brief One fault, as queued for the front end
+     */
+    struct FaultEvent
+    {
+        Fault type;
+        std::uint16_t pc;      // Address of the faulting instruction
+        std::uint16_t address; // Accessed address (AddressWrap/PcWrap), else PC
+        std::uint16_t opcode;  // Faulting instruction
+    };
+
+    static constexpr std::size_t FAULT_RING_SIZE = 256;
+    using FaultRing = SpscRing<FaultEvent, FAULT_RING_SIZE>;
+
+    /**
+     * @brief CXNN random number generators
+     */
+    enum class RandomGenerator : std::uint8_t
+    {
+        Xorshift, // xorshift32 started from the scrambled seed (default)
+        Counter   // Byte N is a hash of the seed and N; every seed is an independent stream
+    };
+
+    /**
+     * @brief Execution backends, selectable at runtime
+     */
+    enum class Backend
+    {
+        Interpreter, // Reference fetch/decode/switch interpreter
+        Cached,      // Decoded instruction cache, one handler call per cycle
+        Threaded,    // Basic blocks run as threaded code
+        Jit,         // Hot basic blocks compiled to x86-64, the decoded cache runs the rest
+                     // (setBackend() selects Threaded on hosts that cannot JIT)
+        Aot          // Blocks recompiled ahead of time (see setAotModule()), interpreter elsewhere
+    };
+
+    /**
+     * @brief Decoded operation identifiers
+     */
+    enum class Operation : std::uint8_t
+    {
+        Fallback, // Unknown or unhandled opcode, runs through the reference switch
+        Cls,      // 00E0
+        Ret,      // 00EE
+        Jp,       // 1NNN
+        Call,     // 2NNN
+        SeImm,    // 3XNN
+        SneImm,   // 4XNN
+        SeReg,    // 5XY0
+        LdImm,    // 6XNN
+        AddImm,   // 7XNN
+        LdReg,    // 8XY0
+        OrReg,    // 8XY1
+        AndReg,   // 8XY2
+        XorReg,   // 8XY3
+        AddReg,   // 8XY4
+        SubReg,   // 8XY5
+        Shr,      // 8XY6
+        Subn,     // 8XY7
+        Shl,      // 8XYE
+        SneReg,   // 9XY0
+        LdI,      // ANNN
+        JpV0,     // BNNN
+        Rnd,      // CXNN
+        Drw,      // DXYN
+        Skp,      // EX9E
+        Sknp,     // EXA1
+        LdVxDt,   // FX07
+        LdKey,    // FX0A
+        LdDtVx,   // FX15
+        LdStVx,   // FX18
+        AddI,     // FX1E
+        LdFont,   // FX29
+        Bcd,      // FX33
+        Store,    // FX55
+        Load,     // FX65
+        ScrollDown,  // 00CN (SUPER-CHIP)
+        ScrollRight, // 00FB (SUPER-CHIP)
+        ScrollLeft,  // 00FC (SUPER-CHIP)
+        Exit,        // 00FD (SUPER-CHIP)
+        Lores,       // 00FE (SUPER-CHIP)
+        Hires,       // 00FF (SUPER-CHIP)
+        LdBigFont,   // FX30 (SUPER-CHIP)
+        StoreFlags,  // FX75 (SUPER-CHIP)
+        LoadFlags,   // FX85 (SUPER-CHIP)
+        ScrollUp,    // 00DN (XO-CHIP)
+        SaveRange,   // 5XY2 (XO-CHIP)
+        LoadRange,   // 5XY3 (XO-CHIP)
+        LdILong,     // F000 NNNN (XO-CHIP)
+        Plane,       // FN01 (XO-CHIP)
+        Audio,       // F002 (XO-CHIP)
+        Pitch,       // FX3A (XO-CHIP)
+        Count
+    };
+
+    /**
+     * @brief Pre-decoded instruction
+     *
+     * Holds the handler for the specific operation together with the operand
+     * fields already extracted from the opcode.
+     */
+    struct Instruction
+    {
+        void (*handler)(CPU &cpu, const Instruction &instruction); // Executes the operation
+        std::uint16_t opcode;                                     // Raw 16-bit opcode
+        std::uint16_t nnn;                                        // 12-bit address
+        std::uint8_t x;                                           // Register index X
+        std::uint8_t y;                                           // Register index Y
+        std::uint8_t n;                                           // 4-bit immediate
+        std::uint8_t nn;                                          // 8-bit immediate
+        Operation op;                                             // Operation identifier
+    };
+
     /**
      * @brief Constructor
      * @param memory Pointer to memory instance
@@ -37,13 +247,287 @@ public:
     /**
      * @brief Destructor
      */
-    ~CPU() = default;
+    ~CPU() override;
+
+    CPU(const CPU &) = delete;
+    CPU &operator=(const CPU &) = delete;
 
     /**
-     * @brief Execute one CPU cycle (fetch, decode, execute)
+     * @brief Execute one CPU cycle using the decoded instruction cache
      */
     void emulateCycle();
 
+    /**
+     * @brief Execute exactly the given number of cycles with the selected backend
+     *
+     * With idle skipping on (the default), cycles that cannot change the
+     * machine state are not executed, and the state is left exactly as if
+     * they had been:
+     * - While isWaitingForKey(), every cycle would re-execute the same FX0A.
+     * - An idle loop at the program counter is skipped a whole pass at a
+     *   time. An idle loop is at most IDLE_LOOP_MAX_LENGTH instructions
+     *   that only read registers, the delay timer or the keys, skip and
+     *   jump (e.g. FX07; 3X00; 1NNN polling the delay timer, or a 1NNN
+     *   jump to itself), and whose second pass ends in the same state as
+     *   its first. Neither the timers nor the keys change during run(),
+     *   so every later pass does the same.
+     * @param cycles Number of instructions to execute
+     */
+    void run(std::uint64_t cycles);
+
+    /**
+     * @brief Whether the machine is halted on FX0A
+     *
+     * True when the instruction at the program counter is FX0A and no key
+     * is held. Until the keypad changes, cycles change nothing; only the
+     * timers still count down.
+     */
+    bool isWaitingForKey() const;
+
+    /**
+     * @brief Whether the machine can make no more progress on its own
+     *
+     * True while isWaitingForKey(), and when the instruction at the program
+     * counter is a 1NNN jump to itself or 00FD (SUPER-CHIP exit). Only the
+     * timers still count down; a halt on FX0A ends when a key is pressed,
+     * the others never do.
+     */
+    bool isHalted() const;
+
+    /**
+     * @brief Skip the cycles of idle loops in run() (on by default)
+     *
+     * The machine state is the same either way; benchmarks that time the
+     * backends themselves turn it off.
+     * @param enabled Whether to skip
+     */
+    void setIdleSkipping(bool enabled) { idleSkipping = enabled; }
+    bool getIdleSkipping() const { return idleSkipping; }
+
+    /**
+     * @brief Select the execution backend used by run()
+     * @param newBackend Backend to use
+     */
+    void setBackend(Backend newBackend);
+    Backend getBackend() const { return backend; }
+
+    /**
+     * @brief Attach the recompiled module run by the Aot backend
+     *
+     * Without a module, or with one built for other quirks, the Aot backend
+     * runs everything on the decoded instruction cache. Blocks whose code
+     * is not in memory (another ROM, self-modified code) are skipped.
+     * @param module Loaded module that outlives this CPU, or nullptr to detach
+     */
+    void setAotModule(const AotModule *module) { aotModule = module; }
+    const AotModule *getAotModule() const { return aotModule; }
+
+    /**
+     * @brief Translate the blocks of a static analysis before running them
+     *
+     * Lets the threaded and JIT backends build their translations at ROM
+     * load instead of on first (or hot) execution. Call after setBackend()
+     * and setQuirks(), which drop translations; the interpreter and cached
+     * backends ignore it. Execution is the same either way.
+     * @param analysis Analysis of the program in this CPU's memory
+     */
+    void translate(const Analyzer &analysis);
+
+    /**
+     * @brief Select the variant behaviors
+     *
+     * Drops all decoded and translated instructions; the machine state
+     * is kept.
+     * @param newQuirks Combination of QUIRK_* flags
+     */
+    void setQuirks(Quirks newQuirks);
+    Quirks getQuirks() const { return quirks; }
+
+    /**
+     * @brief Parse a quirk specification
+     *
+     * A comma-separated list of profile names (see quirkProfiles()) and
+     * flag names (shift-vy, jump-vx, increment-i, reset-vf, clip-sprites),
+     * e.g. "vip" or "schip,shift-vy".
+     * @param text Specification
+     * @param quirks Set to the combined flags
+     * @return false if any name is unknown
+     */
+    static bool parseQuirks(const char *text, Quirks &quirks);
+
+    /**
+     * @brief Describe a set of quirks
+     * @return The matching profile name, otherwise the flag names
+     *         joined with commas
+     */
+    static std::string quirksName(Quirks quirks);
+
+    /**
+     * @brief Named quirk profile
+     */
+    struct QuirkProfile
+    {
+        const char *name;
+        Quirks quirks;
+        const char *description;
+    };
+
+    /**
+     * @brief Known profiles, terminated by an entry with a null name
+     */
+    static const QuirkProfile *quirkProfiles();
+
+    /**
+     * @brief Collect an execution profile while running
+     *
+     * While a profiler is attached, run() executes every backend through
+     * the decoded instruction cache one instruction at a time, so each
+     * instruction is counted and timed. Only available when the core is
+     * built with CHIP8_PROFILE defined (CMake option CHIP8_PROFILER).
+     * @param newProfiler Profiler to fill in, or nullptr to detach
+     * @return false if profiling was compiled out
+     */
+    bool setProfiler(Profiler *newProfiler);
+
+    /**
+     * @brief Pending fault events
+     *
+     * The emulation thread is the only producer; one consumer (the end of
+     * the frame or a diagnostics thread) drains it.
+     */
+    FaultRing &getFaults() { return faults; }
+
+    /**
+     * @brief Faults lost because the ring was full
+     */
+    std::uint64_t getDroppedFaults() const { return droppedFaults.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Readable name of a fault type, e.g. "stack overflow"
+     */
+    static const char *faultName(Fault type);
+
+    /**
+     * @brief Name of a backend as used on the command line
+     * @param backend Backend
+     * @return "interpreter", "cached", "threaded", "jit" or "aot"
+     */
+    static const char *backendName(Backend backend);
+
+    /**
+     * @brief Look up a backend by name
+     * @param name Backend name (see backendName())
+     * @param backend Set to the matching backend
+     * @return true if the name is known
+     */
+    static bool parseBackendName(const char *name, Backend &backend);
+
+    /**
+     * @brief Write the complete machine state (CPU and memory) to a buffer
+     *
+     * Does not allocate. The format is fixed-size and byte-order independent.
+     * @param buffer Destination
+     * @param size Size of the destination, at least STATE_SIZE
+     * @return Bytes written (STATE_SIZE), or 0 if the buffer is too small
+     */
+    std::size_t saveState(std::uint8_t *buffer, std::size_t size) const;
+
+    /**
+     * @brief Restore a machine state written by saveState()
+     *
+     * Does not allocate. The selected backend is kept; translations of
+     * memory that differs from the restored state are dropped. A state
+     * with a stack pointer, display mode, plane mask or random generator
+     * out of range is refused and leaves the machine unchanged.
+     * @param buffer Source
+     * @param size Size of the source
+     * @return true if the buffer held a valid state
+     */
+    bool loadState(const std::uint8_t *buffer, std::size_t size);
+
+    /**
+     * @brief Seed the random number generator used by CXNN
+     *
+     * Each CPU has its own generator, so machines with the same seed and
+     * input produce the same random sequence. reset() restarts the sequence.
+     * @param seed Seed value
+     */
+    void setRandomSeed(std::uint32_t seed);
+
+    /**
+     * @brief Seed last passed to setRandomSeed()
+     */
+    std::uint32_t getRandomSeed() const { return randomSeed; }
+
+    /**
+     * @brief Select the CXNN random number generator
+     *
+     * Restarts the sequence from the current seed. The counter generator
+     * needs no state beyond the number of bytes drawn, so instances run
+     * in parallel get uncorrelated streams just by using different seeds
+     * (e.g. seed + instance index), with no coordination between them.
+     * @param generator Generator to use
+     */
+    void setRandomGenerator(RandomGenerator generator);
+    RandomGenerator getRandomGenerator() const { return randomGenerator; }
+
+    /**
+     * @brief Name of a generator as used on the command line
+     * @return "xorshift" or "counter"
+     */
+    static const char *randomGeneratorName(RandomGenerator generator);
+
+    /**
+     * @brief Look up a generator by name
+     * @param name Generator name (see randomGeneratorName())
+     * @param generator Set to the matching generator
+     * @return true if the name is known
+     */
+    static bool parseRandomGenerator(const char *name, RandomGenerator &generator);
+
+    /**
+     * @brief Turn this machine into a copy of another one (fork)
+     *
+     * Memory is shared with the parent copy-on-write (see Memory), so the
+     * cost is a reference per memory page plus the CPU fields and the 2KB
+     * display; a page is only copied when one of the machines writes to it.
+     * Registers, timers, keys, display, random generator state, quirks,
+     * backend and idle skipping are copied. Decoded instructions and
+     * translations are not: the child builds its own as it runs, and a
+     * child that is forked again keeps those of every page that did not
+     * change, so reusing child machines is cheaper than creating new ones.
+     * Pending faults and an attached profiler stay with the parent.
+     *
+     * The parent must not be running during the call. Afterwards the two
+     * machines are independent and may run on different threads.
+     * @param parent Machine to copy, attached to a different Memory
+     */
+    void forkFrom(const CPU &parent);
+
+    /**
+     * @brief Compare the complete machine state (CPU and memory)
+     * @param other CPU to compare against
+     * @return true if both machines are in the same state
+     */
+    bool hasSameState(const CPU &other) const;
+
+    /**
+     * @brief Execute one CPU cycle with the reference interpreter
+     *
+     * Fetches and decodes the opcode from memory on every call. Kept as the
+     * fallback path and as the reference for checking faster backends.
+     */
+    void interpretCycle();
+
+    /**
+     * @brief Decode an opcode into its handler and operand fields
+     * @param opcode Raw 16-bit opcode
+     * @param quirks Variant the handler is built for; the operation and
+     *        operand fields do not depend on it
+     * @return Decoded instruction
+     */
+    static Instruction decode(std::uint16_t opcode, Quirks quirks = QUIRKS_NONE);
+
     /**
      * @brief Update timers (should be called at 60Hz)
      */
@@ -54,8 +538,42 @@ public:
      */
     void reset();
 
-    // Display access
-    const std::array<std::uint8_t, DISPLAY_SIZE> &getDisplay() const { return display; }
+    /**
+     * @brief Byte-per-pixel view of the display
+     *
+     * Covers the current resolution, getDisplayWidth() pixels per row. Each
+     * pixel holds bit 0 from plane 0 and bit 1 from plane 1, so programs
+     * that never select plane 1 only produce 0 and 1. Expanded from the
+     * packed rows on demand; the reference stays valid for the lifetime of
+     * the CPU.
+     */
+    const std::array<std::uint8_t, DISPLAY_SIZE> &getDisplay() const;
+
+    /**
+     * @brief Packed display rows of one plane
+     *
+     * Row y starts at word y * DISPLAY_ROW_WORDS; bit 63 of the first word
+     * is the leftmost pixel (x = 0). In low resolution only the first word
+     * of rows 0-31 is used.
+     * @param plane Plane index, 0 or 1 (XO-CHIP)
+     */
+    const std::array<std::uint64_t, DISPLAY_WORDS> &getDisplayRows(std::size_t plane = 0) const { return display[plane]; }
+
+    /**
+     * @brief Whether the SUPER-CHIP 128x64 mode is active (00FF)
+     */
+    bool isHighResolution() const { return hires; }
+    std::size_t getDisplayWidth() const { return hires ? HIRES_WIDTH : LORES_WIDTH; }
+    std::size_t getDisplayHeight() const { return hires ? HIRES_HEIGHT : LORES_HEIGHT; }
+
+    /**
+     * @brief Hash the display contents (64-bit FNV-1a)
+     *
+     * Plane 1 is only included once it has a lit pixel, so programs that
+     * never use it hash the same as on a single-plane display.
+     * @return Hash value, stable across runs and platforms
+     */
+    std::uint64_t getDisplayHash() const;
 
     // Input access
     std::array<std::uint8_t, KEY_COUNT> &getKeys() { return keys; }
@@ -63,6 +581,16 @@ public:
 
     // Timer access (for debugging/sound)
     std::uint8_t getDelayTimer() const { return delayTimer; }
+    std::uint8_t getSoundTimer() const { return soundTimer; } ///< Non-zero while the tone plays
+
+    // XO-CHIP audio (F002/FX3A); reset() loads a 500Hz square wave at DEFAULT_PITCH
+    const std::array<std::uint8_t, AUDIO_PATTERN_SIZE> &getAudioPattern() const { return audioPattern; }
+    std::uint8_t getPitch() const { return pitch; }
+
+    // Register access (for debugging/batch results)
+    const std::array<std::uint8_t, 16> &getRegisters() const { return registers; }
+    std::uint16_t getIndexRegister() const { return indexRegister; }
+    std::uint16_t getProgramCounter() const { return programCounter; }
 
 private:
     // CPU Registers
@@ -73,19 +601,75 @@ private:
 
     // Timers
     std::uint8_t delayTimer; // Delay timer
-    std::uint8_t soundTimer; // Sound timer (not used)
+    std::uint8_t soundTimer; // Sound timer, the tone plays while non-zero
 
     // Stack
     std::array<std::uint16_t, 16> stack; // Call stack
     std::uint8_t stackPointer;           // Stack pointer
 
     // I/O
-    std::array<std::uint8_t, DISPLAY_SIZE> display; // Display buffer
-    std::array<std::uint8_t, KEY_COUNT> keys;       // Key states
+    std::array<std::array<std::uint64_t, DISPLAY_WORDS>, DISPLAY_PLANES> display; // Rows per plane, bit 63 of the first word = x 0
+    bool hires;                               // 128x64 mode (00FF)
+    std::uint8_t planeMask;                   // Planes drawn, cleared and scrolled (FN01), bit 0 = plane 0
+    bool classicDisplay;                      // Low resolution with only plane 0 selected (drawSprite fast path)
+    std::array<std::uint8_t, KEY_COUNT> keys; // Key states
+
+    // SUPER-CHIP RPL user flags (FX75/FX85)
+    std::array<std::uint8_t, FLAG_REGISTER_COUNT> flagRegisters;
+
+    // XO-CHIP audio pattern (F002) and playback pitch (FX3A)
+    std::array<std::uint8_t, AUDIO_PATTERN_SIZE> audioPattern;
+    std::uint8_t pitch;
+
+    // Random number generator
+    RandomGenerator randomGenerator; // Selected generator
+    std::uint32_t randomSeed;        // Seed restored by reset()
+    std::uint32_t randomState;       // xorshift32 state (never zero) or bytes drawn (counter)
+
+    // Byte-per-pixel view returned by getDisplay()
+    mutable std::array<std::uint8_t, DISPLAY_SIZE> displayPixels;
+    mutable bool displayPixelsStale;
 
     // Memory reference
     Memory *memory;
 
+    // Decoded instruction cache, MEMORY_SIZE entries indexed by address,
+    // a null handler marking a miss; allocated zeroed by the first
+    // emulateCycle() and released when everything is invalidated
+    struct FreeDeleter
+    {
+        void operator()(Instruction *entries) const { std::free(entries); }
+    };
+    std::unique_ptr<Instruction[], FreeDeleter> decodeCache;
+
+    // Fault events for the front end
+    FaultRing faults;
+    std::atomic<std::uint64_t> droppedFaults{0};
+
+    // Variant behaviors
+    Quirks quirks;
+
+    // Execution backend
+    Backend backend;
+    std::unique_ptr<ExecutionBackend> blockBackend; // Threaded/JIT/AOT backend state
+    const AotModule *aotModule = nullptr;           // Blocks for the Aot backend
+    bool idleSkipping = true;                       // Skip idle loops in run()
+
+#ifdef CHIP8_PROFILE
+    Profiler *profiler = nullptr; // Attached execution profile
+    void profiledCycle();
+#endif
+
+    friend class AotBackend;
+    friend class ThreadedBackend;
+    friend class JitBackend;
+    friend class LockstepEngine;
+
+    struct Ops; // Decoded instruction handlers (Decoder.cpp)
+
+    // Opcode dispatch for the reference interpreter
+    void executeOpcode(std::uint16_t opcode);
+
     // Opcode handlers
     void executeOpcode0(std::uint16_t opcode);
     void executeOpcode1(std::uint16_t opcode);
@@ -104,8 +688,59 @@ private:
     void executeOpcodeE(std::uint16_t opcode);
     void executeOpcodeF(std::uint16_t opcode);
 
+    // Decode cache maintenance
+    void decodeMiss();
+    void allocateDecodeCache();
+
+    // Queue a fault for the instruction at the program counter
+    void reportFault(Fault type, std::uint16_t address);
+
+    // Report an access of length bytes at address that runs past the end of memory
+    void checkAccess(std::uint16_t address, std::size_t length)
+    {
+        if (address + length > Memory::MEMORY_SIZE)
+        {
+            reportFault(Fault::AddressWrap, address);
+        }
+    }
+
+    // Whether the key numbered by a register is held; only the low nibble selects a key
+    bool isKeyHeld(std::uint8_t key)
+    {
+        if (key >= KEY_COUNT)
+        {
+            reportFault(Fault::KeyIndex, programCounter);
+        }
+        return keys[key & 0xF] != 0;
+    }
+
+    // Bytes a taken skip at address jumps over: F000 NNNN (XO-CHIP) is four bytes long
+    std::uint16_t skipLength(std::uint16_t address) const
+    {
+        return (memory->readByte(address + 2) == 0xF0 && memory->readByte(address + 3) == 0x00) ? 6 : 4;
+    }
+
+    // Apply whole passes of an idle loop at the program counter that fit in
+    // cycles; returns the cycles they stand for, 0 if there is no idle loop
+    std::uint64_t skipIdleLoop(std::uint64_t cycles);
+
+    void invalidateDecodeCache(std::uint16_t address, std::size_t length);
+    void onMemoryWrite(std::uint16_t address, std::size_t length) override;
+
     // Helper functions
     std::uint8_t generateRandomByte();
     void clearDisplay();
+    void clearPlanes(std::uint8_t mask);
+    void setHighResolution(bool enabled);
+    void selectPlanes(std::uint8_t mask);
+    void scrollDown(std::uint8_t rows);
+    void scrollUp(std::uint8_t rows);
+    void scrollRight();
+    void scrollLeft();
+    void saveRange(std::uint8_t x, std::uint8_t y);
+    void loadRange(std::uint8_t x, std::uint8_t y);
+    template <bool CLIP>
     bool drawSprite(std::uint8_t x, std::uint8_t y, std::uint8_t height);
+    template <bool CLIP>
+    bool drawSuperSprite(std::uint8_t x, std::uint8_t y, std::uint8_t height);
 };
\ No newline at end of file
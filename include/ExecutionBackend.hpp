@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+class Analyzer;
+class CPU;
+
+/**
+ * @brief Interface for block-based execution backends
+ *
+ * A backend translates guest code into some faster form and runs it on
+ * behalf of a CPU. Backends must stay cycle-exact with the reference
+ * interpreter: run() executes exactly the requested number of instructions.
+ */
+class ExecutionBackend
+{
+public:
+    virtual ~ExecutionBackend() = default;
+
+    /**
+     * @brief Execute exactly the given number of instructions
+     * @param cpu CPU whose state is executed
+     * @param cycles Number of instructions to execute
+     */
+    virtual void run(CPU &cpu, std::uint64_t cycles) = 0;
+
+    /**
+     * @brief Drop translations that cover a modified range of memory
+     * @param address First modified address
+     * @param length Number of modified bytes
+     */
+    virtual void invalidate(std::uint16_t address, std::size_t length) = 0;
+
+    /**
+     * @brief Translate statically analyzed blocks ahead of execution
+     *
+     * A hint: backends that translate lazily may ignore it, and code the
+     * analysis missed is still translated when it is reached.
+     * @param cpu CPU whose memory and quirks the blocks are translated for
+     * @param analysis Analysis of the program in the CPU's memory
+     */
+    virtual void translate(CPU &cpu, const Analyzer &analysis)
+    {
+        (void)cpu;
+        (void)analysis;
+    }
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include "CPU.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/**
+ * @brief Drains and rate-limits a machine's fault events
+ *
+ * Call drain() from the consumer side of the fault ring, typically at the
+ * end of every frame. Only the first few events per drain, and a bounded
+ * number overall, are printed; the rest are counted, so a ROM that faults
+ * on every instruction cannot flood the log.
+ */
+class FaultLog
+{
+public:
+    static constexpr std::size_t DEFAULT_LINES_PER_DRAIN = 4;
+    static constexpr std::size_t DEFAULT_MAX_LINES = 64;
+
+    /**
+     * @brief Constructor
+     * @param linesPerDrain Events printed per drain() call at most
+     * @param maxLines Events printed over the whole session at most
+     */
+    explicit FaultLog(std::size_t linesPerDrain = DEFAULT_LINES_PER_DRAIN,
+                      std::size_t maxLines = DEFAULT_MAX_LINES);
+
+    /**
+     * @brief Take all pending events off a machine's fault ring
+     * @param cpu Machine whose ring to drain
+     * @param out Where to print events, or nullptr to only count them
+     * @param events Optional list the drained events are appended to
+     */
+    void drain(CPU &cpu, std::ostream *out, std::vector<CPU::FaultEvent> *events = nullptr);
+
+    /**
+     * @brief Print the totals per fault type
+     * @param out Destination stream
+     */
+    void writeSummary(std::ostream &out) const;
+
+    /**
+     * @brief Events drained so far
+     */
+    std::uint64_t getTotal() const { return total; }
+
+    std::uint64_t getCount(CPU::Fault type) const { return counts[static_cast<std::size_t>(type)]; }
+
+    /**
+     * @brief Events lost to a full ring (as of the last drain)
+     */
+    std::uint64_t getDropped() const { return dropped; }
+
+private:
+    static constexpr std::size_t FAULT_TYPES = static_cast<std::size_t>(CPU::Fault::KeyIndex) + 1;
+
+    std::size_t linesPerDrain;
+    std::size_t maxLines;
+    std::size_t lines = 0;       // Events printed so far
+    std::uint64_t total = 0;
+    std::uint64_t dropped = 0;
+    std::array<std::uint64_t, FAULT_TYPES> counts{};
+};
@@ -1,18 +1,29 @@
 #pragma once
 #include "raylib.h"
+#include <array>
 #include <cstdint>
 
 /**
  * @brief Graphics renderer for CHIP-8 emulator
  *
  * Handles rendering the CHIP-8 display buffer to screen using Raylib.
- * Scales the native 64x32 resolution to a larger window size.
+ * Scales the native 64x32 resolution (128x64 in SUPER-CHIP high
+ * resolution) to a fixed window size.
+ *
+ * Each frame the packed display rows are expanded into an RGBA pixel
+ * buffer through a byte-to-8-pixels lookup table and uploaded to the GPU
+ * with a single texture update covering only the active resolution. Rows
+ * with pixels on the second XO-CHIP plane are expanded pixel by pixel
+ * through a four-color palette instead.
  */
 class Graphics
 {
 public:
     static constexpr int CHIP8_WIDTH = 64;
     static constexpr int CHIP8_HEIGHT = 32;
+    static constexpr int MAX_WIDTH = 128; // SUPER-CHIP high resolution
+    static constexpr int MAX_HEIGHT = 64;
+    static constexpr int ROW_WORDS = MAX_WIDTH / 64; // 64-bit words per display row
     static constexpr int SCALE_FACTOR = 10;
     static constexpr int SCREEN_WIDTH = CHIP8_WIDTH * SCALE_FACTOR;
     static constexpr int SCREEN_HEIGHT = CHIP8_HEIGHT * SCALE_FACTOR;
@@ -30,9 +41,10 @@ public:
     /**
      * @brief Initialize graphics system
      * @param windowTitle Window title
+     * @param hidden Create the window hidden (offscreen rendering for benchmarks)
      * @return true if successful
      */
-    bool initialize(const char *windowTitle);
+    bool initialize(const char *windowTitle, bool hidden = false);
 
     /**
      * @brief Shutdown graphics system
@@ -47,9 +59,37 @@ public:
 
     /**
      * @brief Render the display buffer to screen
-     * @param displayBuffer CHIP-8 display buffer (64x32 pixels)
+     * @param displayRows Packed CHIP-8 display rows, ROW_WORDS words per row
+     *                    (bit 63 of the first word = leftmost pixel)
+     * @param width Active width in pixels (64 or 128)
+     * @param height Active height in pixels (32 or 64)
+     * @param secondPlane Rows of the second XO-CHIP plane in the same
+     *                    layout, or nullptr
+     */
+    void render(const std::uint64_t *displayRows, int width = CHIP8_WIDTH, int height = CHIP8_HEIGHT,
+                const std::uint64_t *secondPlane = nullptr);
+
+    /**
+     * @brief Set the colors used for lit and unlit pixels
+     * @param foreground Color of pixels lit on the first plane only
+     * @param background Color of unlit pixels
+     */
+    void setColors(Color foreground, Color background);
+
+    /**
+     * @brief Set the colors of pixels lit on the second XO-CHIP plane
+     * @param second Color of pixels lit on the second plane only
+     * @param both Color of pixels lit on both planes
      */
-    void render(const std::uint8_t *displayBuffer);
+    void setPlaneColors(Color second, Color both);
+
+    /**
+     * @brief Sleep until the next input or window event, without drawing
+     *
+     * For when the shown frame cannot change before the user does
+     * something; the window keeps its last frame.
+     */
+    void waitForEvents();
 
     /**
      * @brief Set target FPS
@@ -58,6 +98,18 @@ public:
     void setTargetFPS(int fps);
 
 private:
-    RenderTexture2D renderTarget;
+    Texture2D screenTexture; // Largest native resolution; the active area is updated every frame
     bool initialized;
+
+    Color foregroundColor;
+    Color backgroundColor;
+
+    // Indexed by plane bits: unlit, first plane, second plane, both
+    std::array<Color, 4> palette;
+
+    // Pixels for every possible display byte, most significant bit first
+    std::array<std::array<Color, 8>, 256> byteToPixels;
+
+    // RGBA staging buffer uploaded to screenTexture, width pixels per row
+    std::array<Color, MAX_WIDTH * MAX_HEIGHT> pixels;
 };
\ No newline at end of file
@@ -11,6 +11,11 @@
  * 4 5 6 D    →      Q W E R
  * 7 8 9 E    →      A S D F
  * A 0 B F    →      Z X C V
+ *
+ * Emulator controls:
+ * Backspace (hold)  →  rewind
+ * Tab (hold)        →  fast-forward
+ * F2                →  toggle slow motion
  */
 class Input
 {
@@ -40,6 +45,22 @@ public:
      */
     bool isKeyPressed(std::uint8_t key) const;
 
+    /**
+     * @brief Check if the rewind key (Backspace) is held
+     * @return true while the emulator should step backwards
+     */
+    bool isRewindHeld() const;
+
+    /**
+     * @brief Check if the fast-forward key (Tab) is held
+     */
+    bool isFastForwardHeld() const;
+
+    /**
+     * @brief Check if the slow motion key (F2) went down since the last poll
+     */
+    bool wasSlowMotionToggled() const;
+
 private:
     std::uint8_t keyStates[KEY_COUNT];
 };
\ No newline at end of file
@@ -0,0 +1,169 @@
+#pragma once
+#include "CPU.hpp"
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Scripted keypad input for unattended runs
+ *
+ * A script is a text file with one line per change of the keypad state:
+ *
+ *     # frame  held keys
+ *     0        -
+ *     120      5
+ *     130      46
+ *
+ * The first column is the emulated frame at which the state takes effect,
+ * the second lists the held keys as hex digits ("-" for none). The state
+ * stays in effect until the next line. Blank lines and text after '#' are
+ * ignored. Lines must be in increasing frame order.
+ *
+ * A script recorded from a session (an input movie) also starts with
+ * directives that pin down everything else a replay depends on:
+ *
+ *     @rom               2f1b1a0c9d8e7f60   # Memory::getROMHash() of the ROM
+ *     @seed              1                  # CXNN random seed
+ *     @random            xorshift           # CXNN generator (xorshift or counter)
+ *     @cycles-per-frame  9
+ *     @quirks            vip                # CPU::parseQuirks() syntax
+ *     @frames            36000              # Length of the session
+ *
+ * Every directive is optional; hand-written scripts usually have none.
+ */
+class InputScript
+{
+public:
+    /**
+     * @brief Load a script from a file
+     * @param path Script file path
+     * @param error Set to a description of the problem on failure
+     * @return true if the script was loaded
+     */
+    bool load(const std::string &path, std::string &error);
+
+    /**
+     * @brief Parse a script from a stream
+     * @param in Script text
+     * @param error Set to a description of the problem on failure
+     * @return true if the script was parsed
+     */
+    bool parse(std::istream &in, std::string &error);
+
+    /**
+     * @brief Held keys at a frame
+     * @param frame Emulated frame number
+     * @return Bit mask of held keys (bit N = key N)
+     */
+    std::uint16_t keyMaskAt(std::uint64_t frame) const;
+
+    /**
+     * @brief Whether the held keys change after a frame
+     * @param frame Emulated frame number
+     * @return false if the state in effect at the frame lasts for good
+     */
+    bool changesAfter(std::uint64_t frame) const { return !events.empty() && events.back().frame > frame; }
+
+    /**
+     * @brief Write the key state for a frame into a CPU keypad array
+     * @param frame Emulated frame number
+     * @param keys Keypad state to update
+     */
+    void apply(std::uint64_t frame, std::array<std::uint8_t, CPU::KEY_COUNT> &keys) const;
+
+    /**
+     * @brief Record the keys held during a frame
+     *
+     * Adds an entry only when the state differs from the one in effect, so
+     * a movie holds one line per change. Frames must not decrease.
+     * @param frame Emulated frame number
+     * @param keyMask Bit mask of held keys (bit N = key N)
+     */
+    void record(std::uint64_t frame, std::uint16_t keyMask);
+
+    /**
+     * @brief Forget every entry from a frame onwards (after a rewind)
+     * @param frame First frame to forget
+     */
+    void truncate(std::uint64_t frame);
+
+    /**
+     * @brief Save the directives and entries to a file
+     * @param path Script file path
+     * @param error Set to a description of the problem on failure
+     * @return true if the script was written
+     */
+    bool save(const std::string &path, std::string &error) const;
+
+    /**
+     * @brief Write the directives and entries in the format parse() reads
+     * @param out Destination stream
+     */
+    void write(std::ostream &out) const;
+
+    /**
+     * @brief Pack a CPU keypad array into a key mask
+     * @param keys Keypad state
+     * @return Bit mask of held keys (bit N = key N)
+     */
+    static std::uint16_t keyMaskOf(const std::array<std::uint8_t, CPU::KEY_COUNT> &keys);
+
+    /**
+     * @brief Unpack a key mask into a CPU keypad array
+     * @param keyMask Bit mask of held keys (bit N = key N)
+     * @param keys Keypad state to overwrite
+     */
+    static void applyKeyMask(std::uint16_t keyMask, std::array<std::uint8_t, CPU::KEY_COUNT> &keys);
+
+    bool empty() const { return events.empty(); }
+
+    bool hasROMHash() const { return romHashSet; }
+    std::uint64_t getROMHash() const { return romHash; }
+    void setROMHash(std::uint64_t hash);
+
+    bool hasSeed() const { return seedSet; }
+    std::uint32_t getSeed() const { return seed; }
+    void setSeed(std::uint32_t value);
+
+    bool hasRandomGenerator() const { return randomGeneratorSet; }
+    CPU::RandomGenerator getRandomGenerator() const { return randomGenerator; }
+    void setRandomGenerator(CPU::RandomGenerator value);
+
+    bool hasQuirks() const { return quirksSet; }
+    CPU::Quirks getQuirks() const { return quirks; }
+    void setQuirks(CPU::Quirks value);
+
+    /// 0 when the script does not say
+    std::uint64_t getCyclesPerFrame() const { return cyclesPerFrame; }
+    void setCyclesPerFrame(std::uint64_t value) { cyclesPerFrame = value; }
+
+    /// 0 when the script does not say
+    std::uint64_t getFrameCount() const { return frameCount; }
+    void setFrameCount(std::uint64_t value) { frameCount = value; }
+
+private:
+    // Keypad state from a frame onwards
+    struct Event
+    {
+        std::uint64_t frame;
+        std::uint16_t keys;
+    };
+
+    std::vector<Event> events; // Sorted by frame
+
+    std::uint64_t romHash = 0;
+    bool romHashSet = false;
+    std::uint32_t seed = CPU::DEFAULT_RANDOM_SEED;
+    bool seedSet = false;
+    CPU::RandomGenerator randomGenerator = CPU::RandomGenerator::Xorshift;
+    bool randomGeneratorSet = false;
+    CPU::Quirks quirks = CPU::QUIRKS_NONE;
+    bool quirksSet = false;
+    std::uint64_t cyclesPerFrame = 0;
+    std::uint64_t frameCount = 0;
+
+    bool parseDirective(std::istream &fields, const std::string &name, std::string &error);
+};
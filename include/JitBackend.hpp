@@ -0,0 +1,107 @@
+#pragma once
+#include "ExecutionBackend.hpp"
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief x86-64 JIT backend for hot basic blocks
+ *
+ * Counts how often execution reaches each address. Once an address is hot,
+ * the basic block starting there is compiled to native x86-64 code. Inside a
+ * compiled block the most used guest registers (V0-VF and I) live in host
+ * registers; they are written back only at block exit and around calls to
+ * helpers (CLS, DXYN, CXNN, FN01, FX33, FX55, FX65, and the fault paths of
+ * CALL, RET, SKP and SKNP). Timers, keys and the stack are accessed in place.
+ * A small native dispatcher runs compiled blocks back to back until the
+ * cycle budget is used up or it reaches code that is not compiled; a block
+ * checks the budget before each instruction and stops early when it runs
+ * out, so execution stays cycle-exact with the reference interpreter.
+ *
+ * Cold code and instructions the compiler does not handle (key waits, the
+ * SUPER-CHIP and XO-CHIP extensions other than FN01, unknown opcodes) run
+ * through the CPU's decoded interpreter. Memory writes drop compiled blocks that overlap the written
+ * range; FX33 and FX55 end their block, so nothing they overwrite runs from
+ * a stale translation. Quirks are resolved while translating, so compiled
+ * code only contains the selected behavior.
+ *
+ * Only available on x86-64 Linux and macOS; see isSupported().
+ */
+class JitBackend : public ExecutionBackend
+{
+public:
+    static constexpr std::size_t MAX_BLOCK_LENGTH = 64;      // Instructions per block
+    static constexpr std::uint16_t HOT_THRESHOLD = 8;        // Visits before compiling
+    static constexpr std::size_t CODE_BUFFER_SIZE = 4 << 20; // Bytes of executable memory
+
+    /**
+     * @brief Constructor - reserves the code buffer
+     */
+    JitBackend();
+
+    /**
+     * @brief Destructor - releases the code buffer
+     */
+    ~JitBackend() override;
+
+    JitBackend(const JitBackend &) = delete;
+    JitBackend &operator=(const JitBackend &) = delete;
+
+    /**
+     * @brief Check whether the JIT can run on this platform
+     * @return true on x86-64 Linux/macOS with executable memory available
+     */
+    static bool isSupported();
+
+    void run(CPU &cpu, std::uint64_t cycles) override;
+    void invalidate(std::uint16_t address, std::size_t length) override;
+
+    /**
+     * @brief Compile the analyzed blocks now instead of once they are hot
+     */
+    void translate(CPU &cpu, const Analyzer &analysis) override;
+
+private:
+    // Per-address translation state; the dispatcher reads it from compiled code
+    struct Entry
+    {
+        const std::uint8_t *function; // Compiled block, or nullptr
+        std::uint16_t length;         // Instructions in the compiled block
+        std::uint16_t hits;           // Visits while cold
+        bool uncompilable;            // First instruction has no native translation
+    };
+
+    std::array<Entry, Memory::MEMORY_SIZE> entries;
+    std::array<bool, Memory::PAGE_COUNT> compiledPages; // Pages with a compile attempt since the last flush
+
+    // Runs compiled blocks from cpu->programCounter; returns the cycles left
+    using Dispatcher = std::uint64_t (*)(CPU *cpu, Entry *entries, std::uint64_t cycles);
+
+    std::uint8_t *code;         // Executable buffer
+    std::size_t codeSize;       // Bytes in use
+    Dispatcher dispatcher;      // At the start of the buffer once built
+    std::size_t dispatcherSize; // Bytes flush() keeps
+
+    bool buildDispatcher(CPU &cpu);
+    void compile(CPU &cpu, std::uint16_t address);
+    void flush();
+    const std::uint8_t *install(const std::vector<std::uint8_t> &bytes);
+    bool setWritable(std::size_t offset, std::size_t size, bool writable);
+
+    // Helpers called from compiled code
+    static void helperClearDisplay(CPU *cpu);
+    template <bool CLIP>
+    static void helperDraw(CPU *cpu, std::uint32_t x, std::uint32_t y, std::uint32_t height);
+    static void helperRandom(CPU *cpu, std::uint32_t x, std::uint32_t mask);
+    static void helperSelectPlanes(CPU *cpu, std::uint32_t mask);
+    static void helperKeyIndex(CPU *cpu);
+    static void helperExecute(CPU *cpu, std::uint32_t opcode);
+    static void helperBcd(CPU *cpu, std::uint32_t x);
+    template <bool INCREMENT>
+    static void helperStore(CPU *cpu, std::uint32_t x);
+    template <bool INCREMENT>
+    static void helperLoad(CPU *cpu, std::uint32_t x);
+};
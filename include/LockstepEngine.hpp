@@ -0,0 +1,152 @@
+#pragma once
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Steps many instances of one ROM in lockstep with SIMD
+ *
+ * Meant for rollout-style workloads where hundreds of machines run the
+ * same program with different inputs or seeds. V0-VF, I, PC and the timers
+ * of all lanes live in structure-of-arrays form. Every step, lanes at the
+ * same PC form a group; register and timer instructions (6XNN, 7XNN, 8XYN,
+ * FX07, FX15, FX18) run for the whole group at once on AVX2 or SSE2
+ * vectors, and jumps, skips, key checks and I updates run in a tight
+ * per-lane loop.
+ *
+ * Everything else (draws, calls, returns, memory access, random numbers,
+ * key waits) runs lane by lane on a per-lane CPU through the reference
+ * interpreter (CPU::interpretCycle), which also owns each lane's memory,
+ * stack, display, keys and random generator. Code that any lane has
+ * written to is always run lane by lane.
+ *
+ * All lanes share one quirk set. The vector path checks it once per
+ * group, not per lane.
+ */
+class LockstepEngine
+{
+public:
+    /**
+     * @brief Constructor
+     * @param lanes Number of machines
+     */
+    explicit LockstepEngine(std::size_t lanes);
+
+    LockstepEngine(const LockstepEngine &) = delete;
+    LockstepEngine &operator=(const LockstepEngine &) = delete;
+
+    std::size_t getLaneCount() const { return laneCount; }
+
+    /**
+     * @brief Reset every lane and load the same ROM into all of them
+     * @param filename Path to the ROM file
+     * @return true if successful
+     */
+    bool loadROM(const char *filename);
+
+    /**
+     * @brief Hash of the loaded ROM (Memory::getROMHash())
+     */
+    std::uint64_t getROMHash() const { return memories.empty() ? 0 : memories[0]->getROMHash(); }
+
+    /**
+     * @brief Seed one lane's random number generator and reset the lane
+     *
+     * Call before loadROM(), which resets all lanes with their seeds.
+     * @param lane Lane index
+     * @param seed Seed value
+     */
+    void setRandomSeed(std::size_t lane, std::uint32_t seed);
+
+    /**
+     * @brief Select the random number generator of every lane and reset them
+     *
+     * Call before loadROM(), like setRandomSeed().
+     * @param generator Generator (CPU::setRandomGenerator())
+     */
+    void setRandomGenerator(CPU::RandomGenerator generator);
+    CPU::RandomGenerator getRandomGenerator() const { return randomGenerator; }
+
+    /**
+     * @brief Select the variant behaviors of every lane (CPU::setQuirks())
+     * @param newQuirks Combination of CPU::QUIRK_* flags
+     */
+    void setQuirks(CPU::Quirks newQuirks);
+    CPU::Quirks getQuirks() const { return quirks; }
+
+    /**
+     * @brief Set the held keys of one lane
+     * @param lane Lane index
+     * @param keyMask Bit N set = key N held
+     */
+    void setKeys(std::size_t lane, std::uint16_t keyMask);
+
+    /**
+     * @brief Execute the given number of cycles on every lane
+     * @param cycles Instructions per lane
+     */
+    void run(std::uint64_t cycles);
+
+    /**
+     * @brief Tick the delay and sound timers of every lane (60Hz)
+     */
+    void updateTimers();
+
+    /**
+     * @brief Full machine state of one lane
+     * @param lane Lane index
+     * @return The lane's CPU, brought up to date with the lane arrays
+     */
+    const CPU &getMachine(std::size_t lane);
+
+private:
+    // Lanes are padded to a multiple of the widest vector
+    static constexpr std::size_t LANE_ALIGNMENT = 32;
+
+    std::size_t laneCount;
+    std::size_t laneCapacity;
+
+    // Structure-of-arrays state, laneCapacity entries per field
+    std::vector<std::uint8_t> registers; // 16 rows of laneCapacity (row X = VX of every lane)
+    std::vector<std::uint16_t> indexRegisters;
+    std::vector<std::uint16_t> programCounters;
+    std::vector<std::uint8_t> delayTimers;
+    std::vector<std::uint8_t> soundTimers;
+    std::vector<std::uint16_t> keyMasks; // Held keys, mirrored in each lane's CPU
+
+    // Per-step grouping of lanes by PC
+    static constexpr std::uint32_t NO_LANE = 0xFFFFFFFF;
+    std::vector<std::uint8_t> groupMask;      // 0xFF for lanes in the current group
+    bool groupMaskFull;                       // groupMask selects every lane
+    std::vector<std::uint32_t> allLanes;      // 0..laneCount-1
+    std::vector<std::uint32_t> groupLanes;    // Lanes in a divergent group
+    std::vector<std::uint32_t> nextInGroup;   // Next lane with the same PC, or NO_LANE
+    std::vector<std::uint32_t> groupHead;     // First lane at each PC, or NO_LANE
+    std::vector<std::uint16_t> activePCs;     // PCs with at least one lane this step
+
+    // Per-lane machines for the scalar path
+    std::vector<std::unique_ptr<Memory>> memories;
+    std::vector<std::unique_ptr<CPU>> machines;
+
+    std::vector<std::uint32_t> seeds; // Random seed of each lane
+    CPU::RandomGenerator randomGenerator = CPU::RandomGenerator::Xorshift; // Generator of every lane
+    CPU::Quirks quirks;               // Variant behaviors of every lane
+
+    // Memory contents shared by all lanes, and addresses any lane has written
+    std::array<std::uint8_t, Memory::MEMORY_SIZE> sharedImage;
+    std::array<bool, Memory::MEMORY_SIZE> written;
+
+    std::uint8_t *row(std::uint8_t x) { return &registers[x * laneCapacity]; }
+
+    void createMachines();
+    void step();
+    void executeGroup(std::uint16_t pc, const std::vector<std::uint32_t> &lanes);
+    void executeVector(const CPU::Instruction &instruction);
+    void executeScalar(std::size_t lane);
+    void storeLane(std::size_t lane);
+    void loadLane(std::size_t lane);
+};
@@ -1,21 +1,58 @@
 #pragma once
 #include <cstdint>
+#include <cstddef>
 #include <array>
+#include <atomic>
 
 /**
  * @brief Memory management class for CHIP-8 emulator
  *
- * Handles the 4KB memory space of the CHIP-8 system, including:
- * - Font data (0x50-0x9F)
- * - Program data (0x200-0xFFF)
- * - Provides read/write operations with bounds checking
+ * Handles the 64KB XO-CHIP memory space, which contains the 4KB of
+ * classic CHIP-8 memory:
+ * - Font data (0x50-0x9F) and the SUPER-CHIP large font (0xA0-0x13F)
+ * - Program data (0x200-0xFFFF)
+ * - Provides read/write operations on 16-bit addresses
+ *
+ * Every 16-bit address is valid, so accesses never branch on bounds and
+ * wrap at 64KB. Programs that run past the end of memory are reported by
+ * the CPU as fault events.
+ *
+ * The contents are held in PAGE_SIZE pages that copies share
+ * copy-on-write: copying a Memory only takes a reference to each page, and
+ * a page is duplicated by the first write to it while it is shared. Pages
+ * that were never written all share one zero page. Reference counts are
+ * atomic, so copies may be used on different threads; a single Memory is
+ * not thread-safe.
  */
 class Memory
 {
 public:
-    static constexpr std::size_t MEMORY_SIZE = 4096;      // 4KB total memory
+    static constexpr std::size_t MEMORY_SIZE = 0x10000;   // 64KB total memory (XO-CHIP)
     static constexpr std::uint16_t FONT_START = 0x50;     // Font data starts here
+    static constexpr std::uint16_t BIG_FONT_START = 0xA0; // 8x10 font data starts here
     static constexpr std::uint16_t PROGRAM_START = 0x200; // Programs start here
+    static constexpr std::uint16_t ADDRESS_MASK = MEMORY_SIZE - 1; // Addresses are 16 bits
+    static constexpr std::size_t PAGE_SIZE = 256;                   // Unit of copy-on-write sharing
+    static constexpr std::size_t PAGE_COUNT = MEMORY_SIZE / PAGE_SIZE;
+
+    /**
+     * @brief Receives notifications when memory contents change
+     *
+     * Used by the CPU to invalidate cached decoded instructions when a ROM
+     * is loaded or a program modifies itself.
+     */
+    class Observer
+    {
+    public:
+        virtual ~Observer() = default;
+
+        /**
+         * @brief Called after a range of memory has been modified
+         * @param address First modified address
+         * @param length Number of modified bytes
+         */
+        virtual void onMemoryWrite(std::uint16_t address, std::size_t length) = 0;
+    };
 
     /**
      * @brief Constructor - initializes memory and loads font data
@@ -23,23 +60,78 @@ public:
     Memory();
 
     /**
-     * @brief Destructor
+     * @brief Copy the contents of another memory, sharing its pages
+     *
+     * The observer is not copied.
+     */
+    Memory(const Memory &other);
+
+    /**
+     * @brief Replace the contents with those of another memory, sharing its pages
+     *
+     * The observer is kept and notified of every page that changed.
      */
-    ~Memory() = default;
+    Memory &operator=(const Memory &other);
+
+    /**
+     * @brief Destructor - releases the pages
+     */
+    ~Memory();
 
     /**
      * @brief Read a byte from memory
      * @param address Memory address to read from
      * @return Byte value at the specified address
      */
-    std::uint8_t readByte(std::uint16_t address) const;
+    std::uint8_t readByte(std::uint16_t address) const { return pages[address / PAGE_SIZE]->bytes[address % PAGE_SIZE]; }
+
+    /**
+     * @brief Read a big-endian 16-bit word (an opcode) from memory
+     *
+     * One page lookup unless the word straddles two pages.
+     * @param address Address of the high byte; the low byte wraps at 64KB
+     * @return Word value at the specified address
+     */
+    std::uint16_t readWord(std::uint16_t address) const
+    {
+        if (address % PAGE_SIZE != PAGE_SIZE - 1)
+        {
+            const std::uint8_t *bytes = &pages[address / PAGE_SIZE]->bytes[address % PAGE_SIZE];
+            return static_cast<std::uint16_t>((bytes[0] << 8) | bytes[1]);
+        }
+        return static_cast<std::uint16_t>((readByte(address) << 8) | readByte(static_cast<std::uint16_t>(address + 1)));
+    }
 
     /**
      * @brief Write a byte to memory
      * @param address Memory address to write to
      * @param value Byte value to write
      */
-    void writeByte(std::uint16_t address, std::uint8_t value);
+    void writeByte(std::uint16_t address, std::uint8_t value)
+    {
+        address &= ADDRESS_MASK;
+        Page *&page = pages[address / PAGE_SIZE];
+        if (page->references.load(std::memory_order_acquire) != 1)
+        {
+            page = makeWritable(address / PAGE_SIZE);
+        }
+        page->bytes[address % PAGE_SIZE] = value;
+        if (observer)
+        {
+            observer->onMemoryWrite(address, 1);
+        }
+    }
+
+    /**
+     * @brief Write consecutive bytes to memory (FX33, FX55, 5XY2 stores)
+     *
+     * Addresses wrap at 64KB like writeByte(). The observer hears about
+     * the whole range once rather than once per byte.
+     * @param address Address of the first byte
+     * @param values Bytes to write
+     * @param count Number of bytes, at most MEMORY_SIZE
+     */
+    void writeBytes(std::uint16_t address, const std::uint8_t *values, std::size_t count);
 
     /**
      * @brief Load ROM file into memory starting at PROGRAM_START
@@ -48,16 +140,101 @@ public:
      */
     bool loadROM(const char *filename);
 
+    /**
+     * @brief Copy a program image into memory starting at PROGRAM_START
+     * @param data Program bytes
+     * @param size Number of bytes
+     * @return true if successful, false if the program does not fit
+     */
+    bool loadProgram(const std::uint8_t *data, std::size_t size);
+
+    /**
+     * @brief Hash of the last loaded ROM or program image
+     * @return 64-bit FNV-1a of the program bytes, 0 if nothing was loaded
+     */
+    std::uint64_t getROMHash() const { return romHash; }
+
+    /**
+     * @brief Size of the last loaded ROM or program image
+     * @return Bytes from PROGRAM_START on, 0 if nothing was loaded
+     */
+    std::size_t getProgramSize() const { return programSize; }
+
+    /**
+     * @brief Copy all of memory into a buffer
+     * @param out Destination of MEMORY_SIZE bytes
+     */
+    void saveState(std::uint8_t *out) const;
+
+    /**
+     * @brief Replace all of memory from a buffer
+     *
+     * Only the range that actually changed is reported to the observer, so
+     * restoring a nearby state keeps most cached translations.
+     * @param in Source of MEMORY_SIZE bytes
+     */
+    void loadState(const std::uint8_t *in);
+
     /**
      * @brief Clear all memory
      */
     void clear();
 
+    /**
+     * @brief Compare memory contents
+     *
+     * Shared pages are equal without looking at their contents.
+     */
+    bool operator==(const Memory &other) const;
+
+    /**
+     * @brief Register the observer notified of memory writes
+     * @param newObserver Observer instance, or nullptr to detach
+     */
+    void setObserver(Observer *newObserver) { observer = newObserver; }
+
 private:
-    std::array<std::uint8_t, MEMORY_SIZE> ram;
+    /**
+     * @brief Reference-counted block of PAGE_SIZE bytes
+     */
+    struct Page
+    {
+        std::atomic<std::uint32_t> references; // Memories holding the page; 0 for the zero page
+        std::array<std::uint8_t, PAGE_SIZE> bytes;
+    };
+
+    static Page zeroPage; // Shared by every page that was never written, never counted
+
+    std::array<Page *, PAGE_COUNT> pages;
+    Observer *observer = nullptr; // Notified of every modification
+    std::uint64_t romHash = 0;    // Identifies the loaded program (for input movies)
+    std::size_t programSize = 0;  // Bytes of the loaded program
+
+    /**
+     * @brief Notify the observer that a range of memory changed
+     */
+    void notifyWrite(std::uint16_t address, std::size_t length);
+
+    /**
+     * @brief Give a page its own copy if it is shared
+     * @param index Page index
+     * @return The page, now held only by this memory
+     */
+    Page *makeWritable(std::size_t index);
+
+    /**
+     * @brief Copy bytes into memory without notifying the observer
+     */
+    void copyIn(std::size_t address, const std::uint8_t *data, std::size_t size);
+
+    /**
+     * @brief Take and drop references to pages
+     */
+    static Page *retain(Page *page);
+    static void release(Page *page);
 
     /**
-     * @brief Load font set into memory
+     * @brief Load the small and large font sets into memory
      */
     void loadFontSet();
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#if defined(__x86_64__) || defined(_M_X64)
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief Execution profile of one machine
+ *
+ * Counts executions and host time per decoded operation (8XY4, FX33, ...),
+ * hits per PC and taken backward jumps, and writes a report with the
+ * opcode mix, the hottest PCs and the hottest loops.
+ *
+ * Only filled in when the core is built with -DCHIP8_PROFILER=ON, which
+ * defines CHIP8_PROFILE; otherwise CPU::setProfiler() refuses the
+ * profiler and the dispatch loops contain no profiling code at all.
+ */
+class Profiler
+{
+public:
+    /**
+     * @brief Totals for one decoded operation
+     */
+    struct OperationStats
+    {
+        std::uint64_t count = 0;
+        std::uint64_t ticks = 0; ///< Host clock ticks spent in the handler
+    };
+
+    Profiler();
+
+    /**
+     * @brief Record one executed instruction
+     * @param pc Address of the instruction
+     * @param op Decoded operation
+     * @param nextPC Program counter after the instruction
+     * @param ticks Host clock ticks spent executing it
+     */
+    void record(std::uint16_t pc, CPU::Operation op, std::uint16_t nextPC, std::uint64_t ticks)
+    {
+        pcHits[pc]++;
+        OperationStats &stats = operations[static_cast<std::size_t>(op)];
+        stats.count++;
+        stats.ticks += ticks > clockOverhead ? ticks - clockOverhead : 0;
+
+        // Backward jumps close loops; calls and returns do not
+        if (nextPC < pc && op != CPU::Operation::Call && op != CPU::Operation::Ret)
+        {
+            backEdges[pc]++;
+            backEdgeTargets[pc] = nextPC;
+        }
+    }
+
+    /**
+     * @brief Read the host clock used for instruction timing
+     * @return Time stamp counter on x86-64, nanoseconds elsewhere
+     */
+    static std::uint64_t readClock()
+    {
+#if defined(__x86_64__) || defined(_M_X64)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                              std::chrono::steady_clock::now().time_since_epoch())
+                                              .count());
+#endif
+    }
+
+    /**
+     * @brief Forget everything recorded so far
+     */
+    void reset();
+
+    /**
+     * @brief Write the report
+     * @param out Destination stream
+     * @param memory Memory of the profiled machine, for the opcodes at hot PCs
+     * @param top Number of hot PCs and loops to list
+     */
+    void writeReport(std::ostream &out, const Memory &memory, std::size_t top = 20) const;
+
+    /**
+     * @brief Write the report to a file ("-" for standard output)
+     * @param path Report path
+     * @param memory Memory of the profiled machine
+     * @param error Set to a description of the problem on failure
+     * @return true if the report was written
+     */
+    bool saveReport(const std::string &path, const Memory &memory, std::string &error) const;
+
+    /**
+     * @brief Name of a decoded operation, e.g. "8XY4 ADD"
+     */
+    static const char *operationName(CPU::Operation op);
+
+    std::uint64_t getInstructionCount() const;
+    const OperationStats &getOperationStats(CPU::Operation op) const
+    {
+        return operations[static_cast<std::size_t>(op)];
+    }
+    const std::array<std::uint64_t, Memory::MEMORY_SIZE> &getPCHits() const { return pcHits; }
+
+private:
+    std::array<OperationStats, static_cast<std::size_t>(CPU::Operation::Count)> operations;
+    std::array<std::uint64_t, Memory::MEMORY_SIZE> pcHits;          // Executions per address (heatmap)
+    std::array<std::uint64_t, Memory::MEMORY_SIZE> backEdges;       // Taken backward jumps per address
+    std::array<std::uint16_t, Memory::MEMORY_SIZE> backEdgeTargets; // Last target of each backward jump
+
+    std::uint64_t clockOverhead; // Ticks measured for back-to-back clock reads
+
+    // Wall clock and host clock at reset(), to convert ticks to time
+    std::chrono::steady_clock::time_point startTime;
+    std::uint64_t startTicks;
+};
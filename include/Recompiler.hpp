@@ -0,0 +1,80 @@
+#pragma once
+#include "Analyzer.hpp"
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Ahead-of-time translation of a program into C++ source
+ *
+ * Turns the basic blocks found by an Analyzer into C++ functions on a
+ * Chip8AotState (see AotAbi.hpp), one per run of instructions with a
+ * native translation, and writes them with their module table. The source
+ * is compiled into a shared object and run by the Aot backend
+ * (CPU::setAotModule()).
+ *
+ * Instructions are translated as the decoded handlers execute them, with
+ * the quirks resolved and the operands, skip lengths and jump targets as
+ * constants. Like the JIT, runs stop before calls, returns, key waits,
+ * memory writes and unknown opcodes, which stay with the interpreter, and
+ * end at jumps and skips.
+ */
+class Recompiler
+{
+public:
+    static constexpr std::size_t MAX_BLOCK_LENGTH = 64; // Instructions per block
+
+    /**
+     * @brief Run of instructions that becomes one function
+     */
+    struct Block
+    {
+        std::uint16_t start;                     // Address of the first instruction
+        std::uint16_t size;                      // Bytes the translation depends on, from start
+        std::vector<std::uint16_t> instructions; // Address of every instruction, in order
+    };
+
+    /**
+     * @brief Plan the blocks of an analyzed program
+     *
+     * Replaces the results of any earlier call.
+     * @param memory Memory holding the analyzed program
+     * @param analysis Analysis of that program
+     * @param quirks Variant to translate for
+     */
+    void recompile(const Memory &memory, const Analyzer &analysis, CPU::Quirks quirks);
+
+    /**
+     * @brief Planned blocks ordered by start address
+     */
+    const std::vector<Block> &getBlocks() const { return blocks; }
+
+    /**
+     * @brief Reachable instructions left to the interpreter
+     */
+    std::size_t getInterpreted() const { return interpreted; }
+
+    /**
+     * @brief Write the module source
+     * @param out Destination
+     * @param memory Memory that was recompiled
+     * @param name Name of the program for the header comment, e.g. the ROM path
+     */
+    void writeSource(std::ostream &out, const Memory &memory, const std::string &name) const;
+
+    /**
+     * @brief Whether an operation has a native translation
+     */
+    static bool isNative(CPU::Operation op);
+
+private:
+    std::vector<Block> blocks;
+    std::size_t interpreted = 0;
+    CPU::Quirks quirks = CPU::QUIRKS_NONE;
+
+    void writeInstruction(std::ostream &out, const Memory &memory, std::uint16_t address) const;
+};
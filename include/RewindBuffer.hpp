@@ -0,0 +1,81 @@
+#pragma once
+#include "CPU.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Frame history for stepping a machine backwards
+ *
+ * Keeps the newest saved state in full and, in a fixed-size ring, one
+ * delta per earlier frame: the XOR of two consecutive states, run-length
+ * encoded. Consecutive frames differ in a few bytes, so each delta is
+ * usually a few dozen bytes and minutes of history fit in a few MB. When
+ * the ring is full the oldest frames are dropped.
+ *
+ * All buffers are allocated by the constructor; push() and rewind() do
+ * not allocate and cost a few passes over one state (about 67KB, most of
+ * it memory, which the delta encoder skips a word at a time).
+ */
+class RewindBuffer
+{
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 4 << 20; // Bytes of delta storage
+
+    /**
+     * @brief Constructor
+     * @param capacity Bytes reserved for deltas
+     */
+    explicit RewindBuffer(std::size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * @brief Record the machine state at the end of a frame
+     * @param cpu Machine to snapshot
+     */
+    void push(const CPU &cpu);
+
+    /**
+     * @brief Step back one frame
+     *
+     * Restores the state recorded before the newest one and forgets the
+     * newest one.
+     * @param cpu Machine to restore
+     * @return false if there is no earlier frame
+     */
+    bool rewind(CPU &cpu);
+
+    /**
+     * @brief Forget all recorded frames
+     */
+    void clear();
+
+    /**
+     * @brief Number of frames rewind() can step back
+     */
+    std::size_t getFrameCount() const { return frameCount; }
+
+    /**
+     * @brief Bytes of delta storage in use
+     */
+    std::size_t getUsedBytes() const { return used; }
+
+private:
+    std::vector<std::uint8_t> ring;    // Delta records, oldest at tail
+    std::size_t head;                  // Offset where the next record starts
+    std::size_t tail;                  // Offset of the oldest record
+    std::size_t used;                  // Bytes between tail and head
+    std::size_t frameCount;            // Records in the ring
+
+    std::vector<std::uint8_t> latest;  // Newest state (valid when hasLatest)
+    std::vector<std::uint8_t> scratch; // State being pushed or rebuilt
+    std::vector<std::uint8_t> encoded; // Delta being written or read
+    bool hasLatest;
+
+    std::size_t encodeDelta(const std::uint8_t *from, const std::uint8_t *to);
+    void applyDelta(const std::uint8_t *delta, std::uint8_t *state) const;
+
+    void writeRing(std::size_t offset, const std::uint8_t *data, std::size_t length);
+    void readRing(std::size_t offset, std::uint8_t *data, std::size_t length) const;
+    std::uint32_t readLength(std::size_t offset) const;
+    void dropOldest();
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+/**
+ * @brief Paces emulation against the host's monotonic clock
+ *
+ * Emulated time advances in frames, one per tick of the 60Hz timers.
+ * Each frame carries instructionsPerSecond / 60 CPU cycles; rates that
+ * are not a multiple of 60 spread the remainder over the frames, so the
+ * long-run rate is exact.
+ *
+ * advance() reports how many frames are due by now. Deadlines are
+ * absolute, so sleep jitter does not accumulate. After a stall (a slow
+ * frame, a debugger, a suspended laptop) at most maxCatchUpFrames are
+ * due; the rest is dropped rather than run in a burst.
+ *
+ * A speed factor scales emulated time: above 1 is fast-forward, below 1
+ * slow motion. Changing it keeps the progress made toward the next frame,
+ * so the switch does not cause a jump.
+ */
+class Scheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::uint32_t TIMER_RATE = 60;                      // Timer ticks (frames) per second
+    static constexpr std::uint32_t DEFAULT_INSTRUCTIONS_PER_SECOND = 540; // 9 per frame
+    static constexpr std::uint32_t MAX_INSTRUCTIONS_PER_SECOND = 60000000;
+    static constexpr std::uint32_t DEFAULT_MAX_CATCH_UP_FRAMES = 5;
+    static constexpr double MIN_SPEED = 1.0 / 16;
+    static constexpr double MAX_SPEED = 64.0;
+
+    explicit Scheduler(std::uint32_t instructionsPerSecond = DEFAULT_INSTRUCTIONS_PER_SECOND);
+
+    /**
+     * @brief Set the emulated CPU rate (clamped to 1..MAX_INSTRUCTIONS_PER_SECOND)
+     */
+    void setInstructionsPerSecond(std::uint32_t rate);
+    std::uint32_t getInstructionsPerSecond() const { return instructionsPerSecond; }
+
+    /**
+     * @brief Whether every frame has the same number of cycles
+     *
+     * Input movies store one cycle count per frame, so they can only be
+     * recorded at such rates.
+     */
+    bool hasWholeCyclesPerFrame() const { return instructionsPerSecond % TIMER_RATE == 0; }
+
+    /**
+     * @brief Set the emulation speed relative to real time
+     * @param factor 1 = real time, clamped to MIN_SPEED..MAX_SPEED
+     * @param now Current time, the new deadlines are counted from it
+     */
+    void setSpeed(double factor, Clock::time_point now);
+    double getSpeed() const { return speed; }
+
+    /**
+     * @brief Set how many overdue frames advance() reports at most
+     */
+    void setMaxCatchUpFrames(std::uint32_t frames) { maxCatchUpFrames = frames ? frames : 1; }
+
+    /**
+     * @brief Start the clock; the first frame is due one period after now
+     */
+    void start(Clock::time_point now);
+
+    /**
+     * @brief Frames due by now
+     *
+     * Consumes them: call nextFrameCycles() once per returned frame.
+     * Frames beyond the catch-up limit are dropped and counted.
+     */
+    std::uint32_t advance(Clock::time_point now);
+
+    /**
+     * @brief CPU cycles to run in the next frame
+     */
+    std::uint64_t nextFrameCycles();
+
+    /**
+     * @brief When the next frame is due
+     */
+    Clock::time_point nextDeadline() const { return origin + framePeriod(framesSinceOrigin + 1); }
+
+    /**
+     * @brief Frames dropped by the catch-up limit so far
+     */
+    std::uint64_t getDroppedFrames() const { return droppedFrames; }
+
+private:
+    std::uint32_t instructionsPerSecond;
+    std::uint32_t cycleRemainder = 0; // Cycles owed to later frames, times TIMER_RATE
+    double speed = 1.0;
+    std::uint32_t maxCatchUpFrames = DEFAULT_MAX_CATCH_UP_FRAMES;
+
+    Clock::time_point origin;            // Deadlines are counted from here
+    std::uint64_t framesSinceOrigin = 0; // Frames handed out since origin
+    std::uint64_t droppedFrames = 0;
+
+    // Real time taken by the first `frames` frames after origin at the current speed
+    Clock::duration framePeriod(std::uint64_t frames) const;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Per-ROM emulation speeds
+ *
+ * A text file with one ROM per line, identified by Memory::getROMHash():
+ *
+ *     # rom hash          instructions per second
+ *     2f1b1a0c9d8e7f60    1000
+ *     91c2f0e8d7a6b5c4    30000   # XO-CHIP game
+ *
+ * Blank lines and text after '#' are ignored. chip8_headless prints the
+ * hash of any ROM (rom_hash), so entries can be added for new ROMs.
+ */
+class SpeedTable
+{
+public:
+    /**
+     * @brief Load a table from a file
+     * @param path File path
+     * @param error Set to a description of the problem on failure
+     * @return true if the file was read and every line parsed
+     */
+    bool load(const std::string &path, std::string &error);
+
+    /**
+     * @brief Load a table from a stream
+     * @param in Source stream
+     * @param error Set to a description of the problem on failure
+     * @return true if every line parsed
+     */
+    bool parse(std::istream &in, std::string &error);
+
+    /**
+     * @brief Speed configured for a ROM
+     * @param romHash Memory::getROMHash() of the ROM
+     * @param instructionsPerSecond Set to the configured rate when found
+     * @return false if the table has no entry for the ROM
+     */
+    bool lookup(std::uint64_t romHash, std::uint32_t &instructionsPerSecond) const;
+
+    bool empty() const { return speeds.empty(); }
+
+private:
+    std::unordered_map<std::uint64_t, std::uint32_t> speeds;
+};
@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Fixed-size lock-free queue for one producer and one consumer
+ *
+ * The producer only writes head and the consumer only writes tail, so
+ * neither side ever waits or takes a lock, and nothing is allocated after
+ * construction. When the ring is full tryPush() fails and the caller
+ * decides what to drop.
+ *
+ * @tparam T Element type (copied in and out)
+ * @tparam N Capacity, a power of two
+ */
+template <typename T, std::size_t N>
+class SpscRing
+{
+    static_assert(N != 0 && (N & (N - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    static constexpr std::size_t CAPACITY = N;
+
+    /**
+     * @brief Append an element (producer side)
+     * @return false if the ring is full
+     */
+    bool tryPush(const T &item)
+    {
+        const std::size_t position = head.load(std::memory_order_relaxed);
+        if (position - tail.load(std::memory_order_acquire) == N)
+        {
+            return false;
+        }
+        slots[position & (N - 1)] = item;
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest element (consumer side)
+     * @return false if the ring is empty
+     */
+    bool tryPop(T &item)
+    {
+        const std::size_t position = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == position)
+        {
+            return false;
+        }
+        item = slots[position & (N - 1)];
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Append as many elements as fit (producer side)
+     * @return Number of elements appended, the rest are not queued
+     */
+    std::size_t push(const T *items, std::size_t count)
+    {
+        const std::size_t position = head.load(std::memory_order_relaxed);
+        const std::size_t space = N - (position - tail.load(std::memory_order_acquire));
+        count = count < space ? count : space;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            slots[(position + i) & (N - 1)] = items[i];
+        }
+        head.store(position + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Remove up to count of the oldest elements (consumer side)
+     * @return Number of elements removed
+     */
+    std::size_t pop(T *items, std::size_t count)
+    {
+        const std::size_t position = tail.load(std::memory_order_relaxed);
+        const std::size_t available = head.load(std::memory_order_acquire) - position;
+        count = count < available ? count : available;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            items[i] = slots[(position + i) & (N - 1)];
+        }
+        tail.store(position + count, std::memory_order_release);
+        return count;
+    }
+
+    /**
+     * @brief Discard every queued element (consumer side)
+     */
+    void clear()
+    {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /**
+     * @brief Number of queued elements (exact only on the calling side)
+     */
+    std::size_t size() const
+    {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    // Each index on its own cache line so the two sides do not share one
+    alignas(64) std::atomic<std::size_t> head{0}; // Next slot to fill (producer)
+    alignas(64) std::atomic<std::size_t> tail{0}; // Next slot to read (consumer)
+    std::array<T, N> slots;
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include "ExecutionBackend.hpp"
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Basic-block threaded-code backend
+ *
+ * Splits the program into straight-line basic blocks that end at a control
+ * flow instruction (1NNN, 2NNN, 00EE, BNNN, skips), a key wait (FX0A) or a
+ * memory write (FX33, FX55). Each block is translated once into a list of
+ * threaded operations that jump directly from one handler to the next
+ * (computed goto where the compiler supports it), so there is no fetch or
+ * decode per instruction. Jumps, calls, returns and skips are part of the
+ * threaded code; the remaining terminators (key wait, memory writes,
+ * unknown opcodes) run through their decoded handler.
+ *
+ * Blocks only run when the remaining cycle budget covers the whole block;
+ * otherwise the CPU single-steps, so execution stays cycle-exact.
+ *
+ * The dispatch loop is instantiated once per quirk combination and run()
+ * picks the one matching the CPU, so quirks cost nothing per instruction.
+ */
+class ThreadedBackend : public ExecutionBackend
+{
+public:
+    static constexpr std::size_t MAX_BLOCK_LENGTH = 64; // Instructions per block
+
+    void run(CPU &cpu, std::uint64_t cycles) override;
+    void invalidate(std::uint16_t address, std::size_t length) override;
+
+    /**
+     * @brief Queue the analyzed blocks for translation
+     *
+     * The blocks are translated at the start of the next run(), where the
+     * handler labels are known.
+     */
+    void translate(CPU &cpu, const Analyzer &analysis) override;
+
+private:
+    // One translated instruction in a block body
+    struct ThreadedOp
+    {
+        const void *target;   // Handler label (computed goto dispatch)
+        CPU::Operation op;    // Operation (switch dispatch)
+        std::uint8_t x;       // Register index X
+        std::uint8_t y;       // Register index Y
+        std::uint8_t n;       // 4-bit immediate
+        std::uint8_t nn;      // 8-bit immediate
+        std::uint16_t nnn;    // 12-bit address
+        std::uint16_t address; // Address of the instruction itself
+        std::uint8_t skip;    // Bytes a taken skip jumps (6 over F000 NNNN)
+    };
+
+    // Translated basic block
+    struct Block
+    {
+        std::uint16_t start;          // Address of the first instruction
+        std::uint16_t length;         // Instructions in the block, terminator included
+        std::uint16_t lastOpcode;     // Opcode of the last instruction
+        bool hasHandler;              // Terminator runs through its decoded handler
+        CPU::Instruction terminator;  // Decoded terminator (when hasHandler)
+        std::vector<ThreadedOp> ops;  // Threaded code, ends with a terminator or END_OF_BLOCK
+    };
+
+    // Ends a block that falls through to the next address; nnn holds that address
+    static constexpr CPU::Operation END_OF_BLOCK = CPU::Operation::Count;
+
+    std::array<std::unique_ptr<Block>, Memory::MEMORY_SIZE> blocks; // Indexed by start address
+    std::array<bool, Memory::PAGE_COUNT> translatedPages{};         // Pages where a block was ever translated
+    std::vector<std::vector<std::uint16_t>> pending; // Instruction addresses of analyzed blocks to translate
+
+    template <CPU::Quirks Q>
+    void runQuirks(CPU &cpu, std::uint64_t cycles);
+
+    using Runner = void (ThreadedBackend::*)(CPU &cpu, std::uint64_t cycles);
+    template <std::size_t... Q>
+    static constexpr std::array<Runner, sizeof...(Q)> makeRunners(std::index_sequence<Q...>)
+    {
+        return {{&ThreadedBackend::runQuirks<static_cast<CPU::Quirks>(Q)>...}};
+    }
+
+    Block *compile(CPU &cpu, std::uint16_t address, const void *const *labels);
+    void compilePending(CPU &cpu, const void *const *labels);
+    static bool isBodyOperation(CPU::Operation op);
+    static bool isThreadedTerminator(CPU::Operation op);
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free hand-over of the latest value from one thread to another
+ *
+ * The producer fills the write slot and publish()es it; the consumer
+ * update()s to the newest published slot and reads it for as long as it
+ * likes. The third slot sits in the middle, so neither side ever waits for
+ * the other. Values the consumer did not pick up in time are overwritten
+ * by newer ones, which is what a display wants from an emulator.
+ *
+ * @tparam T Slot type, written in place (no copies on hand-over)
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    /**
+     * @brief Slot to fill before the next publish() (producer side)
+     */
+    T &writeBuffer() { return slots[writeIndex]; }
+
+    /**
+     * @brief Hand the write slot to the consumer (producer side)
+     */
+    void publish()
+    {
+        const std::uint8_t previous = middle.exchange(static_cast<std::uint8_t>(writeIndex | FRESH),
+                                                      std::memory_order_acq_rel);
+        writeIndex = previous & INDEX_MASK;
+    }
+
+    /**
+     * @brief Switch to the newest published slot (consumer side)
+     * @return false if nothing was published since the last update()
+     */
+    bool update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+        {
+            return false;
+        }
+        const std::uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief Slot picked up by the last update() (consumer side)
+     */
+    const T &readBuffer() const { return slots[readIndex]; }
+
+private:
+    static constexpr std::uint8_t INDEX_MASK = 3;
+    static constexpr std::uint8_t FRESH = 4; // Middle slot holds a value not yet read
+
+    std::array<T, 3> slots{};
+    // Each side's index on its own cache line, apart from the shared one
+    alignas(64) std::atomic<std::uint8_t> middle{1};
+    alignas(64) std::uint8_t writeIndex = 0; // Producer only
+    alignas(64) std::uint8_t readIndex = 2;  // Consumer only
+};
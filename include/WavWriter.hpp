@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/**
+ * @brief Writes 16-bit mono PCM samples to a WAV file
+ *
+ * The header is written with placeholder sizes by open() and completed
+ * by close(), so samples can be streamed in as they are produced.
+ */
+class WavWriter
+{
+public:
+    WavWriter() = default;
+    ~WavWriter();
+
+    WavWriter(const WavWriter &) = delete;
+    WavWriter &operator=(const WavWriter &) = delete;
+
+    /**
+     * @brief Create the file and write the header
+     * @param path File path
+     * @param rate Samples per second
+     * @param error Set to a description of the problem on failure
+     * @return true if the file was created
+     */
+    bool open(const std::string &path, unsigned rate, std::string &error);
+
+    /**
+     * @brief Append samples
+     */
+    void write(const std::int16_t *samples, std::size_t count);
+
+    /**
+     * @brief Fill in the header sizes and close the file
+     * @param error Set to a description of the problem on failure
+     * @return true if everything was written
+     */
+    bool close(std::string &error);
+
+    bool isOpen() const { return file.is_open(); }
+
+    /**
+     * @brief Samples written so far
+     */
+    std::uint64_t getSampleCount() const { return sampleCount; }
+
+private:
+    std::ofstream file;
+    std::string path;
+    unsigned sampleRate = 0;
+    std::uint64_t sampleCount = 0;
+};
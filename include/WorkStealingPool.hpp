@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Work-stealing pool for running independent tasks in parallel
+ *
+ * Tasks are numbered 0..count-1 and dealt round-robin to per-worker
+ * queues. A worker takes tasks from the back of its own queue and, once
+ * that is empty, steals from the front of the other queues, so long tasks
+ * on one worker do not leave the others idle.
+ */
+class WorkStealingPool
+{
+public:
+    /**
+     * @brief Constructor
+     * @param threads Number of workers, 0 to use one per hardware thread
+     */
+    explicit WorkStealingPool(std::size_t threads = 0);
+
+    std::size_t getThreadCount() const { return threadCount; }
+
+    /**
+     * @brief Run tasks and wait for all of them to finish
+     *
+     * If a task throws, the remaining tasks still run and the first
+     * exception is rethrown afterwards.
+     * @param count Number of tasks
+     * @param task Called once with each task index, from any worker
+     */
+    void run(std::size_t count, const std::function<void(std::size_t)> &task);
+
+private:
+    // Task queue owned by one worker
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    std::size_t threadCount;
+
+    static bool popOwn(Queue &queue, std::size_t &task);
+    static bool steal(Queue &queue, std::size_t &task);
+};
@@ -0,0 +1,578 @@
+#include "Analyzer.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    using Op = CPU::Operation;
+
+    // How an instruction passes control on
+    struct Flow
+    {
+        bool fallsThrough;        // Continues with the next instruction
+        std::uint32_t targets[2]; // Other addresses execution continues at
+        std::size_t targetCount;
+    };
+
+    Op operationAt(const Memory &memory, std::uint16_t address)
+    {
+        return CPU::decode(memory.readWord(address)).op;
+    }
+
+    Flow flowOf(const Memory &memory, std::uint16_t address)
+    {
+        const CPU::Instruction instruction = CPU::decode(memory.readWord(address));
+        const std::uint32_t next = static_cast<std::uint32_t>(address) + 2;
+        switch (instruction.op)
+        {
+        case Op::Jp:
+            return {false, {instruction.nnn, 0}, 1};
+        case Op::Call:
+            return {false, {instruction.nnn, next}, 2};
+        case Op::SeImm:
+        case Op::SneImm:
+        case Op::SeReg:
+        case Op::SneReg:
+        case Op::Skp:
+        case Op::Sknp:
+        {
+            // A taken skip also jumps over both words of F000 NNNN
+            const std::uint32_t skipped = next + (memory.readWord(static_cast<std::uint16_t>(next)) == 0xF000 ? 4 : 2);
+            return {false, {next, skipped}, 2};
+        }
+        case Op::Ret:
+        case Op::Exit:
+        case Op::JpV0:
+        case Op::Fallback:
+            return {false, {0, 0}, 0};
+        default:
+            return {true, {0, 0}, 0};
+        }
+    }
+
+    std::string hex(std::uint32_t value, int digits)
+    {
+        std::ostringstream text;
+        text << "0x" << std::uppercase << std::hex << std::setfill('0') << std::setw(digits) << value;
+        return text.str();
+    }
+
+    std::string reg(std::uint8_t index)
+    {
+        return "V" + std::string(1, "0123456789ABCDEF"[index & 0xF]);
+    }
+
+    std::string jsonString(const std::string &text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+}
+
+void Analyzer::analyze(const Memory &memory, CPU::Quirks quirks)
+{
+    flags.fill(0);
+    blocks.clear();
+    stores.clear();
+    dataRegions.clear();
+    invalid.clear();
+    codeBytes = 0;
+
+    traceCode(memory);
+    buildBlocks(memory);
+    findStores(memory, quirks);
+    findDataRegions(memory);
+}
+
+bool Analyzer::isSelfModifying() const
+{
+    return std::any_of(stores.begin(), stores.end(), [](const Store &store) { return store.modifiesCode; });
+}
+
+std::uint16_t Analyzer::instructionLength(const Memory &memory, std::uint16_t address)
+{
+    return operationAt(memory, address) == Op::LdILong ? 4 : 2;
+}
+
+void Analyzer::traceCode(const Memory &memory)
+{
+    std::vector<std::uint16_t> work;
+    auto addLeader = [this, &work](std::uint32_t address)
+    {
+        // The last address cannot hold a complete instruction
+        if (address < Memory::MEMORY_SIZE - 1 && !(flags[address] & LEADER))
+        {
+            flags[address] |= LEADER;
+            work.push_back(static_cast<std::uint16_t>(address));
+        }
+    };
+    addLeader(Memory::PROGRAM_START);
+
+    // Follow each path until it leaves straight-line code or joins one
+    // already traced
+    while (!work.empty())
+    {
+        std::uint32_t address = work.back();
+        work.pop_back();
+        while (address < Memory::MEMORY_SIZE - 1 && !(flags[address] & INSTRUCTION))
+        {
+            const std::uint16_t pc = static_cast<std::uint16_t>(address);
+            const std::uint16_t length = instructionLength(memory, pc);
+            if (address + length > Memory::MEMORY_SIZE)
+            {
+                break;
+            }
+
+            flags[pc] |= INSTRUCTION;
+            for (std::uint16_t i = 0; i < length; ++i)
+            {
+                flags[pc + i] |= CODE;
+            }
+            if (operationAt(memory, pc) == Op::Fallback)
+            {
+                invalid.push_back(pc);
+            }
+
+            const Flow flow = flowOf(memory, pc);
+            for (std::size_t i = 0; i < flow.targetCount; ++i)
+            {
+                addLeader(flow.targets[i]);
+            }
+            if (!flow.fallsThrough)
+            {
+                break;
+            }
+            address += length;
+        }
+    }
+
+    std::sort(invalid.begin(), invalid.end());
+    codeBytes = static_cast<std::size_t>(std::count_if(flags.begin(), flags.end(),
+                                                       [](std::uint8_t f) { return (f & CODE) != 0; }));
+}
+
+void Analyzer::buildBlocks(const Memory &memory)
+{
+    for (std::uint32_t start = 0; start < Memory::MEMORY_SIZE; ++start)
+    {
+        if ((flags[start] & (LEADER | INSTRUCTION)) != (LEADER | INSTRUCTION))
+        {
+            continue;
+        }
+
+        Block block{static_cast<std::uint16_t>(start), start, {}, {}, false, false, false};
+        std::uint32_t pc = start;
+        for (;;)
+        {
+            const std::uint16_t address = static_cast<std::uint16_t>(pc);
+            block.instructions.push_back(address);
+            const std::uint32_t next = pc + instructionLength(memory, address);
+            block.end = next;
+
+            const Flow flow = flowOf(memory, address);
+            if (!flow.fallsThrough)
+            {
+                const CPU::Instruction instruction = CPU::decode(memory.readWord(address));
+                for (std::size_t i = 0; i < flow.targetCount; ++i)
+                {
+                    if (flow.targets[i] < Memory::MEMORY_SIZE - 1)
+                    {
+                        block.successors.push_back(static_cast<std::uint16_t>(flow.targets[i]));
+                    }
+                }
+                block.returns = instruction.op == Op::Ret;
+                block.indirect = instruction.op == Op::JpV0;
+                block.halts = instruction.op == Op::Exit || (instruction.op == Op::Jp && instruction.nnn == address);
+                break;
+            }
+
+            // Straight-line code ends where another block starts or the path ran off memory
+            if (next >= Memory::MEMORY_SIZE - 1 || !(flags[next] & INSTRUCTION))
+            {
+                break;
+            }
+            if (flags[next] & LEADER)
+            {
+                block.successors.push_back(static_cast<std::uint16_t>(next));
+                break;
+            }
+            pc = next;
+        }
+        blocks.push_back(std::move(block));
+    }
+}
+
+void Analyzer::findStores(const Memory &memory, CPU::Quirks quirks)
+{
+    // Track I through each block from the loads that set it to a constant
+    for (const Block &block : blocks)
+    {
+        bool known = false;
+        std::uint32_t index = 0;
+        for (std::uint16_t address : block.instructions)
+        {
+            const CPU::Instruction instruction = CPU::decode(memory.readWord(address), quirks);
+            std::uint32_t written = 0;
+            switch (instruction.op)
+            {
+            case Op::LdI:
+                index = instruction.nnn;
+                known = true;
+                break;
+            case Op::LdILong:
+                index = memory.readWord(static_cast<std::uint16_t>(address + 2));
+                known = true;
+                break;
+            case Op::AddI:
+            case Op::LdFont:
+            case Op::LdBigFont:
+                known = false;
+                break;
+            case Op::Load:
+                if (quirks & CPU::QUIRK_INCREMENT_I)
+                {
+                    index += instruction.x + 1u;
+                }
+                break;
+            case Op::Store:
+                written = instruction.x + 1u;
+                break;
+            case Op::Bcd:
+                written = 3;
+                break;
+            case Op::SaveRange:
+                written = (instruction.x > instruction.y ? instruction.x - instruction.y : instruction.y - instruction.x) + 1u;
+                break;
+            default:
+                break;
+            }
+
+            if (written == 0)
+            {
+                continue;
+            }
+
+            Store store{address, known, 0, 0, false};
+            if (known)
+            {
+                store.first = static_cast<std::uint16_t>(index & Memory::ADDRESS_MASK);
+                store.last = static_cast<std::uint16_t>(std::min<std::uint32_t>(store.first + written - 1, Memory::ADDRESS_MASK));
+                for (std::uint32_t target = store.first; target <= store.last; ++target)
+                {
+                    store.modifiesCode = store.modifiesCode || (flags[target] & CODE) != 0;
+                }
+            }
+            stores.push_back(store);
+
+            if (instruction.op == Op::Store && (quirks & CPU::QUIRK_INCREMENT_I))
+            {
+                index += written;
+            }
+        }
+    }
+
+    std::sort(stores.begin(), stores.end(), [](const Store &a, const Store &b) { return a.address < b.address; });
+}
+
+void Analyzer::findDataRegions(const Memory &memory)
+{
+    const std::uint32_t end = static_cast<std::uint32_t>(
+        std::min<std::size_t>(Memory::PROGRAM_START + memory.getProgramSize(), Memory::MEMORY_SIZE));
+    std::uint32_t address = Memory::PROGRAM_START;
+    while (address < end)
+    {
+        if (flags[address] & CODE)
+        {
+            ++address;
+            continue;
+        }
+
+        const std::uint32_t start = address;
+        while (address < end && !(flags[address] & CODE))
+        {
+            ++address;
+        }
+        dataRegions.push_back({static_cast<std::uint16_t>(start), address});
+    }
+}
+
+std::string Analyzer::disassemble(const Memory &memory, std::uint16_t address)
+{
+    const CPU::Instruction in = CPU::decode(memory.readWord(address));
+    const std::string x = reg(in.x);
+    const std::string y = reg(in.y);
+    switch (in.op)
+    {
+    case Op::Cls:
+        return "CLS";
+    case Op::Ret:
+        return "RET";
+    case Op::Jp:
+        return "JP " + hex(in.nnn, 3);
+    case Op::Call:
+        return "CALL " + hex(in.nnn, 3);
+    case Op::SeImm:
+        return "SE " + x + ", " + hex(in.nn, 2);
+    case Op::SneImm:
+        return "SNE " + x + ", " + hex(in.nn, 2);
+    case Op::SeReg:
+        return "SE " + x + ", " + y;
+    case Op::LdImm:
+        return "LD " + x + ", " + hex(in.nn, 2);
+    case Op::AddImm:
+        return "ADD " + x + ", " + hex(in.nn, 2);
+    case Op::LdReg:
+        return "LD " + x + ", " + y;
+    case Op::OrReg:
+        return "OR " + x + ", " + y;
+    case Op::AndReg:
+        return "AND " + x + ", " + y;
+    case Op::XorReg:
+        return "XOR " + x + ", " + y;
+    case Op::AddReg:
+        return "ADD " + x + ", " + y;
+    case Op::SubReg:
+        return "SUB " + x + ", " + y;
+    case Op::Shr:
+        return "SHR " + x + ", " + y;
+    case Op::Subn:
+        return "SUBN " + x + ", " + y;
+    case Op::Shl:
+        return "SHL " + x + ", " + y;
+    case Op::SneReg:
+        return "SNE " + x + ", " + y;
+    case Op::LdI:
+        return "LD I, " + hex(in.nnn, 3);
+    case Op::JpV0:
+        return "JP V0, " + hex(in.nnn, 3);
+    case Op::Rnd:
+        return "RND " + x + ", " + hex(in.nn, 2);
+    case Op::Drw:
+        return "DRW " + x + ", " + y + ", " + std::to_string(in.n);
+    case Op::Skp:
+        return "SKP " + x;
+    case Op::Sknp:
+        return "SKNP " + x;
+    case Op::LdVxDt:
+        return "LD " + x + ", DT";
+    case Op::LdKey:
+        return "LD " + x + ", K";
+    case Op::LdDtVx:
+        return "LD DT, " + x;
+    case Op::LdStVx:
+        return "LD ST, " + x;
+    case Op::AddI:
+        return "ADD I, " + x;
+    case Op::LdFont:
+        return "LD F, " + x;
+    case Op::Bcd:
+        return "LD B, " + x;
+    case Op::Store:
+        return "LD [I], " + x;
+    case Op::Load:
+        return "LD " + x + ", [I]";
+    case Op::ScrollDown:
+        return "SCD " + std::to_string(in.n);
+    case Op::ScrollRight:
+        return "SCR";
+    case Op::ScrollLeft:
+        return "SCL";
+    case Op::Exit:
+        return "EXIT";
+    case Op::Lores:
+        return "LOW";
+    case Op::Hires:
+        return "HIGH";
+    case Op::LdBigFont:
+        return "LD HF, " + x;
+    case Op::StoreFlags:
+        return "LD R, " + x;
+    case Op::LoadFlags:
+        return "LD " + x + ", R";
+    case Op::ScrollUp:
+        return "SCU " + std::to_string(in.n);
+    case Op::SaveRange:
+        return "SAVE " + x + "-" + y;
+    case Op::LoadRange:
+        return "LOAD " + x + "-" + y;
+    case Op::LdILong:
+        return "LD I, " + hex(memory.readWord(static_cast<std::uint16_t>(address + 2)), 4);
+    case Op::Plane:
+        return "PLANE " + std::to_string(in.x);
+    case Op::Audio:
+        return "AUDIO";
+    case Op::Pitch:
+        return "PITCH " + x;
+    default:
+        return "DW " + hex(in.opcode, 4);
+    }
+}
+
+void Analyzer::writeText(std::ostream &out, const Memory &memory, const std::string &name) const
+{
+    std::size_t instructions = 0;
+    std::size_t indirect = 0;
+    for (const Block &block : blocks)
+    {
+        instructions += block.instructions.size();
+        indirect += block.indirect ? 1 : 0;
+    }
+    std::size_t dataBytes = 0;
+    for (const Range &range : dataRegions)
+    {
+        dataBytes += range.end - range.start;
+    }
+    const std::size_t unresolved = static_cast<std::size_t>(
+        std::count_if(stores.begin(), stores.end(), [](const Store &store) { return !store.resolved; }));
+
+    out << "; " << name << "\n"
+        << "; program: " << memory.getProgramSize() << " bytes at " << hex(Memory::PROGRAM_START, 3)
+        << ", rom hash " << std::hex << std::setfill('0') << std::setw(16) << memory.getROMHash()
+        << std::dec << std::setfill(' ') << "\n"
+        << "; code: " << instructions << " instructions, " << blocks.size() << " blocks, "
+        << codeBytes << " bytes\n"
+        << "; data: " << dataRegions.size() << " regions, " << dataBytes << " bytes\n"
+        << "; indirect jumps: " << indirect << "\n"
+        << "; stores: " << stores.size() << ", unresolved: " << unresolved << "\n";
+    for (const Store &store : stores)
+    {
+        if (store.modifiesCode)
+        {
+            out << "; self-modifying: " << hex(store.address, 3) << " writes " << hex(store.first, 3)
+                << "-" << hex(store.last, 3) << "\n";
+        }
+    }
+    for (std::uint16_t address : invalid)
+    {
+        out << "; invalid: " << hex(address, 3) << " " << disassemble(memory, address) << "\n";
+    }
+
+    // Blocks and data regions in address order
+    auto nextBlock = blocks.begin();
+    auto nextData = dataRegions.begin();
+    while (nextBlock != blocks.end() || nextData != dataRegions.end())
+    {
+        out << "\n";
+        if (nextData == dataRegions.end() || (nextBlock != blocks.end() && nextBlock->start < nextData->start))
+        {
+            const Block &block = *nextBlock++;
+            out << "block " << hex(block.start, 3) << "-" << hex(block.end, 3);
+            if (block.returns)
+            {
+                out << " -> return";
+            }
+            else if (block.indirect)
+            {
+                out << " -> indirect";
+            }
+            else if (!block.successors.empty())
+            {
+                out << " ->";
+                for (std::size_t i = 0; i < block.successors.size(); ++i)
+                {
+                    out << (i ? ", " : " ") << hex(block.successors[i], 3);
+                }
+            }
+            out << (block.halts ? " (halts)" : "") << "\n";
+
+            for (std::uint16_t address : block.instructions)
+            {
+                out << "  " << std::uppercase << std::hex << std::setfill('0') << std::setw(4) << address
+                    << "  " << std::setw(4) << memory.readWord(address) << std::nouppercase << std::dec
+                    << std::setfill(' ') << "  " << disassemble(memory, address);
+
+                const auto store = std::lower_bound(stores.begin(), stores.end(), address,
+                                                    [](const Store &s, std::uint16_t a) { return s.address < a; });
+                if (store != stores.end() && store->address == address && store->modifiesCode)
+                {
+                    out << "  ; modifies code at " << hex(store->first, 3) << "-" << hex(store->last, 3);
+                }
+                out << "\n";
+            }
+        }
+        else
+        {
+            const Range &range = *nextData++;
+            out << "data " << hex(range.start, 3) << "-" << hex(range.end, 3) << " ("
+                << range.end - range.start << " bytes)\n";
+            for (std::uint32_t line = range.start; line < range.end; line += 8)
+            {
+                out << "  " << std::uppercase << std::hex << std::setfill('0') << std::setw(4) << line << " ";
+                for (std::uint32_t address = line; address < std::min(line + 8, range.end); ++address)
+                {
+                    out << " " << std::setw(2) << static_cast<int>(memory.readByte(static_cast<std::uint16_t>(address)));
+                }
+                out << std::nouppercase << std::dec << std::setfill(' ') << "\n";
+            }
+        }
+    }
+}
+
+void Analyzer::writeJson(std::ostream &out, const Memory &memory, const std::string &name) const
+{
+    std::ostringstream hash;
+    hash << std::hex << std::setfill('0') << std::setw(16) << memory.getROMHash();
+
+    out << "{\n"
+        << "  \"name\": " << jsonString(name) << ",\n"
+        << "  \"program_start\": " << Memory::PROGRAM_START << ",\n"
+        << "  \"program_size\": " << memory.getProgramSize() << ",\n"
+        << "  \"rom_hash\": " << jsonString(hash.str()) << ",\n"
+        << "  \"code_bytes\": " << codeBytes << ",\n"
+        << "  \"self_modifying\": " << (isSelfModifying() ? "true" : "false") << ",\n"
+        << "  \"blocks\": [";
+    for (std::size_t b = 0; b < blocks.size(); ++b)
+    {
+        const Block &block = blocks[b];
+        out << (b ? ",\n" : "\n")
+            << "    {\"start\": " << block.start << ", \"end\": " << block.end << ", \"successors\": [";
+        for (std::size_t i = 0; i < block.successors.size(); ++i)
+        {
+            out << (i ? ", " : "") << block.successors[i];
+        }
+        out << "], \"returns\": " << (block.returns ? "true" : "false")
+            << ", \"indirect\": " << (block.indirect ? "true" : "false")
+            << ", \"halts\": " << (block.halts ? "true" : "false") << ", \"instructions\": [";
+        for (std::size_t i = 0; i < block.instructions.size(); ++i)
+        {
+            const std::uint16_t address = block.instructions[i];
+            std::ostringstream opcode;
+            opcode << std::uppercase << std::hex << std::setfill('0') << std::setw(4) << memory.readWord(address);
+            out << (i ? ",\n" : "\n") << "      {\"address\": " << address << ", \"opcode\": "
+                << jsonString(opcode.str()) << ", \"text\": " << jsonString(disassemble(memory, address)) << "}";
+        }
+        out << "\n    ]}";
+    }
+    out << "\n  ],\n  \"data\": [";
+    for (std::size_t i = 0; i < dataRegions.size(); ++i)
+    {
+        out << (i ? ", " : "") << "{\"start\": " << dataRegions[i].start << ", \"end\": " << dataRegions[i].end << "}";
+    }
+    out << "],\n  \"stores\": [";
+    for (std::size_t i = 0; i < stores.size(); ++i)
+    {
+        const Store &store = stores[i];
+        out << (i ? ",\n" : "\n") << "    {\"address\": " << store.address
+            << ", \"resolved\": " << (store.resolved ? "true" : "false");
+        if (store.resolved)
+        {
+            out << ", \"first\": " << store.first << ", \"last\": " << store.last;
+        }
+        out << ", \"modifies_code\": " << (store.modifiesCode ? "true" : "false") << "}";
+    }
+    out << (stores.empty() ? "" : "\n  ") << "],\n  \"invalid\": [";
+    for (std::size_t i = 0; i < invalid.size(); ++i)
+    {
+        out << (i ? ", " : "") << invalid[i];
+    }
+    out << "]\n}\n";
+}
@@ -0,0 +1,212 @@
+#include "AotBackend.hpp"
+#include "AotModule.hpp"
+#include <algorithm>
+#include <cstring>
+
+AotBackend::AotBackend()
+    : module(nullptr), reach(0), state{}
+{
+    entries.fill(Entry{NO_BLOCK, 0});
+    state.clearDisplay = &AotBackend::helperClearDisplay;
+    state.selectPlanes = &AotBackend::helperSelectPlanes;
+    state.random = &AotBackend::helperRandom;
+    state.draw = &AotBackend::helperDraw;
+    state.load = &AotBackend::helperLoad;
+    state.keyIndex = &AotBackend::helperKeyIndex;
+}
+
+void AotBackend::run(CPU &cpu, std::uint64_t cycles)
+{
+    if (cpu.aotModule != module)
+    {
+        attach(cpu.aotModule);
+    }
+
+    // Blocks implement one variant; any other runs on the interpreter
+    if (!module || !module->isLoaded() || module->getQuirks() != cpu.quirks)
+    {
+        for (std::uint64_t i = 0; i < cycles; ++i)
+        {
+            cpu.emulateCycle();
+        }
+        return;
+    }
+
+    const Chip8AotBlock *blocks = module->getTable()->blocks;
+    const std::uint8_t *last = nullptr; // Bytes of the last instruction a block ran
+    loadState(cpu);
+    while (cycles > 0)
+    {
+        const Entry entry = entries[state.programCounter];
+        if (!isRunnable(cpu, entry))
+        {
+            // Uncovered or modified code runs on the decoded interpreter
+            // until execution reaches a block again
+            storeState(cpu);
+            do
+            {
+                cpu.emulateCycle();
+                cycles--;
+            } while (cycles > 0 && !isRunnable(cpu, entries[cpu.programCounter]));
+            loadState(cpu);
+            last = nullptr;
+            continue;
+        }
+
+        const Chip8AotBlock &block = blocks[entry.block];
+        const std::uint32_t remaining = block.length - entry.index;
+        const std::uint32_t done =
+            block.function(&state, entry.index, cycles < remaining ? static_cast<std::uint32_t>(cycles) : remaining);
+        cycles -= done;
+        last = block.bytes + (entry.index + done - 1) * 2;
+    }
+    storeState(cpu);
+    if (last)
+    {
+        cpu.opcode = static_cast<std::uint16_t>((last[0] << 8) | last[1]);
+    }
+}
+
+void AotBackend::invalidate(std::uint16_t address, std::size_t length)
+{
+    if (statuses.empty())
+    {
+        return;
+    }
+
+    const Chip8AotBlock *blocks = module->getTable()->blocks;
+    const std::size_t first = address >= reach ? address - reach : 0;
+    const std::size_t last = std::min(static_cast<std::size_t>(address) + length, entries.size());
+    for (std::size_t start = first; start < last; ++start)
+    {
+        const Entry &entry = entries[start];
+        if (entry.block != NO_BLOCK && entry.index == 0 && start + blocks[entry.block].size > address)
+        {
+            statuses[entry.block] = Status::Unchecked;
+        }
+    }
+}
+
+void AotBackend::attach(const AotModule *newModule)
+{
+    entries.fill(Entry{NO_BLOCK, 0});
+    statuses.clear();
+    module = newModule;
+    reach = 0;
+    if (!module || !module->isLoaded())
+    {
+        return;
+    }
+
+    const Chip8AotModule &table = *module->getTable();
+    statuses.assign(table.blockCount, Status::Unchecked);
+    for (std::uint16_t i = 0; i < table.blockCount && i < NO_BLOCK; ++i)
+    {
+        const Chip8AotBlock &block = table.blocks[i];
+        for (std::uint16_t index = 0; index < block.length; ++index)
+        {
+            const std::size_t address = block.start + index * 2u;
+            if (address < entries.size())
+            {
+                entries[address] = Entry{i, index};
+            }
+        }
+        reach = std::max<std::size_t>(reach, block.size);
+    }
+}
+
+bool AotBackend::check(const CPU &cpu, std::uint16_t block)
+{
+    Status &status = statuses[block];
+    if (status == Status::Unchecked)
+    {
+        status = matches(cpu, module->getTable()->blocks[block]) ? Status::Valid : Status::Stale;
+    }
+    return status == Status::Valid;
+}
+
+bool AotBackend::matches(const CPU &cpu, const Chip8AotBlock &block)
+{
+    if (static_cast<std::size_t>(block.start) + block.size > Memory::MEMORY_SIZE)
+    {
+        return false;
+    }
+    for (std::uint16_t i = 0; i < block.size; ++i)
+    {
+        if (cpu.memory->readByte(static_cast<std::uint16_t>(block.start + i)) != block.bytes[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AotBackend::loadState(CPU &cpu)
+{
+    std::memcpy(state.registers, cpu.registers.data(), sizeof(state.registers));
+    state.indexRegister = cpu.indexRegister;
+    state.programCounter = cpu.programCounter;
+    state.delayTimer = cpu.delayTimer;
+    state.soundTimer = cpu.soundTimer;
+    state.keys = cpu.keys.data();
+    state.host = &cpu;
+}
+
+void AotBackend::storeState(CPU &cpu) const
+{
+    std::memcpy(cpu.registers.data(), state.registers, sizeof(state.registers));
+    cpu.indexRegister = state.indexRegister;
+    cpu.programCounter = state.programCounter;
+    cpu.delayTimer = state.delayTimer;
+    cpu.soundTimer = state.soundTimer;
+}
+
+void AotBackend::helperClearDisplay(Chip8AotState *state)
+{
+    static_cast<CPU *>(state->host)->clearDisplay();
+}
+
+void AotBackend::helperSelectPlanes(Chip8AotState *state, std::uint8_t mask)
+{
+    static_cast<CPU *>(state->host)->selectPlanes(mask);
+}
+
+void AotBackend::helperRandom(Chip8AotState *state, std::uint8_t x, std::uint8_t mask)
+{
+    state->registers[x] = static_cast<CPU *>(state->host)->generateRandomByte() & mask;
+}
+
+void AotBackend::helperDraw(Chip8AotState *state, std::uint16_t address, std::uint8_t x, std::uint8_t y,
+                            std::uint8_t height)
+{
+    // Sprites are read at I; faults are reported at the drawing instruction
+    CPU &cpu = *static_cast<CPU *>(state->host);
+    cpu.indexRegister = state->indexRegister;
+    cpu.programCounter = address;
+    const bool collision = (cpu.quirks & CPU::QUIRK_CLIP_SPRITES)
+                               ? cpu.drawSprite<true>(state->registers[x], state->registers[y], height)
+                               : cpu.drawSprite<false>(state->registers[x], state->registers[y], height);
+    state->registers[0xF] = collision ? 1 : 0;
+}
+
+void AotBackend::helperLoad(Chip8AotState *state, std::uint16_t address, std::uint8_t x)
+{
+    CPU &cpu = *static_cast<CPU *>(state->host);
+    cpu.programCounter = address;
+    cpu.checkAccess(state->indexRegister, x + 1u);
+    for (std::uint8_t i = 0; i <= x; ++i)
+    {
+        state->registers[i] = cpu.memory->readByte(state->indexRegister + i);
+    }
+    if (cpu.quirks & CPU::QUIRK_INCREMENT_I)
+    {
+        state->indexRegister += x + 1;
+    }
+}
+
+void AotBackend::helperKeyIndex(Chip8AotState *state, std::uint16_t address)
+{
+    CPU &cpu = *static_cast<CPU *>(state->host);
+    cpu.programCounter = address;
+    cpu.reportFault(CPU::Fault::KeyIndex, address);
+}
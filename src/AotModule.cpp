@@ -0,0 +1,76 @@
+#include "AotModule.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_AOT_SUPPORTED 1
+#include <dlfcn.h>
+#else
+#define CHIP8_AOT_SUPPORTED 0
+#endif
+
+#define CHIP8_AOT_STRINGIFY(name) #name
+#define CHIP8_AOT_NAME(name) CHIP8_AOT_STRINGIFY(name)
+
+AotModule::~AotModule()
+{
+    unload();
+}
+
+bool AotModule::isSupported()
+{
+#if CHIP8_AOT_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AotModule::load(const std::string &path, std::string &error)
+{
+    unload();
+
+#if CHIP8_AOT_SUPPORTED
+    // Bare file names would be searched for in the library path
+    const std::string file = path.find('/') == std::string::npos ? "./" + path : path;
+    handle = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle)
+    {
+        const char *reason = dlerror();
+        error = reason ? reason : "Could not load " + path;
+        return false;
+    }
+
+    void *symbol = dlsym(handle, CHIP8_AOT_NAME(CHIP8_AOT_ENTRY_POINT));
+    if (!symbol)
+    {
+        error = path + " is not a recompiled module (no " CHIP8_AOT_NAME(CHIP8_AOT_ENTRY_POINT) ")";
+        unload();
+        return false;
+    }
+
+    // Object to function pointer conversion is conditionally supported; POSIX requires it
+    const Chip8AotModule *loaded = reinterpret_cast<Chip8AotEntryPoint>(symbol)();
+    if (!loaded || loaded->abiVersion != CHIP8_AOT_ABI_VERSION)
+    {
+        error = path + " was built for another module ABI version; recompile it";
+        unload();
+        return false;
+    }
+    table = loaded;
+    return true;
+#else
+    error = "Loading recompiled modules is not supported on this platform";
+    return false;
+#endif
+}
+
+void AotModule::unload()
+{
+    table = nullptr;
+#if CHIP8_AOT_SUPPORTED
+    if (handle)
+    {
+        dlclose(handle);
+    }
+#endif
+    handle = nullptr;
+}
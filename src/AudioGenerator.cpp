@@ -0,0 +1,53 @@
+#include "AudioGenerator.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double PATTERN_BITS = 8.0 * CPU::AUDIO_PATTERN_SIZE;
+    constexpr double BASE_RATE = 4000.0; // Pattern bits per second at the default pitch
+}
+
+AudioGenerator::AudioGenerator()
+{
+    reset();
+}
+
+void AudioGenerator::reset()
+{
+    phase = 0.0;
+    gain = 0;
+}
+
+void AudioGenerator::renderFrame(const CPU &cpu, std::int16_t *samples)
+{
+    const bool playing = cpu.getSoundTimer() != 0;
+    if (!playing && gain == 0)
+    {
+        std::fill(samples, samples + SAMPLES_PER_FRAME, static_cast<std::int16_t>(0));
+        return;
+    }
+
+    // Every beep starts at the beginning of the pattern
+    if (gain == 0)
+    {
+        phase = 0.0;
+    }
+
+    const std::array<std::uint8_t, CPU::AUDIO_PATTERN_SIZE> &pattern = cpu.getAudioPattern();
+    const double step = BASE_RATE * std::exp2((cpu.getPitch() - CPU::DEFAULT_PITCH) / 48.0) / SAMPLE_RATE;
+    const int target = playing ? RAMP_SAMPLES : 0;
+    for (std::size_t i = 0; i < SAMPLES_PER_FRAME; ++i)
+    {
+        const unsigned bit = static_cast<unsigned>(phase);
+        const bool high = (pattern[bit >> 3] >> (7 - (bit & 7))) & 1;
+        samples[i] = static_cast<std::int16_t>((high ? AMPLITUDE : -AMPLITUDE) * gain / RAMP_SAMPLES);
+
+        gain += gain < target ? 1 : (gain > target ? -1 : 0);
+        phase += step;
+        if (phase >= PATTERN_BITS)
+        {
+            phase -= PATTERN_BITS;
+        }
+    }
+}
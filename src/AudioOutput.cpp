@@ -0,0 +1,84 @@
+#include "AudioOutput.hpp"
+#include <algorithm>
+
+std::atomic<AudioOutput *> AudioOutput::active{nullptr};
+
+AudioOutput::AudioOutput() : stream(), ready(false), underruns(0), dropped(0)
+{
+}
+
+AudioOutput::~AudioOutput()
+{
+    shutdown();
+}
+
+bool AudioOutput::initialize()
+{
+    if (ready || active.load() != nullptr)
+    {
+        return ready;
+    }
+
+    InitAudioDevice();
+    if (!IsAudioDeviceReady())
+    {
+        CloseAudioDevice();
+        return false;
+    }
+
+    // Small device buffers keep latency down; the ring absorbs frame jitter
+    SetAudioStreamBufferSizeDefault(DEVICE_BUFFER_SAMPLES);
+    stream = LoadAudioStream(AudioGenerator::SAMPLE_RATE, 16, 1);
+    active.store(this);
+    SetAudioStreamCallback(stream, streamCallback);
+    PlayAudioStream(stream);
+    ready = true;
+    return true;
+}
+
+void AudioOutput::shutdown()
+{
+    if (!ready)
+    {
+        return;
+    }
+
+    StopAudioStream(stream);
+    UnloadAudioStream(stream);
+    active.store(nullptr);
+    CloseAudioDevice();
+    ready = false;
+}
+
+void AudioOutput::push(const std::int16_t *samples, std::size_t count)
+{
+    if (!ready)
+    {
+        return;
+    }
+
+    // Drop the whole frame rather than let latency grow
+    if (ring.size() + count > MAX_QUEUED)
+    {
+        dropped += count;
+        return;
+    }
+    dropped += count - ring.push(samples, count);
+}
+
+void AudioOutput::streamCallback(void *buffer, unsigned int frames)
+{
+    std::int16_t *out = static_cast<std::int16_t *>(buffer);
+    AudioOutput *output = active.load(std::memory_order_acquire);
+    const std::size_t filled = output ? output->ring.pop(out, frames) : 0;
+    if (filled < frames)
+    {
+        std::fill(out + filled, out + frames, static_cast<std::int16_t>(0));
+
+        // An empty ring is a paused or idle emulator; running dry mid-buffer is a glitch
+        if (filled != 0)
+        {
+            output->underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
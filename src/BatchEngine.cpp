@@ -0,0 +1,145 @@
+#include "BatchEngine.hpp"
+#include "FaultLog.hpp"
+#include "InputScript.hpp"
+#include "Memory.hpp"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+BatchEngine::BatchEngine(std::size_t threads)
+    : pool(threads)
+{
+}
+
+std::vector<BatchResult> BatchEngine::run(const std::vector<BatchJob> &jobs)
+{
+    std::vector<BatchResult> results(jobs.size());
+
+    // Each task writes only its own result slot
+    pool.run(jobs.size(), [&jobs, &results](std::size_t index)
+             { results[index] = runJob(jobs[index]); });
+
+    return results;
+}
+
+BatchResult BatchEngine::runJob(const BatchJob &job)
+{
+    BatchResult result;
+
+    InputScript script;
+    if (!job.inputScriptPath.empty() && !script.load(job.inputScriptPath, result.error))
+    {
+        return result;
+    }
+
+    // Machines are large (decode cache, translations), keep them off the worker stack
+    auto memory = std::make_unique<Memory>();
+    auto cpu = std::make_unique<CPU>(memory.get());
+    cpu->setRandomGenerator(script.hasRandomGenerator() ? script.getRandomGenerator() : job.random);
+    cpu->setRandomSeed(script.hasSeed() ? script.getSeed() : job.seed);
+    cpu->setQuirks(script.hasQuirks() ? script.getQuirks() : job.quirks);
+    cpu->reset();
+    cpu->setBackend(job.backend);
+
+    if (!memory->loadROM(job.romPath.c_str()))
+    {
+        result.error = "cannot load ROM: " + job.romPath;
+        return result;
+    }
+    if (script.hasROMHash() && script.getROMHash() != memory->getROMHash())
+    {
+        result.error = "input movie was recorded with a different ROM: " + job.inputScriptPath;
+        return result;
+    }
+
+    // A recorded movie only replays at the speed it was recorded at
+    const std::uint64_t cyclesPerFrame = script.getCyclesPerFrame() != 0
+                                             ? script.getCyclesPerFrame()
+                                             : job.cyclesPerFrame;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    FaultLog faults;
+    for (std::uint64_t frame = 0; frame < job.frames; ++frame)
+    {
+        script.apply(frame, cpu->getKeys());
+        cpu->run(cyclesPerFrame);
+        cpu->updateTimers();
+        faults.drain(*cpu, nullptr); // Counted only; workers do not print
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+
+    result.ok = true;
+    result.framebufferHash = cpu->getDisplayHash();
+    result.registers = cpu->getRegisters();
+    result.indexRegister = cpu->getIndexRegister();
+    result.programCounter = cpu->getProgramCounter();
+    result.frames = job.frames;
+    result.cycles = job.frames * cyclesPerFrame;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.faults = faults.getTotal() + faults.getDropped();
+    return result;
+}
+
+bool BatchEngine::loadJobList(const std::string &path, const BatchJob &defaults,
+                              std::vector<BatchJob> &jobs, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        error = "cannot open job list: " + path;
+        return false;
+    }
+
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        BatchJob job = defaults;
+        if (!(fields >> job.romPath))
+        {
+            continue; // Blank or comment-only line
+        }
+
+        std::string framesText;
+        std::string scriptText;
+        std::string quirksText;
+        std::string extra;
+        if (!(fields >> framesText) || (fields >> scriptText && fields >> quirksText && fields >> extra))
+        {
+            error = path + " line " + std::to_string(lineNumber) + ": expected <rom> <frames> [input_script [quirks]]";
+            return false;
+        }
+        if (!quirksText.empty() && !CPU::parseQuirks(quirksText.c_str(), job.quirks))
+        {
+            error = path + " line " + std::to_string(lineNumber) + ": unknown quirks " + quirksText;
+            return false;
+        }
+
+        std::size_t parsed = 0;
+        try
+        {
+            job.frames = std::stoull(framesText, &parsed, 10);
+        }
+        catch (const std::exception &)
+        {
+            parsed = 0;
+        }
+        if (parsed != framesText.size())
+        {
+            error = path + " line " + std::to_string(lineNumber) + ": bad frame count";
+            return false;
+        }
+
+        job.inputScriptPath = scriptText == "-" ? std::string() : scriptText;
+        jobs.push_back(job);
+    }
+
+    return true;
+}
@@ -1,15 +1,93 @@
 #include "CPU.hpp"
 #include "Memory.hpp"
+#include "AotBackend.hpp"
+#include "JitBackend.hpp"
+#include "Profiler.hpp"
+#include "ThreadedBackend.hpp"
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
-#include <iostream>
+#include <new>
+
+namespace
+{
+    // Tags the save state layout; bump when it changes
+    constexpr std::uint8_t STATE_TAG[4] = {'C', '8', 'S', '4'};
+
+    // Little-endian field writer over a caller-provided buffer
+    struct StateWriter
+    {
+        std::uint8_t *out;
+
+        void put8(std::uint8_t value) { *out++ = value; }
+        void put16(std::uint16_t value)
+        {
+            put8(static_cast<std::uint8_t>(value));
+            put8(static_cast<std::uint8_t>(value >> 8));
+        }
+        void put32(std::uint32_t value)
+        {
+            put16(static_cast<std::uint16_t>(value));
+            put16(static_cast<std::uint16_t>(value >> 16));
+        }
+        void put64(std::uint64_t value)
+        {
+            put32(static_cast<std::uint32_t>(value));
+            put32(static_cast<std::uint32_t>(value >> 32));
+        }
+    };
+
+    // Little-endian field reader matching StateWriter
+    struct StateReader
+    {
+        const std::uint8_t *in;
+
+        std::uint8_t get8() { return *in++; }
+        void skip(std::size_t bytes) { in += bytes; }
+        std::uint16_t get16()
+        {
+            std::uint16_t low = get8();
+            return static_cast<std::uint16_t>(low | (get8() << 8));
+        }
+        std::uint32_t get32()
+        {
+            std::uint32_t low = get16();
+            return low | (static_cast<std::uint32_t>(get16()) << 16);
+        }
+        std::uint64_t get64()
+        {
+            std::uint64_t low = get32();
+            return low | (static_cast<std::uint64_t>(get32()) << 32);
+        }
+    };
+
+    // Names of the individual quirk flags, as accepted by CPU::parseQuirks()
+    struct QuirkFlag
+    {
+        const char *name;
+        CPU::Quirks flag;
+    };
+
+    constexpr QuirkFlag QUIRK_FLAGS[] = {
+        {"shift-vy", CPU::QUIRK_SHIFT_VY},
+        {"jump-vx", CPU::QUIRK_JUMP_VX},
+        {"increment-i", CPU::QUIRK_INCREMENT_I},
+        {"reset-vf", CPU::QUIRK_RESET_VF},
+        {"clip-sprites", CPU::QUIRK_CLIP_SPRITES}};
+}
 
 CPU::CPU(Memory *mem)
-    : memory(mem)
+    : randomGenerator(RandomGenerator::Xorshift), randomSeed(DEFAULT_RANDOM_SEED), memory(mem), quirks(QUIRKS_NONE), backend(Backend::Cached)
 {
+    memory->setObserver(this);
     reset();
 }
 
+CPU::~CPU()
+{
+    memory->setObserver(nullptr);
+}
+
 void CPU::reset()
 {
     // Initialize CPU state
@@ -28,9 +106,22 @@ void CPU::reset()
     stack.fill(0);
     stackPointer = 0;
 
-    // Clear display and keys
-    display.fill(0);
+    // Back to low resolution with a clear display on plane 0; release keys
+    hires = false;
+    clearPlanes(ALL_PLANES);
+    selectPlanes(1);
     keys.fill(0);
+    flagRegisters.fill(0);
+
+    // Square wave: four bits on, four off, 500Hz at the default pitch
+    audioPattern.fill(0xF0);
+    pitch = DEFAULT_PITCH;
+
+    // Restart the random sequence
+    setRandomSeed(randomSeed);
+
+    // Drop all decoded instructions
+    invalidateDecodeCache(0, Memory::MEMORY_SIZE);
 }
 
 void CPU::updateTimers()
@@ -40,21 +131,684 @@ void CPU::updateTimers()
         delayTimer--;
     }
 
-    // Sound timer is decremented but not used for actual sound
+    // AudioGenerator plays the tone while the sound timer is non-zero
     if (soundTimer > 0)
     {
-        soundTimer--;
+        soundTimer--;
+    }
+}
+
+void CPU::emulateCycle()
+{
+    if (programCounter >= Memory::MEMORY_SIZE - 1 || !decodeCache)
+    {
+        // The last address cannot hold a complete instruction; let the
+        // reference interpreter handle it
+        if (programCounter >= Memory::MEMORY_SIZE - 1)
+        {
+            interpretCycle();
+            return;
+        }
+
+        // First cached cycle
+        allocateDecodeCache();
+    }
+
+#ifdef CHIP8_PROFILE
+    if (profiler)
+    {
+        profiledCycle();
+        return;
+    }
+#endif
+
+    // Fetch the decoded instruction; cache misses decode and fill the entry
+    const Instruction &instruction = decodeCache[programCounter];
+    if (!instruction.handler)
+    {
+        decodeMiss();
+        return;
+    }
+    opcode = instruction.opcode;
+    instruction.handler(*this, instruction);
+}
+
+void CPU::run(std::uint64_t cycles)
+{
+#ifdef CHIP8_PROFILE
+    if (profiler)
+    {
+        for (std::uint64_t i = 0; i < cycles; ++i)
+        {
+            emulateCycle();
+        }
+        return;
+    }
+#endif
+
+    if (idleSkipping)
+    {
+        // Halted on FX0A: the cycles would all re-execute it without effect
+        if (isWaitingForKey())
+        {
+            opcode = static_cast<std::uint16_t>((memory->readByte(programCounter) << 8) |
+                                                memory->readByte(programCounter + 1));
+            return;
+        }
+        cycles -= skipIdleLoop(cycles);
+    }
+
+    switch (backend)
+    {
+    case Backend::Interpreter:
+        for (std::uint64_t i = 0; i < cycles; ++i)
+        {
+            interpretCycle();
+        }
+        break;
+
+    case Backend::Cached:
+        for (std::uint64_t i = 0; i < cycles; ++i)
+        {
+            emulateCycle();
+        }
+        break;
+
+    default:
+        blockBackend->run(*this, cycles);
+        break;
+    }
+}
+
+bool CPU::isWaitingForKey() const
+{
+    if (programCounter >= Memory::MEMORY_SIZE - 1 ||
+        (memory->readByte(programCounter) & 0xF0) != 0xF0 ||
+        memory->readByte(programCounter + 1) != 0x0A)
+    {
+        return false;
+    }
+
+    for (std::uint8_t key : keys)
+    {
+        if (key)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CPU::isHalted() const
+{
+    if (isWaitingForKey())
+    {
+        return true;
+    }
+    if (programCounter >= Memory::MEMORY_SIZE - 1)
+    {
+        return false;
+    }
+
+    const std::uint16_t word = static_cast<std::uint16_t>((memory->readByte(programCounter) << 8) |
+                                                          memory->readByte(programCounter + 1));
+    return word == 0x00FD || word == (0x1000 | programCounter);
+}
+
+std::uint64_t CPU::skipIdleLoop(std::uint64_t cycles)
+{
+    // Run the loop on copies of the only state it may change
+    std::array<std::uint8_t, 16> v = registers;
+    std::uint16_t pc = programCounter;
+    std::uint16_t lastOpcode = opcode;
+
+    // One instruction; false if it is not one an idle loop may contain
+    auto step = [&]() -> bool
+    {
+        // Room for the instruction and a four-byte skip target, so nothing wraps
+        if (pc > Memory::MEMORY_SIZE - 6)
+        {
+            return false;
+        }
+
+        // Reuse the decoded instruction when there is one
+        const Instruction in = decodeCache && decodeCache[pc].handler
+                                   ? decodeCache[pc]
+                                   : decode(static_cast<std::uint16_t>((memory->readByte(pc) << 8) |
+                                                                       memory->readByte(pc + 1)));
+        bool skip = false;
+        switch (in.op)
+        {
+        case Operation::Jp:
+            pc = in.nnn;
+            lastOpcode = in.opcode;
+            return true;
+        case Operation::Exit:
+            lastOpcode = in.opcode;
+            return true;
+        case Operation::SeImm:
+            skip = v[in.x] == in.nn;
+            break;
+        case Operation::SneImm:
+            skip = v[in.x] != in.nn;
+            break;
+        case Operation::SeReg:
+            skip = v[in.x] == v[in.y];
+            break;
+        case Operation::SneReg:
+            skip = v[in.x] != v[in.y];
+            break;
+        case Operation::Skp:
+        case Operation::Sknp:
+            if (v[in.x] >= KEY_COUNT)
+            {
+                return false;
+            }
+            skip = (keys[v[in.x]] != 0) == (in.op == Operation::Skp);
+            break;
+        case Operation::LdImm:
+            v[in.x] = in.nn;
+            break;
+        case Operation::LdReg:
+            v[in.x] = v[in.y];
+            break;
+        case Operation::LdVxDt:
+            v[in.x] = delayTimer;
+            break;
+        default:
+            return false;
+        }
+        pc = static_cast<std::uint16_t>(pc + (skip ? skipLength(pc) : 2));
+        lastOpcode = in.opcode;
+        return true;
+    };
+
+    // Instructions until the program counter comes back, 0 if it does not
+    auto pass = [&](std::uint64_t limit) -> std::uint64_t
+    {
+        const std::uint16_t start = pc;
+        for (std::uint64_t length = 1; length <= limit; ++length)
+        {
+            if (!step())
+            {
+                return 0;
+            }
+            if (pc == start)
+            {
+                return length;
+            }
+        }
+        return 0;
+    };
+
+    // The first pass may still change registers (FX07 after the timer ticked);
+    // if the second ends where the first did, so does every later one
+    if (cycles < 2)
+    {
+        return 0;
+    }
+    const std::uint64_t first = pass(std::min(IDLE_LOOP_MAX_LENGTH, cycles - 1));
+    if (first == 0)
+    {
+        return 0;
+    }
+    const std::array<std::uint8_t, 16> settled = v;
+    const std::uint64_t length = pass(std::min(IDLE_LOOP_MAX_LENGTH, cycles - first));
+    if (length == 0 || v != settled)
+    {
+        return 0;
+    }
+
+    registers = v;
+    opcode = lastOpcode;
+    return first + (cycles - first) / length * length;
+}
+
+bool CPU::setProfiler(Profiler *newProfiler)
+{
+#ifdef CHIP8_PROFILE
+    profiler = newProfiler;
+    return true;
+#else
+    return newProfiler == nullptr;
+#endif
+}
+
+#ifdef CHIP8_PROFILE
+void CPU::profiledCycle()
+{
+    const std::uint16_t pc = programCounter;
+    Instruction &entry = decodeCache[pc];
+    if (!entry.handler)
+    {
+        entry = decode(static_cast<std::uint16_t>((memory->readByte(pc) << 8) | memory->readByte(pc + 1)), quirks);
+    }
+
+    // Copy: the handler may overwrite its own cache entry (FX55 over itself)
+    const Instruction instruction = entry;
+    opcode = instruction.opcode;
+
+    const std::uint64_t start = Profiler::readClock();
+    instruction.handler(*this, instruction);
+    const std::uint64_t ticks = Profiler::readClock() - start;
+
+    profiler->record(pc, instruction.op, programCounter, ticks);
+}
+#endif
+
+const char *CPU::backendName(Backend backend)
+{
+    switch (backend)
+    {
+    case Backend::Interpreter:
+        return "interpreter";
+    case Backend::Cached:
+        return "cached";
+    case Backend::Threaded:
+        return "threaded";
+    case Backend::Jit:
+        return "jit";
+    case Backend::Aot:
+        return "aot";
+    }
+    return "unknown";
+}
+
+bool CPU::parseBackendName(const char *name, Backend &backend)
+{
+    static constexpr Backend ALL[] = {Backend::Interpreter, Backend::Cached, Backend::Threaded, Backend::Jit, Backend::Aot};
+    for (Backend candidate : ALL)
+    {
+        if (std::strcmp(name, backendName(candidate)) == 0)
+        {
+            backend = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CPU::setQuirks(Quirks newQuirks)
+{
+    newQuirks &= QUIRKS_ALL;
+    if (newQuirks == quirks)
+    {
+        return;
+    }
+
+    // Decoded handlers and translations are built for one variant
+    quirks = newQuirks;
+    invalidateDecodeCache(0, Memory::MEMORY_SIZE);
+    if (blockBackend)
+    {
+        blockBackend->invalidate(0, Memory::MEMORY_SIZE);
+    }
+}
+
+const CPU::QuirkProfile *CPU::quirkProfiles()
+{
+    static constexpr QuirkProfile PROFILES[] = {
+        {"default", QUIRKS_NONE, "this emulator's original behavior (wrapping sprites, shifts of VX)"},
+        {"vip", QUIRK_SHIFT_VY | QUIRK_INCREMENT_I | QUIRK_RESET_VF | QUIRK_CLIP_SPRITES, "COSMAC VIP CHIP-8"},
+        {"schip", QUIRK_JUMP_VX | QUIRK_CLIP_SPRITES, "SUPER-CHIP 1.1"},
+        {"xochip", QUIRK_SHIFT_VY | QUIRK_INCREMENT_I, "XO-CHIP"},
+        {nullptr, QUIRKS_NONE, nullptr}};
+    return PROFILES;
+}
+
+bool CPU::parseQuirks(const char *text, Quirks &result)
+{
+    Quirks combined = QUIRKS_NONE;
+    const std::string spec(text);
+    std::size_t start = 0;
+    while (start <= spec.size())
+    {
+        std::size_t end = spec.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = spec.size();
+        }
+        const std::string name = spec.substr(start, end - start);
+        start = end + 1;
+
+        bool known = false;
+        for (const QuirkProfile *profile = quirkProfiles(); profile->name && !known; ++profile)
+        {
+            if (name == profile->name)
+            {
+                combined |= profile->quirks;
+                known = true;
+            }
+        }
+        for (const QuirkFlag &flag : QUIRK_FLAGS)
+        {
+            if (!known && name == flag.name)
+            {
+                combined |= flag.flag;
+                known = true;
+            }
+        }
+        if (!known)
+        {
+            return false;
+        }
+    }
+
+    result = combined;
+    return true;
+}
+
+std::string CPU::quirksName(Quirks value)
+{
+    for (const QuirkProfile *profile = quirkProfiles(); profile->name; ++profile)
+    {
+        if (profile->quirks == value)
+        {
+            return profile->name;
+        }
+    }
+
+    std::string name;
+    for (const QuirkFlag &flag : QUIRK_FLAGS)
+    {
+        if (value & flag.flag)
+        {
+            name += name.empty() ? "" : ",";
+            name += flag.name;
+        }
+    }
+    return name;
+}
+
+void CPU::setRandomSeed(std::uint32_t seed)
+{
+    randomSeed = seed;
+
+    // The counter generator starts at byte 0 of the seed's stream
+    if (randomGenerator == RandomGenerator::Counter)
+    {
+        randomState = 0;
+        return;
+    }
+
+    // Spread the seed over all bits; xorshift must not start at zero
+    randomState = (seed ^ 0x6D2B79F5u) * 0x9E3779B9u;
+    if (randomState == 0)
+    {
+        randomState = 0x9E3779B9u;
+    }
+}
+
+void CPU::setRandomGenerator(RandomGenerator generator)
+{
+    randomGenerator = generator;
+    setRandomSeed(randomSeed);
+}
+
+const char *CPU::randomGeneratorName(RandomGenerator generator)
+{
+    switch (generator)
+    {
+    case RandomGenerator::Xorshift:
+        return "xorshift";
+    case RandomGenerator::Counter:
+        return "counter";
+    }
+    return "unknown";
+}
+
+bool CPU::parseRandomGenerator(const char *name, RandomGenerator &generator)
+{
+    static constexpr RandomGenerator ALL[] = {RandomGenerator::Xorshift, RandomGenerator::Counter};
+    for (RandomGenerator candidate : ALL)
+    {
+        if (std::strcmp(name, randomGeneratorName(candidate)) == 0)
+        {
+            generator = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CPU::setBackend(Backend newBackend)
+{
+    if (newBackend == backend)
+    {
+        return;
+    }
+
+    // Translations are rebuilt from scratch when switching
+    blockBackend.reset();
+    if (newBackend == Backend::Jit && !JitBackend::isSupported())
+    {
+        // No native code generator for this host
+        newBackend = Backend::Threaded;
+    }
+
+    if (newBackend == Backend::Jit)
+    {
+        blockBackend = std::make_unique<JitBackend>();
+    }
+    else if (newBackend == Backend::Threaded)
+    {
+        blockBackend = std::make_unique<ThreadedBackend>();
+    }
+    else if (newBackend == Backend::Aot)
+    {
+        blockBackend = std::make_unique<AotBackend>();
+    }
+    backend = newBackend;
+}
+
+void CPU::translate(const Analyzer &analysis)
+{
+    if (blockBackend)
+    {
+        blockBackend->translate(*this, analysis);
+    }
+}
+
+void CPU::forkFrom(const CPU &parent)
+{
+    // Variant first: a change drops every decoded instruction anyway
+    setQuirks(parent.quirks);
+    setBackend(parent.backend);
+    aotModule = parent.aotModule;
+    idleSkipping = parent.idleSkipping;
+
+    // Share the parent's pages; the observer drops what was decoded from
+    // every page that differs
+    *memory = *parent.memory;
+
+    opcode = parent.opcode;
+    indexRegister = parent.indexRegister;
+    programCounter = parent.programCounter;
+    registers = parent.registers;
+    delayTimer = parent.delayTimer;
+    soundTimer = parent.soundTimer;
+    stack = parent.stack;
+    stackPointer = parent.stackPointer;
+    display = parent.display;
+    hires = parent.hires;
+    planeMask = parent.planeMask;
+    classicDisplay = parent.classicDisplay;
+    keys = parent.keys;
+    flagRegisters = parent.flagRegisters;
+    audioPattern = parent.audioPattern;
+    pitch = parent.pitch;
+    randomGenerator = parent.randomGenerator;
+    randomSeed = parent.randomSeed;
+    randomState = parent.randomState;
+    displayPixelsStale = true;
+}
+
+bool CPU::hasSameState(const CPU &other) const
+{
+    return indexRegister == other.indexRegister &&
+           programCounter == other.programCounter &&
+           registers == other.registers &&
+           delayTimer == other.delayTimer &&
+           soundTimer == other.soundTimer &&
+           stack == other.stack &&
+           stackPointer == other.stackPointer &&
+           display == other.display &&
+           hires == other.hires &&
+           planeMask == other.planeMask &&
+           flagRegisters == other.flagRegisters &&
+           audioPattern == other.audioPattern &&
+           pitch == other.pitch &&
+           keys == other.keys &&
+           randomGenerator == other.randomGenerator &&
+           randomState == other.randomState &&
+           (randomGenerator == RandomGenerator::Xorshift || randomSeed == other.randomSeed) &&
+           *memory == *other.memory;
+}
+
+std::size_t CPU::saveState(std::uint8_t *buffer, std::size_t size) const
+{
+    if (size < STATE_SIZE)
+    {
+        return 0;
+    }
+
+    StateWriter writer{buffer};
+    for (std::uint8_t byte : STATE_TAG)
+    {
+        writer.put8(byte);
+    }
+    writer.put16(opcode);
+    writer.put16(indexRegister);
+    writer.put16(programCounter);
+    for (std::uint8_t value : registers)
+    {
+        writer.put8(value);
+    }
+    writer.put8(delayTimer);
+    writer.put8(soundTimer);
+    for (std::uint16_t value : stack)
+    {
+        writer.put16(value);
+    }
+    writer.put8(stackPointer);
+    for (const auto &plane : display)
+    {
+        for (std::uint64_t word : plane)
+        {
+            writer.put64(word);
+        }
+    }
+    writer.put8(hires ? 1 : 0);
+    writer.put8(planeMask);
+    for (std::uint8_t key : keys)
+    {
+        writer.put8(key);
+    }
+    for (std::uint8_t flag : flagRegisters)
+    {
+        writer.put8(flag);
+    }
+    for (std::uint8_t sample : audioPattern)
+    {
+        writer.put8(sample);
+    }
+    writer.put8(pitch);
+    writer.put8(static_cast<std::uint8_t>(randomGenerator));
+    writer.put32(randomSeed);
+    writer.put32(randomState);
+    memory->saveState(writer.out);
+
+    return STATE_SIZE;
+}
+
+bool CPU::loadState(const std::uint8_t *buffer, std::size_t size)
+{
+    if (size < STATE_SIZE || std::memcmp(buffer, STATE_TAG, sizeof(STATE_TAG)) != 0)
+    {
+        return false;
+    }
+
+    // Check the fields later instructions index with before changing anything
+    StateReader check{buffer + sizeof(STATE_TAG)};
+    check.skip(3 * sizeof(std::uint16_t) + registers.size() + 2 /* timers */ + stack.size() * sizeof(std::uint16_t));
+    const std::uint8_t savedStackPointer = check.get8();
+    check.skip(DISPLAY_PLANES * DISPLAY_WORDS * sizeof(std::uint64_t));
+    const std::uint8_t savedHires = check.get8();
+    const std::uint8_t savedPlanes = check.get8();
+    check.skip(keys.size() + flagRegisters.size() + audioPattern.size() + 1 /* pitch */);
+    const std::uint8_t savedGenerator = check.get8();
+    if (savedStackPointer > stack.size() || savedHires > 1 || savedPlanes > ALL_PLANES ||
+        savedGenerator > static_cast<std::uint8_t>(RandomGenerator::Counter))
+    {
+        return false;
+    }
+
+    StateReader reader{buffer + sizeof(STATE_TAG)};
+    opcode = reader.get16();
+    indexRegister = reader.get16();
+    programCounter = reader.get16();
+    for (std::uint8_t &value : registers)
+    {
+        value = reader.get8();
+    }
+    delayTimer = reader.get8();
+    soundTimer = reader.get8();
+    for (std::uint16_t &value : stack)
+    {
+        value = reader.get16();
+    }
+    stackPointer = reader.get8();
+    for (auto &plane : display)
+    {
+        for (std::uint64_t &word : plane)
+        {
+            word = reader.get64();
+        }
+    }
+    hires = reader.get8() != 0;
+    selectPlanes(reader.get8());
+    displayPixelsStale = true;
+    for (std::uint8_t &key : keys)
+    {
+        key = reader.get8();
+    }
+    for (std::uint8_t &flag : flagRegisters)
+    {
+        flag = reader.get8();
+    }
+    for (std::uint8_t &sample : audioPattern)
+    {
+        sample = reader.get8();
     }
+    pitch = reader.get8();
+    randomGenerator = static_cast<RandomGenerator>(reader.get8());
+    randomSeed = reader.get32();
+    randomState = reader.get32();
+
+    // Reports changed memory, which drops stale decoded instructions and blocks
+    memory->loadState(reader.in);
+
+    return true;
 }
 
-void CPU::emulateCycle()
+void CPU::interpretCycle()
 {
+    // Instructions at the last address (or beyond) wrap to the start of memory
+    if (programCounter >= Memory::MEMORY_SIZE - 1)
+    {
+        reportFault(Fault::PcWrap, programCounter);
+        programCounter &= Memory::ADDRESS_MASK;
+    }
+
     // Fetch instruction
-    std::uint8_t highByte = memory->readByte(programCounter);
-    std::uint8_t lowByte = memory->readByte(programCounter + 1);
-    opcode = (highByte << 8) | lowByte;
+    opcode = memory->readWord(programCounter);
 
     // Decode and execute instruction
+    executeOpcode(opcode);
+}
+
+void CPU::executeOpcode(std::uint16_t opcode)
+{
     switch (opcode & 0xF000)
     {
     case 0x0000:
@@ -106,55 +860,481 @@ void CPU::emulateCycle()
         executeOpcodeF(opcode);
         break;
     default:
-        std::cerr << "Unknown opcode: 0x" << std::hex << opcode << std::endl;
+        reportFault(Fault::UnknownOpcode, programCounter);
         programCounter += 2;
         break;
     }
 }
 
+void CPU::allocateDecodeCache()
+{
+    // Zeroed pages straight from the allocator: every entry starts as a
+    // miss, and the system only provides the pages that code runs from
+    decodeCache.reset(static_cast<Instruction *>(std::calloc(Memory::MEMORY_SIZE, sizeof(Instruction))));
+    if (!decodeCache)
+    {
+        throw std::bad_alloc();
+    }
+}
+
+void CPU::decodeMiss()
+{
+    const std::uint16_t address = programCounter;
+    const std::uint16_t fetched = memory->readWord(address);
+
+    Instruction &entry = decodeCache[address];
+    entry = decode(fetched, quirks);
+    opcode = fetched;
+    entry.handler(*this, entry);
+}
+
+void CPU::reportFault(Fault type, std::uint16_t address)
+{
+    const std::uint16_t pc = programCounter & Memory::ADDRESS_MASK;
+    const FaultEvent event{type, programCounter, address,
+                           static_cast<std::uint16_t>((memory->readByte(pc) << 8) | memory->readByte(pc + 1))};
+    if (!faults.tryPush(event))
+    {
+        droppedFaults.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+const char *CPU::faultName(Fault type)
+{
+    switch (type)
+    {
+    case Fault::UnknownOpcode:
+        return "unknown opcode";
+    case Fault::StackOverflow:
+        return "stack overflow";
+    case Fault::StackUnderflow:
+        return "stack underflow";
+    case Fault::AddressWrap:
+        return "address wrap";
+    case Fault::PcWrap:
+        return "pc wrap";
+    case Fault::KeyIndex:
+        return "key index";
+    }
+    return "unknown fault";
+}
+
+void CPU::invalidateDecodeCache(std::uint16_t address, std::size_t length)
+{
+    if (!decodeCache)
+    {
+        return;
+    }
+
+    // Dropping everything hands the pages back; the next cached cycle
+    // starts from a fresh zeroed cache
+    if (length >= Memory::MEMORY_SIZE)
+    {
+        decodeCache.reset();
+        return;
+    }
+
+    // An instruction starting one byte before the range also reads from it
+    std::size_t first = address > 0 ? address - 1 : 0;
+    std::size_t last = static_cast<std::size_t>(address) + length;
+    if (last > Memory::MEMORY_SIZE)
+    {
+        last = Memory::MEMORY_SIZE;
+    }
+
+    for (std::size_t i = first; i < last; ++i)
+    {
+        decodeCache[i].handler = nullptr;
+    }
+}
+
+void CPU::onMemoryWrite(std::uint16_t address, std::size_t length)
+{
+    invalidateDecodeCache(address, length);
+    if (blockBackend)
+    {
+        blockBackend->invalidate(address, length);
+    }
+}
+
 std::uint8_t CPU::generateRandomByte()
 {
-    return static_cast<std::uint8_t>(std::rand() % 256);
+    if (randomGenerator == RandomGenerator::Counter)
+    {
+        // SplitMix64 finalizer over (seed, counter); it is a bijection, so no
+        // two seeds' streams hash the same inputs
+        std::uint64_t z = ((static_cast<std::uint64_t>(randomSeed) << 32) | randomState++) + 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<std::uint8_t>((z ^ (z >> 31)) >> 56);
+    }
+
+    // xorshift32; the top byte has the best distribution
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return static_cast<std::uint8_t>(randomState >> 24);
+}
+
+std::uint64_t CPU::getDisplayHash() const
+{
+    // Hash the words of the visible area byte by byte, most significant
+    // byte first; in low resolution that is the first word of 32 rows.
+    // Plane 1 follows plane 0 once it has a lit pixel.
+    static_assert(DISPLAY_PLANES == 2, "Hashing assumes two planes");
+    const std::size_t words = getDisplayWidth() / 64;
+    std::uint64_t secondPlaneLit = 0;
+    for (std::size_t y = 0; y < getDisplayHeight(); ++y)
+    {
+        for (std::size_t w = 0; w < words; ++w)
+        {
+            secondPlaneLit |= display[1][y * DISPLAY_ROW_WORDS + w];
+        }
+    }
+
+    std::uint64_t hash = 0xCBF29CE484222325ULL; // FNV offset basis
+    for (std::size_t plane = 0; plane < (secondPlaneLit ? 2u : 1u); ++plane)
+    {
+        for (std::size_t y = 0; y < getDisplayHeight(); ++y)
+        {
+            for (std::size_t w = 0; w < words; ++w)
+            {
+                const std::uint64_t word = display[plane][y * DISPLAY_ROW_WORDS + w];
+                for (int shift = 56; shift >= 0; shift -= 8)
+                {
+                    hash ^= static_cast<std::uint8_t>(word >> shift);
+                    hash *= 0x100000001B3ULL; // FNV prime
+                }
+            }
+        }
+    }
+    return hash;
+}
+
+const std::array<std::uint8_t, CPU::DISPLAY_SIZE> &CPU::getDisplay() const
+{
+    if (displayPixelsStale)
+    {
+        const std::size_t width = getDisplayWidth();
+        for (std::size_t y = 0; y < getDisplayHeight(); ++y)
+        {
+            std::uint8_t *pixels = &displayPixels[y * width];
+            for (std::size_t x = 0; x < width; ++x)
+            {
+                const std::size_t index = y * DISPLAY_ROW_WORDS + x / 64;
+                const unsigned bit = 63 - x % 64;
+                pixels[x] = static_cast<std::uint8_t>(((display[0][index] >> bit) & 1) |
+                                                      (((display[1][index] >> bit) & 1) << 1));
+            }
+        }
+        displayPixelsStale = false;
+    }
+    return displayPixels;
 }
 
 void CPU::clearDisplay()
 {
-    display.fill(0);
+    clearPlanes(planeMask);
+}
+
+void CPU::clearPlanes(std::uint8_t mask)
+{
+    for (std::size_t plane = 0; plane < DISPLAY_PLANES; ++plane)
+    {
+        if (mask & (1u << plane))
+        {
+            display[plane].fill(0);
+        }
+    }
+    displayPixelsStale = true;
+}
+
+void CPU::setHighResolution(bool enabled)
+{
+    // Switching modes clears the screen (every plane), as on the HP48 and in Octo
+    hires = enabled;
+    classicDisplay = !hires && planeMask == 1;
+    clearPlanes(ALL_PLANES);
+}
+
+void CPU::selectPlanes(std::uint8_t mask)
+{
+    planeMask = mask & ALL_PLANES;
+    classicDisplay = !hires && planeMask == 1;
+}
+
+void CPU::scrollDown(std::uint8_t rows)
+{
+    // Whole rows move with one memmove per plane; the rows scrolled in are blank
+    const std::size_t height = getDisplayHeight();
+    const std::size_t count = std::min<std::size_t>(rows, height);
+    for (std::size_t plane = 0; plane < DISPLAY_PLANES; ++plane)
+    {
+        if (planeMask & (1u << plane))
+        {
+            std::uint64_t *words = display[plane].data();
+            std::memmove(words + count * DISPLAY_ROW_WORDS, words,
+                         (height - count) * DISPLAY_ROW_WORDS * sizeof(std::uint64_t));
+            std::memset(words, 0, count * DISPLAY_ROW_WORDS * sizeof(std::uint64_t));
+        }
+    }
+    displayPixelsStale = true;
+}
+
+void CPU::scrollUp(std::uint8_t rows)
+{
+    const std::size_t height = getDisplayHeight();
+    const std::size_t count = std::min<std::size_t>(rows, height);
+    for (std::size_t plane = 0; plane < DISPLAY_PLANES; ++plane)
+    {
+        if (planeMask & (1u << plane))
+        {
+            std::uint64_t *words = display[plane].data();
+            std::memmove(words, words + count * DISPLAY_ROW_WORDS,
+                         (height - count) * DISPLAY_ROW_WORDS * sizeof(std::uint64_t));
+            std::memset(words + (height - count) * DISPLAY_ROW_WORDS, 0,
+                        count * DISPLAY_ROW_WORDS * sizeof(std::uint64_t));
+        }
+    }
+    displayPixelsStale = true;
+}
+
+void CPU::scrollRight()
+{
+    // Four pixels; in high resolution the bits leaving the left word enter the right one
+    static_assert(DISPLAY_ROW_WORDS == 2, "Scrolling assumes two words per row");
+    for (std::size_t plane = 0; plane < DISPLAY_PLANES; ++plane)
+    {
+        if (!(planeMask & (1u << plane)))
+        {
+            continue;
+        }
+        for (std::size_t y = 0; y < getDisplayHeight(); ++y)
+        {
+            std::uint64_t *row = &display[plane][y * DISPLAY_ROW_WORDS];
+            if (hires)
+            {
+                row[1] = (row[1] >> 4) | (row[0] << 60);
+            }
+            row[0] >>= 4;
+        }
+    }
+    displayPixelsStale = true;
+}
+
+void CPU::scrollLeft()
+{
+    for (std::size_t plane = 0; plane < DISPLAY_PLANES; ++plane)
+    {
+        if (!(planeMask & (1u << plane)))
+        {
+            continue;
+        }
+        for (std::size_t y = 0; y < getDisplayHeight(); ++y)
+        {
+            std::uint64_t *row = &display[plane][y * DISPLAY_ROW_WORDS];
+            row[0] <<= 4;
+            if (hires)
+            {
+                row[0] |= row[1] >> 60;
+                row[1] <<= 4;
+            }
+        }
+    }
+    displayPixelsStale = true;
+}
+
+void CPU::saveRange(std::uint8_t x, std::uint8_t y)
+{
+    // VX first; the range runs downwards when X > Y
+    const unsigned count = (x <= y ? y - x : x - y) + 1u;
+    const int step = x <= y ? 1 : -1;
+    checkAccess(indexRegister, count);
+    std::array<std::uint8_t, 16> values;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        values[i] = registers[x + step * static_cast<int>(i)];
+    }
+    memory->writeBytes(indexRegister, values.data(), count);
+}
+
+void CPU::loadRange(std::uint8_t x, std::uint8_t y)
+{
+    const unsigned count = (x <= y ? y - x : x - y) + 1u;
+    const int step = x <= y ? 1 : -1;
+    checkAccess(indexRegister, count);
+    for (unsigned i = 0; i < count; ++i)
+    {
+        registers[x + step * static_cast<int>(i)] = memory->readByte(indexRegister + i);
+    }
 }
 
+template <bool CLIP>
 bool CPU::drawSprite(std::uint8_t x, std::uint8_t y, std::uint8_t height)
 {
-    bool collision = false;
+    static_assert(LORES_WIDTH == 64, "Low resolution rows are packed into one 64-bit word");
+
+    // High resolution, 16x16 sprites and XO-CHIP planes take the general
+    // path, so the classic draw stays as tight as before
+    if (!classicDisplay || height == 0)
+    {
+        return drawSuperSprite<CLIP>(x, y, height);
+    }
+
+    // The starting position always wraps. Without clipping, the sprite byte
+    // is placed at the left edge and rotated to column x, so pixels that run
+    // off the right edge come back on the left; rows wrap to the top. With
+    // clipping, they are shifted out and rows below the screen are dropped.
+    const unsigned shift = x % LORES_WIDTH;
+    const unsigned top = y % LORES_HEIGHT;
+    if (CLIP && top + height > LORES_HEIGHT)
+    {
+        height = static_cast<std::uint8_t>(LORES_HEIGHT - top);
+    }
+    std::uint64_t collision = 0;
+    checkAccess(indexRegister, height);
 
+    std::uint64_t *lines = display[0].data();
     for (std::uint8_t row = 0; row < height; ++row)
     {
-        std::uint8_t spriteData = memory->readByte(indexRegister + row);
+        std::uint64_t sprite = static_cast<std::uint64_t>(memory->readByte(indexRegister + row)) << 56;
+        if (CLIP)
+        {
+            sprite >>= shift;
+        }
+        else if (shift != 0)
+        {
+            sprite = (sprite >> shift) | (sprite << (64 - shift));
+        }
+
+        std::uint64_t &line = lines[((top + row) % LORES_HEIGHT) * DISPLAY_ROW_WORDS];
+        collision |= line & sprite;
+        line ^= sprite;
+    }
+
+    displayPixelsStale = true;
+    return collision != 0;
+}
+
+template <bool CLIP>
+bool CPU::drawSuperSprite(std::uint8_t x, std::uint8_t y, std::uint8_t height)
+{
+    static_assert(DISPLAY_ROW_WORDS == 2, "High resolution rows are packed into two 64-bit words");
+
+    // DXY0 draws a 16x16 sprite, two bytes per row
+    const bool wide = height == 0;
+    const unsigned rows = wide ? 16 : height;
+    const unsigned bytesPerRow = wide ? 2 : 1;
+
+    // Same wrapping and clipping as drawSprite(); both resolutions are
+    // powers of two, so wrapping is a mask
+    const unsigned widthMask = static_cast<unsigned>(getDisplayWidth()) - 1;
+    const unsigned heightMask = static_cast<unsigned>(getDisplayHeight()) - 1;
+    const unsigned shift = x & widthMask;
+    const unsigned top = y & heightMask;
+    const unsigned visibleRows = (CLIP && top + rows > heightMask + 1) ? heightMask + 1 - top : rows;
+    std::uint64_t collision = 0;
+
+    // Each selected plane takes the next full sprite from I onwards
+    // (XO-CHIP), so plane 1 alone also starts at I
+    const Memory &ram = *memory;
+    std::uint16_t base = indexRegister;
+    for (std::size_t plane = 0; plane < DISPLAY_PLANES; ++plane)
+    {
+        if (!(planeMask & (1u << plane)))
+        {
+            continue;
+        }
+        checkAccess(base, visibleRows * bytesPerRow);
 
-        for (std::uint8_t col = 0; col < 8; ++col)
+        // Sprite row bits at the left edge of a word
+        auto spriteRow = [&ram, base, wide](unsigned row)
         {
-            std::uint8_t spritePixel = (spriteData >> (7 - col)) & 1;
+            if (!wide)
+            {
+                return static_cast<std::uint64_t>(ram.readByte(static_cast<std::uint16_t>(base + row))) << 56;
+            }
+            const std::uint16_t address = static_cast<std::uint16_t>(base + 2 * row);
+            return (static_cast<std::uint64_t>(ram.readByte(address)) << 56) |
+                   (static_cast<std::uint64_t>(ram.readByte(address + 1)) << 48);
+        };
 
-            if (spritePixel)
+        std::uint64_t *lines = display[plane].data();
+        if (!hires)
+        {
+            // One word per row: rotate the sprite to column x
+            for (unsigned row = 0; row < visibleRows; ++row)
             {
-                std::uint8_t pixelX = (x + col) % DISPLAY_WIDTH;
-                std::uint8_t pixelY = (y + row) % DISPLAY_HEIGHT;
-                std::size_t pixelIndex = pixelY * DISPLAY_WIDTH + pixelX;
+                std::uint64_t sprite = spriteRow(row);
+                if (CLIP)
+                {
+                    sprite >>= shift;
+                }
+                else if (shift != 0)
+                {
+                    sprite = (sprite >> shift) | (sprite << (64 - shift));
+                }
 
-                if (display[pixelIndex])
+                std::uint64_t &line = lines[((top + row) & heightMask) * DISPLAY_ROW_WORDS];
+                collision |= line & sprite;
+                line ^= sprite;
+            }
+        }
+        else
+        {
+            // Two words per row: split the sprite across them
+            for (unsigned row = 0; row < visibleRows; ++row)
+            {
+                const std::uint64_t sprite = spriteRow(row);
+                std::uint64_t left;
+                std::uint64_t right;
+                if (shift < 64)
+                {
+                    left = sprite >> shift;
+                    right = shift ? sprite << (64 - shift) : 0;
+                }
+                else
                 {
-                    collision = true;
+                    const unsigned inner = shift - 64;
+                    right = sprite >> inner;
+                    left = (!CLIP && inner) ? sprite << (64 - inner) : 0;
                 }
-                display[pixelIndex] ^= 1;
+
+                std::uint64_t *line = &lines[((top + row) & heightMask) * DISPLAY_ROW_WORDS];
+                collision |= (line[0] & left) | (line[1] & right);
+                line[0] ^= left;
+                line[1] ^= right;
             }
         }
+
+        base = static_cast<std::uint16_t>(base + rows * bytesPerRow);
     }
 
-    return collision;
+    displayPixelsStale = true;
+    return collision != 0;
 }
 
+template bool CPU::drawSprite<false>(std::uint8_t x, std::uint8_t y, std::uint8_t height);
+template bool CPU::drawSprite<true>(std::uint8_t x, std::uint8_t y, std::uint8_t height);
+template bool CPU::drawSuperSprite<false>(std::uint8_t x, std::uint8_t y, std::uint8_t height);
+template bool CPU::drawSuperSprite<true>(std::uint8_t x, std::uint8_t y, std::uint8_t height);
+
 // Opcode 0x0XXX implementations
 void CPU::executeOpcode0(std::uint16_t opcode)
 {
+    if ((opcode & 0x00F0) == 0x00C0) // SCD nibble - Scroll display down n rows (SUPER-CHIP)
+    {
+        scrollDown(opcode & 0x000F);
+        programCounter += 2;
+        return;
+    }
+    if ((opcode & 0x00F0) == 0x00D0) // SCU nibble - Scroll display up n rows (XO-CHIP)
+    {
+        scrollUp(opcode & 0x000F);
+        programCounter += 2;
+        return;
+    }
+
     switch (opcode & 0x00FF)
     {
     case 0x00E0: // CLS - Clear display
@@ -162,6 +1342,29 @@ void CPU::executeOpcode0(std::uint16_t opcode)
         programCounter += 2;
         break;
 
+    case 0x00FB: // SCR - Scroll display right 4 pixels (SUPER-CHIP)
+        scrollRight();
+        programCounter += 2;
+        break;
+
+    case 0x00FC: // SCL - Scroll display left 4 pixels (SUPER-CHIP)
+        scrollLeft();
+        programCounter += 2;
+        break;
+
+    case 0x00FD: // EXIT - Stop the interpreter (SUPER-CHIP); PC stays put
+        break;
+
+    case 0x00FE: // LOW - Switch to 64x32 (SUPER-CHIP)
+        setHighResolution(false);
+        programCounter += 2;
+        break;
+
+    case 0x00FF: // HIGH - Switch to 128x64 (SUPER-CHIP)
+        setHighResolution(true);
+        programCounter += 2;
+        break;
+
     case 0x00EE: // RET - Return from subroutine
         if (stackPointer > 0)
         {
@@ -170,13 +1373,13 @@ void CPU::executeOpcode0(std::uint16_t opcode)
         }
         else
         {
-            std::cerr << "Stack underflow!" << std::endl;
+            reportFault(Fault::StackUnderflow, programCounter);
             programCounter += 2;
         }
         break;
 
     default:
-        std::cerr << "Unknown 0x0XXX opcode: 0x" << std::hex << opcode << std::endl;
+        reportFault(Fault::UnknownOpcode, programCounter);
         programCounter += 2;
         break;
     }
@@ -200,7 +1403,7 @@ void CPU::executeOpcode2(std::uint16_t opcode)
     }
     else
     {
-        std::cerr << "Stack overflow!" << std::endl;
+        reportFault(Fault::StackOverflow, programCounter);
         programCounter += 2;
     }
 }
@@ -213,7 +1416,7 @@ void CPU::executeOpcode3(std::uint16_t opcode)
 
     if (registers[regX] == value)
     {
-        programCounter += 4;
+        programCounter += skipLength(programCounter);
     }
     else
     {
@@ -229,7 +1432,7 @@ void CPU::executeOpcode4(std::uint16_t opcode)
 
     if (registers[regX] != value)
     {
-        programCounter += 4;
+        programCounter += skipLength(programCounter);
     }
     else
     {
@@ -237,19 +1440,34 @@ void CPU::executeOpcode4(std::uint16_t opcode)
     }
 }
 
-// 0x5XY0 - SE Vx, Vy - Skip next instruction if Vx == Vy
+// 0x5XYN - Register comparison and XO-CHIP register ranges
 void CPU::executeOpcode5(std::uint16_t opcode)
 {
     std::uint8_t regX = (opcode & 0x0F00) >> 8;
     std::uint8_t regY = (opcode & 0x00F0) >> 4;
 
-    if (registers[regX] == registers[regY])
-    {
-        programCounter += 4;
-    }
-    else
+    switch (opcode & 0x000F)
     {
+    case 0x2: // SAVE Vx - Vy - Store Vx through Vy in memory starting at location I (XO-CHIP)
+        saveRange(regX, regY);
+        programCounter += 2;
+        break;
+
+    case 0x3: // LOAD Vx - Vy - Read Vx through Vy from memory starting at location I (XO-CHIP)
+        loadRange(regX, regY);
         programCounter += 2;
+        break;
+
+    default: // SE Vx, Vy - Skip next instruction if Vx == Vy
+        if (registers[regX] == registers[regY])
+        {
+            programCounter += skipLength(programCounter);
+        }
+        else
+        {
+            programCounter += 2;
+        }
+        break;
     }
 }
 
@@ -288,14 +1506,26 @@ void CPU::executeOpcode8(std::uint16_t opcode)
 
     case 0x1: // OR Vx, Vy - Set Vx = Vx OR Vy
         registers[regX] |= registers[regY];
+        if (quirks & QUIRK_RESET_VF)
+        {
+            registers[0xF] = 0;
+        }
         break;
 
     case 0x2: // AND Vx, Vy - Set Vx = Vx AND Vy
         registers[regX] &= registers[regY];
+        if (quirks & QUIRK_RESET_VF)
+        {
+            registers[0xF] = 0;
+        }
         break;
 
     case 0x3: // XOR Vx, Vy - Set Vx = Vx XOR Vy
         registers[regX] ^= registers[regY];
+        if (quirks & QUIRK_RESET_VF)
+        {
+            registers[0xF] = 0;
+        }
         break;
 
     case 0x4: // ADD Vx, Vy - Set Vx = Vx + Vy, set VF = carry
@@ -311,23 +1541,29 @@ void CPU::executeOpcode8(std::uint16_t opcode)
         registers[regX] -= registers[regY];
         break;
 
-    case 0x6: // SHR Vx {, Vy} - Set Vx = Vx SHR 1
-        registers[0xF] = registers[regX] & 0x1;
-        registers[regX] >>= 1;
-        break;
+    case 0x6: // SHR Vx {, Vy} - Set Vx = Vx SHR 1 (Vy SHR 1 with QUIRK_SHIFT_VY)
+    {
+        const std::uint8_t source = (quirks & QUIRK_SHIFT_VY) ? regY : regX;
+        registers[0xF] = registers[source] & 0x1;
+        registers[regX] = registers[source] >> 1;
+    }
+    break;
 
     case 0x7: // SUBN Vx, Vy - Set Vx = Vy - Vx, set VF = NOT borrow
         registers[0xF] = (registers[regY] > registers[regX]) ? 1 : 0;
         registers[regX] = registers[regY] - registers[regX];
         break;
 
-    case 0xE: // SHL Vx {, Vy} - Set Vx = Vx SHL 1
-        registers[0xF] = (registers[regX] & 0x80) >> 7;
-        registers[regX] <<= 1;
-        break;
+    case 0xE: // SHL Vx {, Vy} - Set Vx = Vx SHL 1 (Vy SHL 1 with QUIRK_SHIFT_VY)
+    {
+        const std::uint8_t source = (quirks & QUIRK_SHIFT_VY) ? regY : regX;
+        registers[0xF] = (registers[source] & 0x80) >> 7;
+        registers[regX] = static_cast<std::uint8_t>(registers[source] << 1);
+    }
+    break;
 
     default:
-        std::cerr << "Unknown 0x8XXX opcode: 0x" << std::hex << opcode << std::endl;
+        reportFault(Fault::UnknownOpcode, programCounter);
         break;
     }
 
@@ -342,7 +1578,7 @@ void CPU::executeOpcode9(std::uint16_t opcode)
 
     if (registers[regX] != registers[regY])
     {
-        programCounter += 4;
+        programCounter += skipLength(programCounter);
     }
     else
     {
@@ -357,11 +1593,12 @@ void CPU::executeOpcodeA(std::uint16_t opcode)
     programCounter += 2;
 }
 
-// 0xBNNN - JP V0, addr - Jump to location NNN + V0
+// 0xBNNN - JP V0, addr - Jump to location NNN + V0 (XNN + VX with QUIRK_JUMP_VX)
 void CPU::executeOpcodeB(std::uint16_t opcode)
 {
     std::uint16_t address = opcode & 0x0FFF;
-    programCounter = address + registers[0];
+    std::uint8_t regX = (quirks & QUIRK_JUMP_VX) ? (opcode & 0x0F00) >> 8 : 0;
+    programCounter = address + registers[regX];
 }
 
 // 0xCXNN - RND Vx, byte - Set Vx = random byte AND NN
@@ -375,13 +1612,16 @@ void CPU::executeOpcodeC(std::uint16_t opcode)
 }
 
 // 0xDXYN - DRW Vx, Vy, nibble - Display n-byte sprite starting at memory location I at (Vx, Vy)
+// (DXY0 draws a 16x16 sprite, SUPER-CHIP)
 void CPU::executeOpcodeD(std::uint16_t opcode)
 {
     std::uint8_t regX = (opcode & 0x0F00) >> 8;
     std::uint8_t regY = (opcode & 0x00F0) >> 4;
     std::uint8_t height = opcode & 0x000F;
 
-    bool collision = drawSprite(registers[regX], registers[regY], height);
+    bool collision = (quirks & QUIRK_CLIP_SPRITES)
+                         ? drawSprite<true>(registers[regX], registers[regY], height)
+                         : drawSprite<false>(registers[regX], registers[regY], height);
     registers[0xF] = collision ? 1 : 0;
 
     programCounter += 2;
@@ -396,9 +1636,9 @@ void CPU::executeOpcodeE(std::uint16_t opcode)
     switch (operation)
     {
     case 0x9E: // SKP Vx - Skip next instruction if key with the value of Vx is pressed
-        if (keys[registers[regX]])
+        if (isKeyHeld(registers[regX]))
         {
-            programCounter += 4;
+            programCounter += skipLength(programCounter);
         }
         else
         {
@@ -407,9 +1647,9 @@ void CPU::executeOpcodeE(std::uint16_t opcode)
         break;
 
     case 0xA1: // SKNP Vx - Skip next instruction if key with the value of Vx is not pressed
-        if (!keys[registers[regX]])
+        if (!isKeyHeld(registers[regX]))
         {
-            programCounter += 4;
+            programCounter += skipLength(programCounter);
         }
         else
         {
@@ -418,7 +1658,7 @@ void CPU::executeOpcodeE(std::uint16_t opcode)
         break;
 
     default:
-        std::cerr << "Unknown 0xEXXX opcode: 0x" << std::hex << opcode << std::endl;
+        reportFault(Fault::UnknownOpcode, programCounter);
         programCounter += 2;
         break;
     }
@@ -432,6 +1672,34 @@ void CPU::executeOpcodeF(std::uint16_t opcode)
 
     switch (operation)
     {
+    case 0x00: // LD I, long NNNN - Set I = the 16-bit word after the instruction (XO-CHIP)
+        if (regX != 0)
+        {
+            reportFault(Fault::UnknownOpcode, programCounter);
+            break;
+        }
+        indexRegister = static_cast<std::uint16_t>((memory->readByte(programCounter + 2) << 8) |
+                                                   memory->readByte(programCounter + 3));
+        programCounter += 4;
+        return;
+
+    case 0x01: // PLANE n - Select the planes drawn, cleared and scrolled (XO-CHIP)
+        selectPlanes(regX);
+        break;
+
+    case 0x02: // AUDIO - Load the 16-byte audio pattern from memory at location I (XO-CHIP)
+        if (regX != 0)
+        {
+            reportFault(Fault::UnknownOpcode, programCounter);
+            break;
+        }
+        checkAccess(indexRegister, AUDIO_PATTERN_SIZE);
+        for (std::size_t i = 0; i < AUDIO_PATTERN_SIZE; ++i)
+        {
+            audioPattern[i] = memory->readByte(static_cast<std::uint16_t>(indexRegister + i));
+        }
+        break;
+
     case 0x07: // LD Vx, DT - Set Vx = delay timer value
         registers[regX] = delayTimer;
         break;
@@ -459,7 +1727,7 @@ void CPU::executeOpcodeF(std::uint16_t opcode)
         delayTimer = registers[regX];
         break;
 
-    case 0x18: // LD ST, Vx - Set sound timer = Vx (not used)
+    case 0x18: // LD ST, Vx - Set sound timer = Vx
         soundTimer = registers[regX];
         break;
 
@@ -471,28 +1739,61 @@ void CPU::executeOpcodeF(std::uint16_t opcode)
         indexRegister = Memory::FONT_START + (registers[regX] * 5);
         break;
 
+    case 0x30: // LD HF, Vx - Set I = location of 8x10 sprite for digit Vx (SUPER-CHIP)
+        indexRegister = Memory::BIG_FONT_START + (registers[regX] * 10);
+        break;
+
     case 0x33: // LD B, Vx - Store BCD representation of Vx in memory locations I, I+1, and I+2
-        memory->writeByte(indexRegister, registers[regX] / 100);
-        memory->writeByte(indexRegister + 1, (registers[regX] / 10) % 10);
-        memory->writeByte(indexRegister + 2, registers[regX] % 10);
+    {
+        checkAccess(indexRegister, 3);
+        const std::uint8_t digits[3] = {static_cast<std::uint8_t>(registers[regX] / 100),
+                                        static_cast<std::uint8_t>((registers[regX] / 10) % 10),
+                                        static_cast<std::uint8_t>(registers[regX] % 10)};
+        memory->writeBytes(indexRegister, digits, 3);
+        break;
+    }
+
+    case 0x3A: // PITCH Vx - Set the audio playback pitch = Vx (XO-CHIP)
+        pitch = registers[regX];
         break;
 
     case 0x55: // LD [I], Vx - Store registers V0 through Vx in memory starting at location I
-        for (std::uint8_t i = 0; i <= regX; ++i)
+        checkAccess(indexRegister, regX + 1u);
+        memory->writeBytes(indexRegister, registers.data(), regX + 1u);
+        if (quirks & QUIRK_INCREMENT_I)
         {
-            memory->writeByte(indexRegister + i, registers[i]);
+            indexRegister += regX + 1;
         }
         break;
 
     case 0x65: // LD Vx, [I] - Read registers V0 through Vx from memory starting at location I
+        checkAccess(indexRegister, regX + 1u);
         for (std::uint8_t i = 0; i <= regX; ++i)
         {
             registers[i] = memory->readByte(indexRegister + i);
         }
+        if (quirks & QUIRK_INCREMENT_I)
+        {
+            indexRegister += regX + 1;
+        }
+        break;
+
+    case 0x75: // LD R, Vx - Store V0 through Vx in the RPL flags (SUPER-CHIP)
+        for (std::uint8_t i = 0; i <= regX; ++i)
+        {
+            flagRegisters[i] = registers[i];
+        }
+        break;
+
+    case 0x85: // LD Vx, R - Read V0 through Vx from the RPL flags (SUPER-CHIP)
+        for (std::uint8_t i = 0; i <= regX; ++i)
+        {
+            registers[i] = flagRegisters[i];
+        }
         break;
 
     default:
-        std::cerr << "Unknown 0xFXXX opcode: 0x" << std::hex << opcode << std::endl;
+        reportFault(Fault::UnknownOpcode, programCounter);
         break;
     }
 
@@ -0,0 +1,684 @@
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <array>
+#include <utility>
+
+/**
+ * @brief Handlers for decoded instructions
+ *
+ * Each handler implements exactly one operation with its operands already
+ * extracted, so there is no second-level switch at execution time. The
+ * semantics must match the reference executeOpcodeN implementations.
+ *
+ * Handlers whose behavior depends on a quirk take the quirk set as a
+ * template parameter; decode() picks the handler table instantiated for
+ * the CPU's quirks, so the checks are resolved at compile time.
+ */
+struct CPU::Ops
+{
+    // Opcodes without a dedicated handler (unknown or rare) go through the
+    // reference interpreter
+    static void fallback(CPU &cpu, const Instruction &in)
+    {
+        cpu.executeOpcode(in.opcode);
+    }
+
+    // 00E0 - CLS
+    static void cls(CPU &cpu, const Instruction &)
+    {
+        cpu.clearDisplay();
+        cpu.programCounter += 2;
+    }
+
+    // 00EE - RET
+    static void ret(CPU &cpu, const Instruction &)
+    {
+        if (cpu.stackPointer > 0)
+        {
+            cpu.stackPointer--;
+            cpu.programCounter = cpu.stack[cpu.stackPointer];
+        }
+        else
+        {
+            cpu.reportFault(Fault::StackUnderflow, cpu.programCounter);
+            cpu.programCounter += 2;
+        }
+    }
+
+    // 1NNN - JP addr
+    static void jp(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter = in.nnn;
+    }
+
+    // 2NNN - CALL addr
+    static void call(CPU &cpu, const Instruction &in)
+    {
+        if (cpu.stackPointer < cpu.stack.size())
+        {
+            cpu.stack[cpu.stackPointer] = cpu.programCounter + 2;
+            cpu.stackPointer++;
+            cpu.programCounter = in.nnn;
+        }
+        else
+        {
+            cpu.reportFault(Fault::StackOverflow, cpu.programCounter);
+            cpu.programCounter += 2;
+        }
+    }
+
+    // 3XNN - SE Vx, byte
+    static void seImm(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter += (cpu.registers[in.x] == in.nn) ? cpu.skipLength(cpu.programCounter) : 2;
+    }
+
+    // 4XNN - SNE Vx, byte
+    static void sneImm(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter += (cpu.registers[in.x] != in.nn) ? cpu.skipLength(cpu.programCounter) : 2;
+    }
+
+    // 5XY0 - SE Vx, Vy
+    static void seReg(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter += (cpu.registers[in.x] == cpu.registers[in.y]) ? cpu.skipLength(cpu.programCounter) : 2;
+    }
+
+    // 6XNN - LD Vx, byte
+    static void ldImm(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] = in.nn;
+        cpu.programCounter += 2;
+    }
+
+    // 7XNN - ADD Vx, byte
+    static void addImm(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] += in.nn;
+        cpu.programCounter += 2;
+    }
+
+    // 8XY0 - LD Vx, Vy
+    static void ldReg(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] = cpu.registers[in.y];
+        cpu.programCounter += 2;
+    }
+
+    // 8XY1 - OR Vx, Vy
+    template <Quirks Q>
+    static void orReg(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] |= cpu.registers[in.y];
+        if constexpr (Q & QUIRK_RESET_VF)
+        {
+            cpu.registers[0xF] = 0;
+        }
+        cpu.programCounter += 2;
+    }
+
+    // 8XY2 - AND Vx, Vy
+    template <Quirks Q>
+    static void andReg(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] &= cpu.registers[in.y];
+        if constexpr (Q & QUIRK_RESET_VF)
+        {
+            cpu.registers[0xF] = 0;
+        }
+        cpu.programCounter += 2;
+    }
+
+    // 8XY3 - XOR Vx, Vy
+    template <Quirks Q>
+    static void xorReg(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] ^= cpu.registers[in.y];
+        if constexpr (Q & QUIRK_RESET_VF)
+        {
+            cpu.registers[0xF] = 0;
+        }
+        cpu.programCounter += 2;
+    }
+
+    // 8XY4 - ADD Vx, Vy (VF = carry)
+    static void addReg(CPU &cpu, const Instruction &in)
+    {
+        std::uint16_t sum = cpu.registers[in.x] + cpu.registers[in.y];
+        cpu.registers[0xF] = (sum > 255) ? 1 : 0;
+        cpu.registers[in.x] = static_cast<std::uint8_t>(sum);
+        cpu.programCounter += 2;
+    }
+
+    // 8XY5 - SUB Vx, Vy (VF = NOT borrow)
+    static void subReg(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[0xF] = (cpu.registers[in.x] > cpu.registers[in.y]) ? 1 : 0;
+        cpu.registers[in.x] -= cpu.registers[in.y];
+        cpu.programCounter += 2;
+    }
+
+    // 8XY6 - SHR Vx {, Vy}
+    template <Quirks Q>
+    static void shr(CPU &cpu, const Instruction &in)
+    {
+        const std::uint8_t source = (Q & QUIRK_SHIFT_VY) ? in.y : in.x;
+        cpu.registers[0xF] = cpu.registers[source] & 0x1;
+        cpu.registers[in.x] = cpu.registers[source] >> 1;
+        cpu.programCounter += 2;
+    }
+
+    // 8XY7 - SUBN Vx, Vy (VF = NOT borrow)
+    static void subn(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[0xF] = (cpu.registers[in.y] > cpu.registers[in.x]) ? 1 : 0;
+        cpu.registers[in.x] = cpu.registers[in.y] - cpu.registers[in.x];
+        cpu.programCounter += 2;
+    }
+
+    // 8XYE - SHL Vx {, Vy}
+    template <Quirks Q>
+    static void shl(CPU &cpu, const Instruction &in)
+    {
+        const std::uint8_t source = (Q & QUIRK_SHIFT_VY) ? in.y : in.x;
+        cpu.registers[0xF] = (cpu.registers[source] & 0x80) >> 7;
+        cpu.registers[in.x] = static_cast<std::uint8_t>(cpu.registers[source] << 1);
+        cpu.programCounter += 2;
+    }
+
+    // 9XY0 - SNE Vx, Vy
+    static void sneReg(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter += (cpu.registers[in.x] != cpu.registers[in.y]) ? cpu.skipLength(cpu.programCounter) : 2;
+    }
+
+    // ANNN - LD I, addr
+    static void ldI(CPU &cpu, const Instruction &in)
+    {
+        cpu.indexRegister = in.nnn;
+        cpu.programCounter += 2;
+    }
+
+    // BNNN - JP V0, addr (BXNN - JP VX, addr)
+    template <Quirks Q>
+    static void jpV0(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter = in.nnn + cpu.registers[(Q & QUIRK_JUMP_VX) ? in.x : 0];
+    }
+
+    // CXNN - RND Vx, byte
+    static void rnd(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] = cpu.generateRandomByte() & in.nn;
+        cpu.programCounter += 2;
+    }
+
+    // DXYN - DRW Vx, Vy, nibble
+    template <Quirks Q>
+    static void drw(CPU &cpu, const Instruction &in)
+    {
+        bool collision = cpu.drawSprite<(Q & QUIRK_CLIP_SPRITES) != 0>(cpu.registers[in.x], cpu.registers[in.y], in.n);
+        cpu.registers[0xF] = collision ? 1 : 0;
+        cpu.programCounter += 2;
+    }
+
+    // EX9E - SKP Vx
+    static void skp(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter += cpu.isKeyHeld(cpu.registers[in.x]) ? cpu.skipLength(cpu.programCounter) : 2;
+    }
+
+    // EXA1 - SKNP Vx
+    static void sknp(CPU &cpu, const Instruction &in)
+    {
+        cpu.programCounter += cpu.isKeyHeld(cpu.registers[in.x]) ? 2 : cpu.skipLength(cpu.programCounter);
+    }
+
+    // FX07 - LD Vx, DT
+    static void ldVxDt(CPU &cpu, const Instruction &in)
+    {
+        cpu.registers[in.x] = cpu.delayTimer;
+        cpu.programCounter += 2;
+    }
+
+    // FX0A - LD Vx, K (PC stays put until a key is pressed)
+    static void ldKey(CPU &cpu, const Instruction &in)
+    {
+        for (std::uint8_t i = 0; i < KEY_COUNT; ++i)
+        {
+            if (cpu.keys[i])
+            {
+                cpu.registers[in.x] = i;
+                cpu.programCounter += 2;
+                return;
+            }
+        }
+    }
+
+    // FX15 - LD DT, Vx
+    static void ldDtVx(CPU &cpu, const Instruction &in)
+    {
+        cpu.delayTimer = cpu.registers[in.x];
+        cpu.programCounter += 2;
+    }
+
+    // FX18 - LD ST, Vx
+    static void ldStVx(CPU &cpu, const Instruction &in)
+    {
+        cpu.soundTimer = cpu.registers[in.x];
+        cpu.programCounter += 2;
+    }
+
+    // FX1E - ADD I, Vx
+    static void addI(CPU &cpu, const Instruction &in)
+    {
+        cpu.indexRegister += cpu.registers[in.x];
+        cpu.programCounter += 2;
+    }
+
+    // FX29 - LD F, Vx
+    static void ldFont(CPU &cpu, const Instruction &in)
+    {
+        cpu.indexRegister = Memory::FONT_START + (cpu.registers[in.x] * 5);
+        cpu.programCounter += 2;
+    }
+
+    // FX33 - LD B, Vx
+    static void bcd(CPU &cpu, const Instruction &in)
+    {
+        std::uint8_t value = cpu.registers[in.x];
+        cpu.checkAccess(cpu.indexRegister, 3);
+        const std::uint8_t digits[3] = {static_cast<std::uint8_t>(value / 100),
+                                        static_cast<std::uint8_t>((value / 10) % 10),
+                                        static_cast<std::uint8_t>(value % 10)};
+        cpu.memory->writeBytes(cpu.indexRegister, digits, 3);
+        cpu.programCounter += 2;
+    }
+
+    // FX55 - LD [I], Vx
+    template <Quirks Q>
+    static void store(CPU &cpu, const Instruction &in)
+    {
+        cpu.checkAccess(cpu.indexRegister, in.x + 1u);
+        cpu.memory->writeBytes(cpu.indexRegister, cpu.registers.data(), in.x + 1u);
+        if constexpr (Q & QUIRK_INCREMENT_I)
+        {
+            cpu.indexRegister += in.x + 1;
+        }
+        cpu.programCounter += 2;
+    }
+
+    // FX65 - LD Vx, [I]
+    template <Quirks Q>
+    static void load(CPU &cpu, const Instruction &in)
+    {
+        cpu.checkAccess(cpu.indexRegister, in.x + 1u);
+        for (std::uint8_t i = 0; i <= in.x; ++i)
+        {
+            cpu.registers[i] = cpu.memory->readByte(cpu.indexRegister + i);
+        }
+        if constexpr (Q & QUIRK_INCREMENT_I)
+        {
+            cpu.indexRegister += in.x + 1;
+        }
+        cpu.programCounter += 2;
+    }
+
+    // 00CN - SCD nibble (SUPER-CHIP)
+    static void scrollDown(CPU &cpu, const Instruction &in)
+    {
+        cpu.scrollDown(in.n);
+        cpu.programCounter += 2;
+    }
+
+    // 00FB - SCR (SUPER-CHIP)
+    static void scrollRight(CPU &cpu, const Instruction &)
+    {
+        cpu.scrollRight();
+        cpu.programCounter += 2;
+    }
+
+    // 00FC - SCL (SUPER-CHIP)
+    static void scrollLeft(CPU &cpu, const Instruction &)
+    {
+        cpu.scrollLeft();
+        cpu.programCounter += 2;
+    }
+
+    // 00FD - EXIT (SUPER-CHIP); the PC stays on the instruction
+    static void exitProgram(CPU &, const Instruction &)
+    {
+    }
+
+    // 00FE - LOW (SUPER-CHIP)
+    static void lores(CPU &cpu, const Instruction &)
+    {
+        cpu.setHighResolution(false);
+        cpu.programCounter += 2;
+    }
+
+    // 00FF - HIGH (SUPER-CHIP)
+    static void hires(CPU &cpu, const Instruction &)
+    {
+        cpu.setHighResolution(true);
+        cpu.programCounter += 2;
+    }
+
+    // FX30 - LD HF, Vx (SUPER-CHIP)
+    static void ldBigFont(CPU &cpu, const Instruction &in)
+    {
+        cpu.indexRegister = Memory::BIG_FONT_START + (cpu.registers[in.x] * 10);
+        cpu.programCounter += 2;
+    }
+
+    // FX75 - LD R, Vx (SUPER-CHIP)
+    static void storeFlags(CPU &cpu, const Instruction &in)
+    {
+        for (std::uint8_t i = 0; i <= in.x; ++i)
+        {
+            cpu.flagRegisters[i] = cpu.registers[i];
+        }
+        cpu.programCounter += 2;
+    }
+
+    // FX85 - LD Vx, R (SUPER-CHIP)
+    static void loadFlags(CPU &cpu, const Instruction &in)
+    {
+        for (std::uint8_t i = 0; i <= in.x; ++i)
+        {
+            cpu.registers[i] = cpu.flagRegisters[i];
+        }
+        cpu.programCounter += 2;
+    }
+
+    // 00DN - SCU nibble (XO-CHIP)
+    static void scrollUp(CPU &cpu, const Instruction &in)
+    {
+        cpu.scrollUp(in.n);
+        cpu.programCounter += 2;
+    }
+
+    // 5XY2 - SAVE Vx - Vy (XO-CHIP)
+    static void saveRange(CPU &cpu, const Instruction &in)
+    {
+        cpu.saveRange(in.x, in.y);
+        cpu.programCounter += 2;
+    }
+
+    // 5XY3 - LOAD Vx - Vy (XO-CHIP)
+    static void loadRange(CPU &cpu, const Instruction &in)
+    {
+        cpu.loadRange(in.x, in.y);
+        cpu.programCounter += 2;
+    }
+
+    // F000 NNNN - LD I, long NNNN (XO-CHIP); the address word is read when
+    // the instruction runs, since a write to it does not touch this entry
+    static void ldILong(CPU &cpu, const Instruction &)
+    {
+        const std::uint16_t pc = cpu.programCounter;
+        cpu.indexRegister = static_cast<std::uint16_t>((cpu.memory->readByte(pc + 2) << 8) |
+                                                       cpu.memory->readByte(pc + 3));
+        cpu.programCounter += 4;
+    }
+
+    // FN01 - PLANE n (XO-CHIP)
+    static void plane(CPU &cpu, const Instruction &in)
+    {
+        cpu.selectPlanes(in.x);
+        cpu.programCounter += 2;
+    }
+
+    // F002 - AUDIO (XO-CHIP)
+    static void audio(CPU &cpu, const Instruction &)
+    {
+        cpu.checkAccess(cpu.indexRegister, AUDIO_PATTERN_SIZE);
+        for (std::size_t i = 0; i < AUDIO_PATTERN_SIZE; ++i)
+        {
+            cpu.audioPattern[i] = cpu.memory->readByte(static_cast<std::uint16_t>(cpu.indexRegister + i));
+        }
+        cpu.programCounter += 2;
+    }
+
+    // FX3A - PITCH Vx (XO-CHIP)
+    static void pitch(CPU &cpu, const Instruction &in)
+    {
+        cpu.pitch = cpu.registers[in.x];
+        cpu.programCounter += 2;
+    }
+
+    using Handler = void (*)(CPU &, const Instruction &);
+
+    // Handler for each Operation, in enum order, for one quirk set
+    template <Quirks Q>
+    struct Table
+    {
+        static constexpr Handler HANDLERS[] = {
+            &fallback, &cls, &ret, &jp, &call,
+            &seImm, &sneImm, &seReg, &ldImm, &addImm,
+            &ldReg, &orReg<Q>, &andReg<Q>, &xorReg<Q>, &addReg,
+            &subReg, &shr<Q>, &subn, &shl<Q>, &sneReg,
+            &ldI, &jpV0<Q>, &rnd, &drw<Q>, &skp,
+            &sknp, &ldVxDt, &ldKey, &ldDtVx, &ldStVx,
+            &addI, &ldFont, &bcd, &store<Q>, &load<Q>,
+            &scrollDown, &scrollRight, &scrollLeft, &exitProgram, &lores,
+            &hires, &ldBigFont, &storeFlags, &loadFlags, &scrollUp,
+            &saveRange, &loadRange, &ldILong, &plane, &audio,
+            &pitch};
+        static_assert(sizeof(HANDLERS) / sizeof(HANDLERS[0]) == static_cast<std::size_t>(Operation::Count),
+                      "HANDLERS must have one entry per Operation");
+    };
+
+    // Handler tables for every quirk combination, indexed by the quirk set
+    template <std::size_t... Q>
+    static constexpr std::array<const Handler *, sizeof...(Q)> makeTables(std::index_sequence<Q...>)
+    {
+        return {{Table<static_cast<Quirks>(Q)>::HANDLERS...}};
+    }
+};
+
+CPU::Instruction CPU::decode(std::uint16_t opcode, Quirks quirks)
+{
+    Instruction in;
+    in.op = Operation::Fallback;
+    in.opcode = opcode;
+    in.nnn = opcode & 0x0FFF;
+    in.x = (opcode & 0x0F00) >> 8;
+    in.y = (opcode & 0x00F0) >> 4;
+    in.n = opcode & 0x000F;
+    in.nn = opcode & 0x00FF;
+
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+        switch (in.nn)
+        {
+        case 0xE0:
+            in.op = Operation::Cls;
+            break;
+        case 0xEE:
+            in.op = Operation::Ret;
+            break;
+        case 0xFB:
+            in.op = Operation::ScrollRight;
+            break;
+        case 0xFC:
+            in.op = Operation::ScrollLeft;
+            break;
+        case 0xFD:
+            in.op = Operation::Exit;
+            break;
+        case 0xFE:
+            in.op = Operation::Lores;
+            break;
+        case 0xFF:
+            in.op = Operation::Hires;
+            break;
+        default:
+            if (in.y == 0xC)
+            {
+                in.op = Operation::ScrollDown;
+            }
+            else if (in.y == 0xD)
+            {
+                in.op = Operation::ScrollUp;
+            }
+            break;
+        }
+        break;
+    case 0x1000:
+        in.op = Operation::Jp;
+        break;
+    case 0x2000:
+        in.op = Operation::Call;
+        break;
+    case 0x3000:
+        in.op = Operation::SeImm;
+        break;
+    case 0x4000:
+        in.op = Operation::SneImm;
+        break;
+    case 0x5000:
+        switch (in.n)
+        {
+        case 0x2:
+            in.op = Operation::SaveRange;
+            break;
+        case 0x3:
+            in.op = Operation::LoadRange;
+            break;
+        default:
+            in.op = Operation::SeReg;
+            break;
+        }
+        break;
+    case 0x6000:
+        in.op = Operation::LdImm;
+        break;
+    case 0x7000:
+        in.op = Operation::AddImm;
+        break;
+    case 0x8000:
+        switch (in.n)
+        {
+        case 0x0:
+            in.op = Operation::LdReg;
+            break;
+        case 0x1:
+            in.op = Operation::OrReg;
+            break;
+        case 0x2:
+            in.op = Operation::AndReg;
+            break;
+        case 0x3:
+            in.op = Operation::XorReg;
+            break;
+        case 0x4:
+            in.op = Operation::AddReg;
+            break;
+        case 0x5:
+            in.op = Operation::SubReg;
+            break;
+        case 0x6:
+            in.op = Operation::Shr;
+            break;
+        case 0x7:
+            in.op = Operation::Subn;
+            break;
+        case 0xE:
+            in.op = Operation::Shl;
+            break;
+        }
+        break;
+    case 0x9000:
+        in.op = Operation::SneReg;
+        break;
+    case 0xA000:
+        in.op = Operation::LdI;
+        break;
+    case 0xB000:
+        in.op = Operation::JpV0;
+        break;
+    case 0xC000:
+        in.op = Operation::Rnd;
+        break;
+    case 0xD000:
+        in.op = Operation::Drw;
+        break;
+    case 0xE000:
+        if (in.nn == 0x9E)
+        {
+            in.op = Operation::Skp;
+        }
+        else if (in.nn == 0xA1)
+        {
+            in.op = Operation::Sknp;
+        }
+        break;
+    case 0xF000:
+        switch (in.nn)
+        {
+        case 0x00:
+            if (in.x == 0)
+            {
+                in.op = Operation::LdILong;
+            }
+            break;
+        case 0x01:
+            in.op = Operation::Plane;
+            break;
+        case 0x02:
+            if (in.x == 0)
+            {
+                in.op = Operation::Audio;
+            }
+            break;
+        case 0x07:
+            in.op = Operation::LdVxDt;
+            break;
+        case 0x0A:
+            in.op = Operation::LdKey;
+            break;
+        case 0x15:
+            in.op = Operation::LdDtVx;
+            break;
+        case 0x18:
+            in.op = Operation::LdStVx;
+            break;
+        case 0x1E:
+            in.op = Operation::AddI;
+            break;
+        case 0x29:
+            in.op = Operation::LdFont;
+            break;
+        case 0x30:
+            in.op = Operation::LdBigFont;
+            break;
+        case 0x33:
+            in.op = Operation::Bcd;
+            break;
+        case 0x3A:
+            in.op = Operation::Pitch;
+            break;
+        case 0x55:
+            in.op = Operation::Store;
+            break;
+        case 0x65:
+            in.op = Operation::Load;
+            break;
+        case 0x75:
+            in.op = Operation::StoreFlags;
+            break;
+        case 0x85:
+            in.op = Operation::LoadFlags;
+            break;
+        }
+        break;
+    }
+
+    static constexpr std::array<const Ops::Handler *, QUIRK_COMBINATIONS> TABLES =
+        Ops::makeTables(std::make_index_sequence<QUIRK_COMBINATIONS>());
+    in.handler = TABLES[quirks & QUIRKS_ALL][static_cast<std::size_t>(in.op)];
+    return in;
+}
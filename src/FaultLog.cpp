@@ -0,0 +1,66 @@
+#include "FaultLog.hpp"
+#include <iomanip>
+
+FaultLog::FaultLog(std::size_t linesPerDrain, std::size_t maxLines)
+    : linesPerDrain(linesPerDrain), maxLines(maxLines)
+{
+}
+
+void FaultLog::drain(CPU &cpu, std::ostream *out, std::vector<CPU::FaultEvent> *events)
+{
+    std::size_t printed = 0;
+    CPU::FaultEvent event;
+    while (cpu.getFaults().tryPop(event))
+    {
+        total++;
+        counts[static_cast<std::size_t>(event.type)]++;
+        if (events)
+        {
+            events->push_back(event);
+        }
+
+        if (!out || printed == linesPerDrain || lines == maxLines)
+        {
+            continue;
+        }
+
+        const auto flags = out->flags();
+        *out << "fault: " << CPU::faultName(event.type) << std::hex << std::setfill('0')
+             << " pc=0x" << std::setw(3) << event.pc
+             << " address=0x" << std::setw(3) << event.address
+             << " opcode=0x" << std::setw(4) << event.opcode << std::setfill(' ') << std::endl;
+        out->flags(flags);
+
+        printed++;
+        lines++;
+        if (lines == maxLines)
+        {
+            *out << "fault: further faults are only counted" << std::endl;
+        }
+    }
+    dropped = cpu.getDroppedFaults();
+}
+
+void FaultLog::writeSummary(std::ostream &out) const
+{
+    out << "faults: " << total + dropped;
+    if (total + dropped != 0)
+    {
+        out << " (";
+        const char *separator = "";
+        for (std::size_t type = 0; type < counts.size(); ++type)
+        {
+            if (counts[type] != 0)
+            {
+                out << separator << CPU::faultName(static_cast<CPU::Fault>(type)) << ": " << counts[type];
+                separator = ", ";
+            }
+        }
+        if (dropped != 0)
+        {
+            out << separator << "lost to a full ring: " << dropped;
+        }
+        out << ")";
+    }
+    out << std::endl;
+}
@@ -1,8 +1,11 @@
 #include "Graphics.hpp"
+#include <cstring>
 #include <iostream>
 
 Graphics::Graphics() : initialized(false)
 {
+    setColors(WHITE, BLACK);
+    setPlaneColors(Color{255, 102, 0, 255}, Color{128, 128, 128, 255});
 }
 
 Graphics::~Graphics()
@@ -13,7 +16,7 @@ Graphics::~Graphics()
     }
 }
 
-bool Graphics::initialize(const char *windowTitle)
+bool Graphics::initialize(const char *windowTitle, bool hidden)
 {
     if (initialized)
     {
@@ -22,13 +25,20 @@ bool Graphics::initialize(const char *windowTitle)
     }
 
     // Initialize Raylib window
+    if (hidden)
+    {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    }
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, windowTitle);
 
     // Set target FPS
     SetTargetFPS(60);
 
-    // Create render target for native CHIP-8 resolution
-    renderTarget = LoadRenderTexture(CHIP8_WIDTH, CHIP8_HEIGHT);
+    // Create texture at the largest CHIP-8 resolution; render() replaces the active area
+    pixels.fill(backgroundColor);
+    Image image = {pixels.data(), MAX_WIDTH, MAX_HEIGHT, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+    screenTexture = LoadTextureFromImage(image);
+    SetTextureFilter(screenTexture, TEXTURE_FILTER_POINT);
 
     initialized = true;
     std::cout << "Graphics initialized: " << SCREEN_WIDTH << "x" << SCREEN_HEIGHT << std::endl;
@@ -42,7 +52,7 @@ void Graphics::shutdown()
         return;
     }
 
-    UnloadRenderTexture(renderTarget);
+    UnloadTexture(screenTexture);
     CloseWindow();
     initialized = false;
     std::cout << "Graphics shutdown" << std::endl;
@@ -54,40 +64,62 @@ bool Graphics::shouldClose() const
     return should_close;
 }
 
-void Graphics::render(const std::uint8_t *displayBuffer)
+void Graphics::render(const std::uint64_t *displayRows, int width, int height, const std::uint64_t *secondPlane)
 {
     if (!initialized)
     {
         return;
     }
 
-    // Render to native resolution target
-    BeginTextureMode(renderTarget);
-    ClearBackground(BLACK);
-
-    for (int y = 0; y < CHIP8_HEIGHT; ++y)
+    // Expand each row one byte (8 pixels) at a time, packed at the active width
+    const int words = width / 64;
+    Color *out = pixels.data();
+    for (int y = 0; y < height; ++y)
     {
-        for (int x = 0; x < CHIP8_WIDTH; ++x)
+        const std::uint64_t *row = &displayRows[y * ROW_WORDS];
+        const std::uint64_t *upper = secondPlane ? &secondPlane[y * ROW_WORDS] : nullptr;
+        std::uint64_t upperLit = 0;
+        for (int w = 0; upper && w < words; ++w)
+        {
+            upperLit |= upper[w];
+        }
+
+        if (upperLit)
         {
-            if (displayBuffer[y * CHIP8_WIDTH + x] != 0)
+            // Both planes: one palette lookup per pixel
+            for (int w = 0; w < words; ++w)
             {
-                DrawPixel(x, y, WHITE);
+                for (int bit = 63; bit >= 0; --bit)
+                {
+                    *out++ = palette[((row[w] >> bit) & 1) | (((upper[w] >> bit) & 1) << 1)];
+                }
+            }
+            continue;
+        }
+
+        for (int w = 0; w < words; ++w)
+        {
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                const auto &group = byteToPixels[(row[w] >> shift) & 0xFF];
+                std::memcpy(out, group.data(), sizeof(group));
+                out += group.size();
             }
         }
     }
 
-    EndTextureMode();
+    // Upload only the active area; the rest of the texture is never sampled
+    const Rectangle area = {0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height)};
+    UpdateTextureRec(screenTexture, area, pixels.data());
 
     // Draw scaled to window
     BeginDrawing();
-    ClearBackground(BLACK);
+    ClearBackground(backgroundColor);
 
     DrawTexturePro(
-        renderTarget.texture,
-        {0.0f, 0.0f, static_cast<float>(renderTarget.texture.width),
-         -static_cast<float>(renderTarget.texture.height)}, // Flip Y
-        {0.0f, 0.0f, static_cast<float>(SCREEN_WIDTH),
-         static_cast<float>(SCREEN_HEIGHT)},
+        screenTexture,
+        area,
+        {0.0f, 0.0f, static_cast<float>(SCREEN_WIDTH), static_cast<float>(SCREEN_HEIGHT)},
         {0.0f, 0.0f},
         0.0f,
         WHITE);
@@ -95,6 +127,41 @@ void Graphics::render(const std::uint8_t *displayBuffer)
     EndDrawing();
 }
 
+void Graphics::setColors(Color foreground, Color background)
+{
+    foregroundColor = foreground;
+    backgroundColor = background;
+    palette[0] = background;
+    palette[1] = foreground;
+
+    for (std::size_t value = 0; value < byteToPixels.size(); ++value)
+    {
+        for (std::size_t bit = 0; bit < 8; ++bit)
+        {
+            byteToPixels[value][bit] = ((value >> (7 - bit)) & 1) ? foreground : background;
+        }
+    }
+}
+
+void Graphics::setPlaneColors(Color second, Color both)
+{
+    palette[2] = second;
+    palette[3] = both;
+}
+
+void Graphics::waitForEvents()
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    // With event waiting on, polling blocks in the window system's event queue
+    EnableEventWaiting();
+    PollInputEvents();
+    DisableEventWaiting();
+}
+
 void Graphics::setTargetFPS(int fps)
 {
     SetTargetFPS(fps);
@@ -110,4 +110,19 @@ bool Input::isKeyPressed(std::uint8_t key) const
         return false;
     }
     return keyStates[key] != 0;
+}
+
+bool Input::isRewindHeld() const
+{
+    return IsKeyDown(KEY_BACKSPACE);
+}
+
+bool Input::isFastForwardHeld() const
+{
+    return IsKeyDown(KEY_TAB);
+}
+
+bool Input::wasSlowMotionToggled() const
+{
+    return IsKeyPressed(KEY_F2);
 }
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include "InputScript.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    // Whole-string unsigned number in the given base
+    bool parseNumber(const std::string &text, int base, std::uint64_t &value)
+    {
+        std::size_t parsed = 0;
+        try
+        {
+            value = std::stoull(text, &parsed, base);
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+        return parsed == text.size() && text[0] != '-';
+    }
+}
+
+bool InputScript::load(const std::string &path, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        error = "cannot open input script: " + path;
+        return false;
+    }
+    return parse(file, error);
+}
+
+bool InputScript::parse(std::istream &in, std::string &error)
+{
+    events.clear();
+    romHash = 0;
+    romHashSet = false;
+    seed = CPU::DEFAULT_RANDOM_SEED;
+    seedSet = false;
+    randomGenerator = CPU::RandomGenerator::Xorshift;
+    randomGeneratorSet = false;
+    quirks = CPU::QUIRKS_NONE;
+    quirksSet = false;
+    cyclesPerFrame = 0;
+    frameCount = 0;
+
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        std::string frameText;
+        std::string keysText;
+        if (!(fields >> frameText))
+        {
+            continue; // Blank or comment-only line
+        }
+
+        if (frameText[0] == '@')
+        {
+            if (!parseDirective(fields, frameText.substr(1), error))
+            {
+                error = "input script line " + std::to_string(lineNumber) + ": " + error;
+                return false;
+            }
+            continue;
+        }
+
+        std::string extra;
+        if (!(fields >> keysText) || (fields >> extra))
+        {
+            error = "input script line " + std::to_string(lineNumber) + ": expected <frame> <keys>";
+            return false;
+        }
+
+        Event event{0, 0};
+        if (!parseNumber(frameText, 10, event.frame))
+        {
+            error = "input script line " + std::to_string(lineNumber) + ": bad frame number";
+            return false;
+        }
+
+        if (keysText != "-")
+        {
+            for (char digit : keysText)
+            {
+                std::size_t key = std::string("0123456789abcdef").find(static_cast<char>(std::tolower(digit)));
+                if (key == std::string::npos)
+                {
+                    error = "input script line " + std::to_string(lineNumber) + ": bad key '" + digit + "'";
+                    return false;
+                }
+                event.keys |= static_cast<std::uint16_t>(1u << key);
+            }
+        }
+
+        if (!events.empty() && event.frame <= events.back().frame)
+        {
+            error = "input script line " + std::to_string(lineNumber) + ": frames must increase";
+            return false;
+        }
+        events.push_back(event);
+    }
+
+    return true;
+}
+
+std::uint16_t InputScript::keyMaskAt(std::uint64_t frame) const
+{
+    // Last event at or before the frame
+    auto next = std::upper_bound(events.begin(), events.end(), frame,
+                                 [](std::uint64_t value, const Event &event)
+                                 { return value < event.frame; });
+    return next == events.begin() ? 0 : std::prev(next)->keys;
+}
+
+void InputScript::apply(std::uint64_t frame, std::array<std::uint8_t, CPU::KEY_COUNT> &keys) const
+{
+    applyKeyMask(keyMaskAt(frame), keys);
+}
+
+bool InputScript::parseDirective(std::istream &fields, const std::string &name, std::string &error)
+{
+    std::string valueText;
+    std::string extra;
+    std::uint64_t value = 0;
+    if (!(fields >> valueText) || (fields >> extra))
+    {
+        error = "expected @" + name + " <value>";
+        return false;
+    }
+
+    if (name == "rom" && parseNumber(valueText, 16, value))
+    {
+        setROMHash(value);
+    }
+    else if (name == "seed" && parseNumber(valueText, 10, value) && value <= UINT32_MAX)
+    {
+        setSeed(static_cast<std::uint32_t>(value));
+    }
+    else if (name == "random" && CPU::parseRandomGenerator(valueText.c_str(), randomGenerator))
+    {
+        randomGeneratorSet = true;
+    }
+    else if (name == "quirks" && CPU::parseQuirks(valueText.c_str(), quirks))
+    {
+        quirksSet = true;
+    }
+    else if (name == "cycles-per-frame" && parseNumber(valueText, 10, value) && value != 0)
+    {
+        cyclesPerFrame = value;
+    }
+    else if (name == "frames" && parseNumber(valueText, 10, value))
+    {
+        frameCount = value;
+    }
+    else
+    {
+        error = "bad directive @" + name + " " + valueText;
+        return false;
+    }
+    return true;
+}
+
+void InputScript::record(std::uint64_t frame, std::uint16_t keyMask)
+{
+    const std::uint16_t current = events.empty() ? 0 : events.back().keys;
+    if (keyMask == current)
+    {
+        return;
+    }
+
+    if (!events.empty() && events.back().frame == frame)
+    {
+        // Changed again within the same frame; the last state wins
+        events.back().keys = keyMask;
+        const std::uint16_t previous = events.size() > 1 ? events[events.size() - 2].keys : 0;
+        if (keyMask == previous)
+        {
+            events.pop_back();
+        }
+        return;
+    }
+    events.push_back({frame, keyMask});
+}
+
+void InputScript::truncate(std::uint64_t frame)
+{
+    while (!events.empty() && events.back().frame >= frame)
+    {
+        events.pop_back();
+    }
+}
+
+bool InputScript::save(const std::string &path, std::string &error) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        error = "cannot create input script: " + path;
+        return false;
+    }
+
+    write(file);
+    if (!file)
+    {
+        error = "failed to write input script: " + path;
+        return false;
+    }
+    return true;
+}
+
+void InputScript::write(std::ostream &out) const
+{
+    if (romHashSet)
+    {
+        out << "@rom " << std::hex << std::setw(16) << std::setfill('0') << romHash
+            << std::dec << std::setfill(' ') << "\n";
+    }
+    if (seedSet)
+    {
+        out << "@seed " << seed << "\n";
+    }
+    if (randomGeneratorSet)
+    {
+        out << "@random " << CPU::randomGeneratorName(randomGenerator) << "\n";
+    }
+    if (quirksSet)
+    {
+        out << "@quirks " << CPU::quirksName(quirks) << "\n";
+    }
+    if (cyclesPerFrame != 0)
+    {
+        out << "@cycles-per-frame " << cyclesPerFrame << "\n";
+    }
+    if (frameCount != 0)
+    {
+        out << "@frames " << frameCount << "\n";
+    }
+
+    for (const Event &event : events)
+    {
+        out << event.frame << " ";
+        if (event.keys == 0)
+        {
+            out << "-";
+        }
+        for (std::size_t key = 0; key < CPU::KEY_COUNT; ++key)
+        {
+            if ((event.keys >> key) & 1)
+            {
+                out << "0123456789abcdef"[key];
+            }
+        }
+        out << "\n";
+    }
+}
+
+std::uint16_t InputScript::keyMaskOf(const std::array<std::uint8_t, CPU::KEY_COUNT> &keys)
+{
+    std::uint16_t mask = 0;
+    for (std::size_t key = 0; key < keys.size(); ++key)
+    {
+        if (keys[key])
+        {
+            mask |= static_cast<std::uint16_t>(1u << key);
+        }
+    }
+    return mask;
+}
+
+void InputScript::setROMHash(std::uint64_t hash)
+{
+    romHash = hash;
+    romHashSet = true;
+}
+
+void InputScript::setSeed(std::uint32_t value)
+{
+    seed = value;
+    seedSet = true;
+}
+
+void InputScript::setRandomGenerator(CPU::RandomGenerator value)
+{
+    randomGenerator = value;
+    randomGeneratorSet = true;
+}
+
+void InputScript::setQuirks(CPU::Quirks value)
+{
+    quirks = value;
+    quirksSet = true;
+}
+
+void InputScript::applyKeyMask(std::uint16_t keyMask, std::array<std::uint8_t, CPU::KEY_COUNT> &keys)
+{
+    for (std::size_t key = 0; key < keys.size(); ++key)
+    {
+        keys[key] = (keyMask >> key) & 1;
+    }
+}
@@ -0,0 +1,1352 @@
+#include "JitBackend.hpp"
+#include "Analyzer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define CHIP8_JIT_SUPPORTED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define CHIP8_JIT_SUPPORTED 0
+#endif
+
+#if CHIP8_JIT_SUPPORTED
+namespace
+{
+    // x86-64 register numbers
+    enum Reg : int
+    {
+        RAX = 0,
+        RCX = 1,
+        RDX = 2,
+        RBX = 3,
+        RSP = 4,
+        RBP = 5,
+        RSI = 6,
+        RDI = 7,
+        R8 = 8,
+        R9 = 9,
+        R10 = 10,
+        R11 = 11,
+        R12 = 12,
+        R13 = 13,
+        R14 = 14,
+        R15 = 15
+    };
+
+    // Condition codes for setcc/cmovcc/jcc
+    enum Cond : std::uint8_t
+    {
+        COND_AE = 0x3,
+        COND_E = 0x4,
+        COND_NE = 0x5,
+        COND_BE = 0x6,
+        COND_A = 0x7
+    };
+
+    // Compiled code keeps the CPU pointer in R15 and uses RAX, RCX and RDX
+    // as scratch; the dispatcher also keeps the entry table in R14 and the
+    // cycle budget in R13. The other host registers can hold guest registers.
+    constexpr int ALLOCATABLE[] = {RBX, RBP, R12, RSI, RDI, R8, R9, R10, R11};
+    constexpr int CALLEE_SAVED[] = {RBX, RBP, R12, R13, R14, R15};
+    constexpr int BASE = R15;
+    constexpr int ENTRIES = R14;
+    constexpr int BUDGET = R13;
+
+    /**
+     * @brief Minimal x86-64 instruction emitter
+     *
+     * Guest values are kept zero-extended in 32-bit registers. Memory
+     * operands are always [R15 + disp32].
+     */
+    class Emitter
+    {
+    public:
+        std::vector<std::uint8_t> bytes;
+
+        void byte(std::uint8_t value) { bytes.push_back(value); }
+
+        void dword(std::uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                byte(static_cast<std::uint8_t>(value >> (8 * i)));
+            }
+        }
+
+        void qword(std::uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                byte(static_cast<std::uint8_t>(value >> (8 * i)));
+            }
+        }
+
+        // REX prefix; force emits it even without extension bits (byte access to SPL/BPL/SIL/DIL)
+        void rex(bool w, int reg, int index, int rm, bool force = false)
+        {
+            std::uint8_t value = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((index & 8) ? 2 : 0) | ((rm & 8) ? 1 : 0);
+            if (value != 0x40 || force)
+            {
+                byte(value);
+            }
+        }
+
+        void modrmReg(int reg, int rm) { byte(static_cast<std::uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7))); }
+
+        void modrmBase(int reg, std::int32_t disp)
+        {
+            // mod=10 (disp32), rm=R15&7 (no SIB needed)
+            byte(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | (BASE & 7)));
+            dword(static_cast<std::uint32_t>(disp));
+        }
+
+        // ModRM and SIB for [base + (index << shift) + disp32]
+        void modrmIndexed(int reg, int base, int index, int shift, std::int32_t disp)
+        {
+            byte(static_cast<std::uint8_t>(0x80 | ((reg & 7) << 3) | 0x04));
+            byte(static_cast<std::uint8_t>((shift << 6) | ((index & 7) << 3) | (base & 7)));
+            dword(static_cast<std::uint32_t>(disp));
+        }
+
+        // mov r32, imm32
+        void movImm(int reg, std::uint32_t imm)
+        {
+            rex(false, 0, 0, reg);
+            byte(static_cast<std::uint8_t>(0xB8 + (reg & 7)));
+            dword(imm);
+        }
+
+        // mov r32, r32
+        void mov(int dst, int src)
+        {
+            if (dst == src)
+            {
+                return;
+            }
+            rex(false, src, 0, dst);
+            byte(0x89);
+            modrmReg(src, dst);
+        }
+
+        // mov r64, r64
+        void mov64(int dst, int src)
+        {
+            rex(true, src, 0, dst);
+            byte(0x89);
+            modrmReg(src, dst);
+        }
+
+        // Two-operand ALU op r32, r32 (0x01 add, 0x09 or, 0x21 and, 0x29 sub, 0x31 xor, 0x39 cmp, 0x85 test)
+        void alu(std::uint8_t opcode, int dst, int src)
+        {
+            rex(false, src, 0, dst);
+            byte(opcode);
+            modrmReg(src, dst);
+        }
+
+        // The same ALU ops on r64, r64
+        void alu64(std::uint8_t opcode, int dst, int src)
+        {
+            rex(true, src, 0, dst);
+            byte(opcode);
+            modrmReg(src, dst);
+        }
+
+        // ALU op r32, imm32 (ext: 0 add, 4 and, 5 sub, 7 cmp)
+        void aluImm(int ext, int reg, std::uint32_t imm)
+        {
+            rex(false, 0, 0, reg);
+            byte(0x81);
+            modrmReg(ext, reg);
+            dword(imm);
+        }
+
+        // The same ALU ops on r64, imm32
+        void aluImm64(int ext, int reg, std::uint32_t imm)
+        {
+            rex(true, 0, 0, reg);
+            byte(0x81);
+            modrmReg(ext, reg);
+            dword(imm);
+        }
+
+        // Shift r32 by one (ext: 4 shl, 5 shr)
+        void shiftOne(int ext, int reg)
+        {
+            rex(false, 0, 0, reg);
+            byte(0xD1);
+            modrmReg(ext, reg);
+        }
+
+        // Shift r32 by imm8 (ext: 4 shl, 5 shr)
+        void shiftImm(int ext, int reg, std::uint8_t amount)
+        {
+            rex(false, 0, 0, reg);
+            byte(0xC1);
+            modrmReg(ext, reg);
+            byte(amount);
+        }
+
+        // imul r32, r32, imm8
+        void imulImm(int dst, int src, std::int8_t imm)
+        {
+            rex(false, dst, 0, src);
+            byte(0x6B);
+            modrmReg(dst, src);
+            byte(static_cast<std::uint8_t>(imm));
+        }
+
+        // movzx r32, byte [R15 + disp]
+        void loadByte(int reg, std::int32_t disp)
+        {
+            rex(false, reg, 0, BASE);
+            byte(0x0F);
+            byte(0xB6);
+            modrmBase(reg, disp);
+        }
+
+        // movzx r32, byte [R15 + index + disp]
+        void loadByteIndexed(int reg, int index, std::int32_t disp)
+        {
+            rex(false, reg, index, BASE);
+            byte(0x0F);
+            byte(0xB6);
+            modrmIndexed(reg, BASE, index, 0, disp);
+        }
+
+        // movzx r32, word [base + (index << shift) + disp]
+        void loadWordIndexed(int reg, int base, int index, int shift, std::int32_t disp)
+        {
+            rex(false, reg, index, base);
+            byte(0x0F);
+            byte(0xB7);
+            modrmIndexed(reg, base, index, shift, disp);
+        }
+
+        // mov r64, qword [base + index + disp]
+        void loadQwordIndexed(int reg, int base, int index, std::int32_t disp)
+        {
+            rex(true, reg, index, base);
+            byte(0x8B);
+            modrmIndexed(reg, base, index, 0, disp);
+        }
+
+        // mov word [R15 + (index << 1) + disp], r16
+        void storeWordIndexed(int index, std::int32_t disp, int reg)
+        {
+            byte(0x66);
+            rex(false, reg, index, BASE);
+            byte(0x89);
+            modrmIndexed(reg, BASE, index, 1, disp);
+        }
+
+        // movzx r32, word [R15 + disp]
+        void loadWord(int reg, std::int32_t disp)
+        {
+            rex(false, reg, 0, BASE);
+            byte(0x0F);
+            byte(0xB7);
+            modrmBase(reg, disp);
+        }
+
+        // mov byte [R15 + disp], r8
+        void storeByte(std::int32_t disp, int reg)
+        {
+            rex(false, reg, 0, BASE, reg >= RSP && reg <= RDI);
+            byte(0x88);
+            modrmBase(reg, disp);
+        }
+
+        // mov word [R15 + disp], r16
+        void storeWord(std::int32_t disp, int reg)
+        {
+            byte(0x66);
+            rex(false, reg, 0, BASE);
+            byte(0x89);
+            modrmBase(reg, disp);
+        }
+
+        // setcc r8 followed by movzx r32, r8 (only used with RAX/RCX/RDX)
+        void setFlag(Cond cond, int reg)
+        {
+            byte(0x0F);
+            byte(static_cast<std::uint8_t>(0x90 + cond));
+            modrmReg(0, reg);
+            byte(0x0F);
+            byte(0xB6);
+            modrmReg(reg, reg);
+        }
+
+        // cmovcc r32, r32
+        void cmov(Cond cond, int dst, int src)
+        {
+            rex(false, dst, 0, src);
+            byte(0x0F);
+            byte(static_cast<std::uint8_t>(0x40 + cond));
+            modrmReg(dst, src);
+        }
+
+        void push(int reg)
+        {
+            rex(false, 0, 0, reg);
+            byte(static_cast<std::uint8_t>(0x50 + (reg & 7)));
+        }
+
+        void pop(int reg)
+        {
+            rex(false, 0, 0, reg);
+            byte(static_cast<std::uint8_t>(0x58 + (reg & 7)));
+        }
+
+        // Call an absolute address through RAX
+        void call(const void *target)
+        {
+            byte(0x48);
+            byte(0xB8);
+            qword(reinterpret_cast<std::uint64_t>(target));
+            byte(0xFF);
+            byte(0xD0);
+        }
+
+        // call r64
+        void callReg(int reg)
+        {
+            rex(false, 0, 0, reg);
+            byte(0xFF);
+            modrmReg(2, reg);
+        }
+
+        void adjustStack(bool grow)
+        {
+            // sub/add rsp, 8
+            byte(0x48);
+            byte(0x83);
+            byte(grow ? 0xEC : 0xC4);
+            byte(0x08);
+        }
+
+        void ret() { byte(0xC3); }
+
+        // jcc rel32 with the target left open; returns where to bind() it
+        std::size_t jumpIf(Cond cond)
+        {
+            byte(0x0F);
+            byte(static_cast<std::uint8_t>(0x80 + cond));
+            dword(0);
+            return bytes.size();
+        }
+
+        // jmp rel32 with the target left open; returns where to bind() it
+        std::size_t jump()
+        {
+            byte(0xE9);
+            dword(0);
+            return bytes.size();
+        }
+
+        // jmp rel32 back to an earlier instruction
+        void jumpBack(std::size_t target)
+        {
+            byte(0xE9);
+            dword(static_cast<std::uint32_t>(target - (bytes.size() + 4)));
+        }
+
+        // Point a jump from jump() or jumpIf() at the next instruction emitted
+        void bind(std::size_t jump)
+        {
+            const std::uint32_t distance = static_cast<std::uint32_t>(bytes.size() - jump);
+            for (int i = 0; i < 4; ++i)
+            {
+                bytes[jump - 4 + i] = static_cast<std::uint8_t>(distance >> (8 * i));
+            }
+        }
+    };
+
+    /**
+     * @brief Field offsets inside CPU, read from a live instance
+     */
+    struct Layout
+    {
+        std::int32_t registers;
+        std::int32_t indexRegister;
+        std::int32_t programCounter;
+        std::int32_t opcode;
+        std::int32_t delayTimer;
+        std::int32_t soundTimer;
+        std::int32_t keys;
+        std::int32_t stack;
+        std::int32_t stackPointer;
+    };
+
+    template <typename T>
+    std::int32_t offsetIn(const void *base, const T *field)
+    {
+        return static_cast<std::int32_t>(reinterpret_cast<const std::uint8_t *>(field) -
+                                         reinterpret_cast<const std::uint8_t *>(base));
+    }
+}
+#endif
+
+JitBackend::JitBackend()
+    : code(nullptr), codeSize(0), dispatcher(nullptr), dispatcherSize(0)
+{
+    entries.fill(Entry{nullptr, 0, 0, false});
+    compiledPages.fill(false);
+
+#if CHIP8_JIT_SUPPORTED
+    void *memory = mmap(nullptr, CODE_BUFFER_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory != MAP_FAILED)
+    {
+        code = static_cast<std::uint8_t *>(memory);
+        setWritable(0, CODE_BUFFER_SIZE, false);
+    }
+#endif
+}
+
+JitBackend::~JitBackend()
+{
+#if CHIP8_JIT_SUPPORTED
+    if (code)
+    {
+        munmap(code, CODE_BUFFER_SIZE);
+    }
+#endif
+}
+
+bool JitBackend::isSupported()
+{
+#if CHIP8_JIT_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool JitBackend::setWritable(std::size_t offset, std::size_t size, bool writable)
+{
+#if CHIP8_JIT_SUPPORTED
+    // Code is never writable and executable at the same time (W^X); only
+    // the pages holding [offset, offset + size) change
+    const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t first = offset / page * page;
+    const std::size_t last = std::min((offset + size + page - 1) / page * page, CODE_BUFFER_SIZE);
+    const int protection = writable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC);
+    return mprotect(code + first, last - first, protection) == 0;
+#else
+    (void)offset;
+    (void)size;
+    (void)writable;
+    return false;
+#endif
+}
+
+const std::uint8_t *JitBackend::install(const std::vector<std::uint8_t> &bytes)
+{
+    if (bytes.size() > CODE_BUFFER_SIZE - codeSize || !setWritable(codeSize, bytes.size(), true))
+    {
+        return nullptr;
+    }
+    std::uint8_t *function = code + codeSize;
+    std::memcpy(function, bytes.data(), bytes.size());
+    setWritable(codeSize, bytes.size(), false);
+    codeSize += bytes.size();
+    return function;
+}
+
+void JitBackend::run(CPU &cpu, std::uint64_t cycles)
+{
+    while (cycles > 0)
+    {
+        const std::uint16_t pc = cpu.programCounter;
+        if (pc >= Memory::MEMORY_SIZE - 1 || !code)
+        {
+            cpu.emulateCycle();
+            cycles--;
+            continue;
+        }
+
+        Entry &entry = entries[pc];
+        if (!entry.function && !entry.uncompilable)
+        {
+            if (entry.hits < HOT_THRESHOLD)
+            {
+                entry.hits++;
+            }
+            else
+            {
+                compile(cpu, pc);
+            }
+        }
+
+        // Cold code and untranslatable instructions run on the decoded interpreter
+        if (!entry.function)
+        {
+            cpu.emulateCycle();
+            cycles--;
+            continue;
+        }
+
+        cycles = dispatcher(&cpu, entries.data(), cycles);
+    }
+}
+
+void JitBackend::invalidate(std::uint16_t address, std::size_t length)
+{
+    const std::size_t reach = MAX_BLOCK_LENGTH * 2 + 2;
+    std::size_t first = address >= reach ? address - reach : 0;
+    std::size_t last = static_cast<std::size_t>(address) + length;
+    if (last > entries.size())
+    {
+        last = entries.size();
+    }
+
+    // Memory notifies every byte FX55 stores; writes to data pages, where
+    // nothing was ever compiled, need no scan
+    bool compiled = false;
+    for (std::size_t page = first / Memory::PAGE_SIZE; page * Memory::PAGE_SIZE < last; ++page)
+    {
+        compiled = compiled || compiledPages[page];
+    }
+    if (!compiled)
+    {
+        return;
+    }
+
+    for (std::size_t start = first; start < last; ++start)
+    {
+        Entry &entry = entries[start];
+        // A block ending in a skip also depends on the first word of the next instruction
+        const std::size_t covered = entry.function ? entry.length * 2 + 2 : 2;
+        if (start + covered > address)
+        {
+            // Compiled code stays in the buffer until the next flush
+            entry = Entry{nullptr, 0, 0, false};
+        }
+    }
+}
+
+void JitBackend::translate(CPU &cpu, const Analyzer &analysis)
+{
+    if (!code)
+    {
+        return;
+    }
+
+    // Native blocks stop before instructions the compiler does not handle
+    // and after memory writes, so one analyzed block may become several,
+    // with interpreted instructions in between
+    for (const Analyzer::Block &block : analysis.getBlocks())
+    {
+        std::size_t i = 0;
+        while (i < block.instructions.size())
+        {
+            Entry &entry = entries[block.instructions[i]];
+            if (!entry.function && !entry.uncompilable)
+            {
+                compile(cpu, block.instructions[i]);
+            }
+            i += entry.function ? entry.length : 1;
+        }
+    }
+}
+
+void JitBackend::flush()
+{
+    entries.fill(Entry{nullptr, 0, 0, false});
+    compiledPages.fill(false);
+    codeSize = dispatcherSize;
+}
+
+void JitBackend::helperClearDisplay(CPU *cpu)
+{
+    cpu->clearDisplay();
+}
+
+template <bool CLIP>
+void JitBackend::helperDraw(CPU *cpu, std::uint32_t x, std::uint32_t y, std::uint32_t height)
+{
+    bool collision = cpu->drawSprite<CLIP>(cpu->registers[x], cpu->registers[y], static_cast<std::uint8_t>(height));
+    cpu->registers[0xF] = collision ? 1 : 0;
+}
+
+void JitBackend::helperSelectPlanes(CPU *cpu, std::uint32_t mask)
+{
+    cpu->selectPlanes(static_cast<std::uint8_t>(mask));
+}
+
+void JitBackend::helperRandom(CPU *cpu, std::uint32_t x, std::uint32_t mask)
+{
+    cpu->registers[x] = cpu->generateRandomByte() & static_cast<std::uint8_t>(mask);
+}
+
+void JitBackend::helperKeyIndex(CPU *cpu)
+{
+    cpu->reportFault(CPU::Fault::KeyIndex, cpu->programCounter);
+}
+
+void JitBackend::helperExecute(CPU *cpu, std::uint32_t opcode)
+{
+    cpu->executeOpcode(static_cast<std::uint16_t>(opcode));
+}
+
+void JitBackend::helperBcd(CPU *cpu, std::uint32_t x)
+{
+    const std::uint8_t value = cpu->registers[x];
+    cpu->checkAccess(cpu->indexRegister, 3);
+    const std::uint8_t digits[3] = {static_cast<std::uint8_t>(value / 100),
+                                    static_cast<std::uint8_t>((value / 10) % 10),
+                                    static_cast<std::uint8_t>(value % 10)};
+    cpu->memory->writeBytes(cpu->indexRegister, digits, 3);
+}
+
+template <bool INCREMENT>
+void JitBackend::helperStore(CPU *cpu, std::uint32_t x)
+{
+    cpu->checkAccess(cpu->indexRegister, x + 1);
+    cpu->memory->writeBytes(cpu->indexRegister, cpu->registers.data(), x + 1);
+    if (INCREMENT)
+    {
+        cpu->indexRegister += x + 1;
+    }
+}
+
+template <bool INCREMENT>
+void JitBackend::helperLoad(CPU *cpu, std::uint32_t x)
+{
+    cpu->checkAccess(cpu->indexRegister, x + 1);
+    for (std::uint32_t i = 0; i <= x; ++i)
+    {
+        cpu->registers[i] = cpu->memory->readByte(cpu->indexRegister + i);
+    }
+    if (INCREMENT)
+    {
+        cpu->indexRegister += x + 1;
+    }
+}
+
+#if CHIP8_JIT_SUPPORTED
+bool JitBackend::buildDispatcher(CPU &cpu)
+{
+    static_assert(sizeof(Entry) == 16, "the dispatcher indexes entries with a shift by 4");
+    const std::int32_t programCounter = offsetIn(&cpu, &cpu.programCounter);
+
+    // Saves the callee-saved registers once for all the blocks it runs;
+    // blocks are entered with R15 = cpu, R14 = entries and R13 = cycles left
+    Emitter e;
+    for (int reg : CALLEE_SAVED)
+    {
+        e.push(reg);
+    }
+    e.adjustStack(true);
+    e.mov64(BASE, RDI);
+    e.mov64(ENTRIES, RSI);
+    e.mov64(BUDGET, RDX);
+
+    // Run the block at the program counter until the budget is used up or
+    // execution reaches code that is not compiled
+    const std::size_t next = e.bytes.size();
+    e.alu64(0x85, BUDGET, BUDGET);
+    const std::size_t spent = e.jumpIf(COND_E);
+    e.loadWord(RAX, programCounter);
+    e.shiftImm(4, RAX, 4);
+    e.loadQwordIndexed(RCX, ENTRIES, RAX, static_cast<std::int32_t>(offsetof(Entry, function)));
+    e.alu64(0x85, RCX, RCX);
+    const std::size_t cold = e.jumpIf(COND_E);
+    e.callReg(RCX);
+    e.jumpBack(next);
+
+    e.bind(spent);
+    e.bind(cold);
+    e.mov64(RAX, BUDGET);
+    e.adjustStack(false);
+    for (int i = static_cast<int>(sizeof(CALLEE_SAVED) / sizeof(CALLEE_SAVED[0])) - 1; i >= 0; --i)
+    {
+        e.pop(CALLEE_SAVED[i]);
+    }
+    e.ret();
+
+    const std::uint8_t *function = install(e.bytes);
+    if (!function)
+    {
+        return false;
+    }
+    dispatcher = reinterpret_cast<Dispatcher>(const_cast<std::uint8_t *>(function));
+    dispatcherSize = codeSize;
+    return true;
+}
+
+void JitBackend::compile(CPU &cpu, std::uint16_t address)
+{
+    using Op = CPU::Operation;
+
+    if (!dispatcher && !buildDispatcher(cpu))
+    {
+        entries[address].uncompilable = true;
+        return;
+    }
+
+    // Collect the block: natively translatable instructions up to and
+    // including the first control flow instruction
+    struct Decoded
+    {
+        CPU::Instruction instruction;
+        std::uint16_t address;
+    };
+    std::vector<Decoded> block;
+    bool terminated = false;
+
+    std::uint16_t pc = address;
+    while (block.size() < MAX_BLOCK_LENGTH && pc < Memory::MEMORY_SIZE - 1)
+    {
+        const std::uint16_t opcode = (cpu.memory->readByte(pc) << 8) | cpu.memory->readByte(pc + 1);
+        const CPU::Instruction instruction = CPU::decode(opcode, cpu.quirks);
+
+        bool supported = true;
+        bool terminator = false;
+        bool store = false;
+        switch (instruction.op)
+        {
+        case Op::Cls:
+        case Op::LdImm:
+        case Op::AddImm:
+        case Op::LdReg:
+        case Op::OrReg:
+        case Op::AndReg:
+        case Op::XorReg:
+        case Op::AddReg:
+        case Op::SubReg:
+        case Op::Shr:
+        case Op::Subn:
+        case Op::Shl:
+        case Op::LdI:
+        case Op::Rnd:
+        case Op::Drw:
+        case Op::LdVxDt:
+        case Op::LdDtVx:
+        case Op::LdStVx:
+        case Op::AddI:
+        case Op::LdFont:
+        case Op::Plane:
+        case Op::Load:
+            break;
+        case Op::Jp:
+        case Op::SeImm:
+        case Op::SneImm:
+        case Op::SeReg:
+        case Op::SneReg:
+        case Op::JpV0:
+        case Op::Skp:
+        case Op::Sknp:
+        case Op::Call:
+        case Op::Ret:
+            terminator = true;
+            break;
+        case Op::Bcd:
+        case Op::Store:
+            // The write may replace the instructions after it
+            store = true;
+            break;
+        default:
+            // Key waits, the other extensions and unknown opcodes are left
+            // to the interpreter
+            supported = false;
+            break;
+        }
+
+        if (!supported)
+        {
+            break;
+        }
+
+        block.push_back({instruction, pc});
+        pc += 2;
+        if (terminator)
+        {
+            terminated = true;
+            break;
+        }
+        if (store)
+        {
+            break;
+        }
+    }
+
+    Entry &entry = entries[address];
+    compiledPages[address / Memory::PAGE_SIZE] = true;
+    if (block.empty())
+    {
+        entry.uncompilable = true;
+        return;
+    }
+
+    const CPU::Quirks quirks = cpu.quirks;
+    const bool resetVF = (quirks & CPU::QUIRK_RESET_VF) != 0;
+
+    // Register the shifts read: VX, or VY with the shift quirk
+    auto shiftSource = [quirks](const CPU::Instruction &in)
+    {
+        return (quirks & CPU::QUIRK_SHIFT_VY) ? in.y : in.x;
+    };
+
+    // Register added to the BNNN target: V0, or VX with the jump quirk
+    auto jumpSource = [quirks](const CPU::Instruction &in)
+    {
+        return (quirks & CPU::QUIRK_JUMP_VX) ? in.x : 0;
+    };
+
+    const Layout layout = {
+        offsetIn(&cpu, cpu.registers.data()),
+        offsetIn(&cpu, &cpu.indexRegister),
+        offsetIn(&cpu, &cpu.programCounter),
+        offsetIn(&cpu, &cpu.opcode),
+        offsetIn(&cpu, &cpu.delayTimer),
+        offsetIn(&cpu, &cpu.soundTimer),
+        offsetIn(&cpu, cpu.keys.data()),
+        offsetIn(&cpu, cpu.stack.data()),
+        offsetIn(&cpu, &cpu.stackPointer),
+    };
+
+    // Count guest register uses (index 16 is I) and keep the busiest in host registers
+    constexpr int GUEST_I = 16;
+    std::array<int, 17> uses{};
+    for (const Decoded &decoded : block)
+    {
+        const CPU::Instruction &in = decoded.instruction;
+        switch (in.op)
+        {
+        case Op::LdImm:
+        case Op::AddImm:
+        case Op::Rnd:
+        case Op::LdVxDt:
+        case Op::LdDtVx:
+        case Op::LdStVx:
+        case Op::SeImm:
+        case Op::SneImm:
+        case Op::Skp:
+        case Op::Sknp:
+            uses[in.x]++;
+            break;
+        case Op::LdReg:
+        case Op::SeReg:
+        case Op::SneReg:
+            uses[in.x]++;
+            uses[in.y]++;
+            break;
+        case Op::OrReg:
+        case Op::AndReg:
+        case Op::XorReg:
+            uses[in.x]++;
+            uses[in.y]++;
+            uses[0xF] += resetVF ? 1 : 0;
+            break;
+        case Op::AddReg:
+        case Op::SubReg:
+        case Op::Subn:
+            uses[in.x] += 2;
+            uses[in.y] += 2;
+            uses[0xF]++;
+            break;
+        case Op::Shr:
+        case Op::Shl:
+            uses[in.x]++;
+            uses[shiftSource(in)]++;
+            uses[0xF]++;
+            break;
+        case Op::LdI:
+            uses[GUEST_I]++;
+            break;
+        case Op::AddI:
+            uses[GUEST_I] += 2;
+            uses[in.x]++;
+            break;
+        case Op::LdFont:
+            uses[GUEST_I]++;
+            uses[in.x]++;
+            break;
+        case Op::JpV0:
+            uses[jumpSource(in)]++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::array<int, 17> order;
+    for (int i = 0; i < 17; ++i)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&uses](int a, int b)
+                     { return uses[a] > uses[b]; });
+
+    std::array<int, 17> hostOf;
+    hostOf.fill(-1);
+    std::size_t allocated = 0;
+    for (int guest : order)
+    {
+        if (allocated == sizeof(ALLOCATABLE) / sizeof(ALLOCATABLE[0]) || uses[guest] < 2)
+        {
+            break;
+        }
+        hostOf[guest] = ALLOCATABLE[allocated++];
+    }
+
+    Emitter e;
+
+    auto guestOffset = [&layout](int guest)
+    {
+        return guest == GUEST_I ? layout.indexRegister : layout.registers + guest;
+    };
+
+    // Read a guest register into a scratch register
+    auto get = [&](int scratch, int guest)
+    {
+        if (hostOf[guest] >= 0)
+        {
+            e.mov(scratch, hostOf[guest]);
+        }
+        else if (guest == GUEST_I)
+        {
+            e.loadWord(scratch, layout.indexRegister);
+        }
+        else
+        {
+            e.loadByte(scratch, guestOffset(guest));
+        }
+    };
+
+    // Write a scratch register (already masked) to a guest register
+    auto set = [&](int guest, int scratch)
+    {
+        if (hostOf[guest] >= 0)
+        {
+            e.mov(hostOf[guest], scratch);
+        }
+        else if (guest == GUEST_I)
+        {
+            e.storeWord(layout.indexRegister, scratch);
+        }
+        else
+        {
+            e.storeByte(guestOffset(guest), scratch);
+        }
+    };
+
+    auto loadAllocated = [&]()
+    {
+        for (int guest = 0; guest < 17; ++guest)
+        {
+            if (hostOf[guest] >= 0)
+            {
+                if (guest == GUEST_I)
+                {
+                    e.loadWord(hostOf[guest], layout.indexRegister);
+                }
+                else
+                {
+                    e.loadByte(hostOf[guest], guestOffset(guest));
+                }
+            }
+        }
+    };
+
+    auto storeAllocated = [&]()
+    {
+        for (int guest = 0; guest < 17; ++guest)
+        {
+            if (hostOf[guest] >= 0)
+            {
+                if (guest == GUEST_I)
+                {
+                    e.storeWord(layout.indexRegister, hostOf[guest]);
+                }
+                else
+                {
+                    e.storeByte(guestOffset(guest), hostOf[guest]);
+                }
+            }
+        }
+    };
+
+    // Helpers see (and may change) guest state in memory
+    auto callHelper = [&](const void *helper, std::uint32_t a, std::uint32_t b, std::uint32_t c)
+    {
+        storeAllocated();
+        e.mov64(RDI, BASE);
+        e.movImm(RSI, a);
+        e.movImm(RDX, b);
+        e.movImm(RCX, c);
+        e.call(helper);
+        loadAllocated();
+    };
+
+    auto setPC = [&](int scratch)
+    {
+        e.storeWord(layout.programCounter, scratch);
+    };
+
+    // Skip: PC = address + 4 (6 over F000 NNNN) if the flags match cond, else address + 2
+    auto skipIf = [&](Cond cond, std::uint16_t at)
+    {
+        e.movImm(RAX, at + 2u);
+        e.movImm(RDX, static_cast<std::uint32_t>(at) + cpu.skipLength(at));
+        e.cmov(cond, RAX, RDX);
+        setPC(RAX);
+    };
+
+    // Prologue: the dispatcher saved the callee-saved registers; keep the
+    // stack 16-byte aligned for helper calls
+    e.adjustStack(true);
+    loadAllocated();
+
+    // Stops the block before instruction k once k instructions used up the
+    // budget (the dispatcher only enters with at least one cycle left)
+    std::vector<std::size_t> budgetExits(block.size(), 0);
+
+    for (std::size_t k = 0; k < block.size(); ++k)
+    {
+        const Decoded &decoded = block[k];
+        const CPU::Instruction &in = decoded.instruction;
+        if (k > 0)
+        {
+            e.aluImm64(7, BUDGET, static_cast<std::uint32_t>(k));
+            budgetExits[k] = e.jumpIf(COND_BE);
+        }
+        switch (in.op)
+        {
+        case Op::Cls:
+            callHelper(reinterpret_cast<const void *>(&JitBackend::helperClearDisplay), 0, 0, 0);
+            break;
+
+        case Op::LdImm:
+            e.movImm(RAX, in.nn);
+            set(in.x, RAX);
+            break;
+
+        case Op::AddImm:
+            if (hostOf[in.x] >= 0)
+            {
+                e.aluImm(0, hostOf[in.x], in.nn);
+                e.aluImm(4, hostOf[in.x], 0xFF);
+            }
+            else
+            {
+                get(RAX, in.x);
+                e.aluImm(0, RAX, in.nn);
+                e.aluImm(4, RAX, 0xFF);
+                set(in.x, RAX);
+            }
+            break;
+
+        case Op::LdReg:
+            get(RAX, in.y);
+            set(in.x, RAX);
+            break;
+
+        case Op::OrReg:
+        case Op::AndReg:
+        case Op::XorReg:
+            get(RAX, in.x);
+            get(RCX, in.y);
+            e.alu(in.op == Op::OrReg ? 0x09 : in.op == Op::AndReg ? 0x21 : 0x31, RAX, RCX);
+            set(in.x, RAX);
+            if (resetVF)
+            {
+                e.movImm(RAX, 0);
+                set(0xF, RAX);
+            }
+            break;
+
+        case Op::AddReg:
+            // VF = carry, then Vx = sum (VF is written first, as in the interpreter)
+            get(RAX, in.x);
+            get(RCX, in.y);
+            e.alu(0x01, RAX, RCX);
+            e.aluImm(7, RAX, 0xFF);
+            e.setFlag(COND_A, RDX);
+            set(0xF, RDX);
+            e.aluImm(4, RAX, 0xFF);
+            set(in.x, RAX);
+            break;
+
+        case Op::SubReg:
+            get(RAX, in.x);
+            get(RCX, in.y);
+            e.alu(0x39, RAX, RCX);
+            e.setFlag(COND_A, RDX);
+            set(0xF, RDX);
+            get(RAX, in.x);
+            get(RCX, in.y);
+            e.alu(0x29, RAX, RCX);
+            e.aluImm(4, RAX, 0xFF);
+            set(in.x, RAX);
+            break;
+
+        case Op::Shr:
+            get(RAX, shiftSource(in));
+            e.aluImm(4, RAX, 0x1);
+            set(0xF, RAX);
+            get(RAX, shiftSource(in));
+            e.shiftOne(5, RAX);
+            set(in.x, RAX);
+            break;
+
+        case Op::Subn:
+            get(RAX, in.y);
+            get(RCX, in.x);
+            e.alu(0x39, RAX, RCX);
+            e.setFlag(COND_A, RDX);
+            set(0xF, RDX);
+            get(RAX, in.y);
+            get(RCX, in.x);
+            e.alu(0x29, RAX, RCX);
+            e.aluImm(4, RAX, 0xFF);
+            set(in.x, RAX);
+            break;
+
+        case Op::Shl:
+            get(RAX, shiftSource(in));
+            e.shiftImm(5, RAX, 7);
+            set(0xF, RAX);
+            get(RAX, shiftSource(in));
+            e.shiftOne(4, RAX);
+            e.aluImm(4, RAX, 0xFF);
+            set(in.x, RAX);
+            break;
+
+        case Op::LdI:
+            e.movImm(RAX, in.nnn);
+            set(GUEST_I, RAX);
+            break;
+
+        case Op::Rnd:
+            callHelper(reinterpret_cast<const void *>(&JitBackend::helperRandom), in.x, in.nn, 0);
+            break;
+
+        case Op::Plane:
+            callHelper(reinterpret_cast<const void *>(&JitBackend::helperSelectPlanes), in.x, 0, 0);
+            break;
+
+        case Op::Drw:
+            // The helpers report faults at the program counter
+            e.movImm(RAX, decoded.address);
+            setPC(RAX);
+            callHelper((quirks & CPU::QUIRK_CLIP_SPRITES)
+                           ? reinterpret_cast<const void *>(&JitBackend::helperDraw<true>)
+                           : reinterpret_cast<const void *>(&JitBackend::helperDraw<false>),
+                       in.x, in.y, in.n);
+            break;
+
+        case Op::LdVxDt:
+            e.loadByte(RAX, layout.delayTimer);
+            set(in.x, RAX);
+            break;
+
+        case Op::LdDtVx:
+            get(RAX, in.x);
+            e.storeByte(layout.delayTimer, RAX);
+            break;
+
+        case Op::LdStVx:
+            get(RAX, in.x);
+            e.storeByte(layout.soundTimer, RAX);
+            break;
+
+        case Op::AddI:
+            get(RAX, GUEST_I);
+            get(RCX, in.x);
+            e.alu(0x01, RAX, RCX);
+            e.aluImm(4, RAX, 0xFFFF);
+            set(GUEST_I, RAX);
+            break;
+
+        case Op::LdFont:
+            get(RAX, in.x);
+            e.imulImm(RAX, RAX, 5);
+            e.aluImm(0, RAX, Memory::FONT_START);
+            set(GUEST_I, RAX);
+            break;
+
+        case Op::Bcd:
+            e.movImm(RAX, decoded.address);
+            setPC(RAX);
+            callHelper(reinterpret_cast<const void *>(&JitBackend::helperBcd), in.x, 0, 0);
+            break;
+
+        case Op::Store:
+            e.movImm(RAX, decoded.address);
+            setPC(RAX);
+            callHelper((quirks & CPU::QUIRK_INCREMENT_I)
+                           ? reinterpret_cast<const void *>(&JitBackend::helperStore<true>)
+                           : reinterpret_cast<const void *>(&JitBackend::helperStore<false>),
+                       in.x, 0, 0);
+            break;
+
+        case Op::Load:
+            e.movImm(RAX, decoded.address);
+            setPC(RAX);
+            callHelper((quirks & CPU::QUIRK_INCREMENT_I)
+                           ? reinterpret_cast<const void *>(&JitBackend::helperLoad<true>)
+                           : reinterpret_cast<const void *>(&JitBackend::helperLoad<false>),
+                       in.x, 0, 0);
+            break;
+
+        case Op::Jp:
+            e.movImm(RAX, in.nnn);
+            setPC(RAX);
+            break;
+
+        case Op::Call:
+        {
+            // Push the return address; a full stack takes the interpreter's fault path
+            e.loadByte(RAX, layout.stackPointer);
+            e.aluImm(7, RAX, static_cast<std::uint32_t>(cpu.stack.size()));
+            const std::size_t full = e.jumpIf(COND_AE);
+            e.movImm(RCX, decoded.address + 2u);
+            e.storeWordIndexed(RAX, layout.stack, RCX);
+            e.aluImm(0, RAX, 1);
+            e.storeByte(layout.stackPointer, RAX);
+            e.movImm(RAX, in.nnn);
+            setPC(RAX);
+            const std::size_t done = e.jump();
+            e.bind(full);
+            e.movImm(RAX, decoded.address);
+            setPC(RAX);
+            callHelper(reinterpret_cast<const void *>(&JitBackend::helperExecute), in.opcode, 0, 0);
+            e.bind(done);
+            break;
+        }
+
+        case Op::Ret:
+        {
+            // Pop the return address; an empty stack takes the interpreter's fault path
+            e.loadByte(RAX, layout.stackPointer);
+            e.alu(0x85, RAX, RAX);
+            const std::size_t empty = e.jumpIf(COND_E);
+            e.aluImm(5, RAX, 1);
+            e.storeByte(layout.stackPointer, RAX);
+            e.loadWordIndexed(RCX, BASE, RAX, 1, layout.stack);
+            setPC(RCX);
+            const std::size_t done = e.jump();
+            e.bind(empty);
+            e.movImm(RAX, decoded.address);
+            setPC(RAX);
+            callHelper(reinterpret_cast<const void *>(&JitBackend::helperExecute), in.opcode, 0, 0);
+            e.bind(done);
+            break;
+        }
+
+        case Op::SeImm:
+        case Op::SneImm:
+            get(RCX, in.x);
+            e.aluImm(7, RCX, in.nn);
+            skipIf(in.op == Op::SeImm ? COND_E : COND_NE, decoded.address);
+            break;
+
+        case Op::SeReg:
+        case Op::SneReg:
+            get(RCX, in.x);
+            get(RDX, in.y);
+            e.alu(0x39, RCX, RDX);
+            skipIf(in.op == Op::SeReg ? COND_E : COND_NE, decoded.address);
+            break;
+
+        case Op::JpV0:
+            get(RAX, jumpSource(in));
+            e.aluImm(0, RAX, in.nnn);
+            setPC(RAX);
+            break;
+
+        case Op::Skp:
+        case Op::Sknp:
+        {
+            // Only the low nibble selects a key; a larger Vx is reported
+            // as a fault first, as in the interpreters
+            get(RAX, in.x);
+            e.aluImm(7, RAX, 0xF);
+            const std::size_t inRange = e.jumpIf(COND_BE);
+            e.movImm(RAX, decoded.address);
+            setPC(RAX);
+            callHelper(reinterpret_cast<const void *>(&JitBackend::helperKeyIndex), 0, 0, 0);
+            get(RAX, in.x);
+            e.bind(inRange);
+            e.aluImm(4, RAX, 0xF);
+            e.loadByteIndexed(RCX, RAX, layout.keys);
+            e.alu(0x85, RCX, RCX);
+            skipIf(in.op == Op::Skp ? COND_NE : COND_E, decoded.address);
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    // Fall through to the next instruction when the block did not end in control flow
+    if (!terminated)
+    {
+        e.movImm(RAX, pc);
+        setPC(RAX);
+    }
+
+    // Leave the opcode of the last instruction run and charge the cycles,
+    // as the interpreter would
+    auto finish = [&](std::size_t count)
+    {
+        e.movImm(RAX, block[count - 1].instruction.opcode);
+        e.storeWord(layout.opcode, RAX);
+        e.aluImm64(5, BUDGET, static_cast<std::uint32_t>(count));
+    };
+    finish(block.size());
+    std::vector<std::size_t> toEpilogue;
+    toEpilogue.push_back(e.jump());
+    for (std::size_t k = 1; k < block.size(); ++k)
+    {
+        e.bind(budgetExits[k]);
+        e.movImm(RAX, block[k].address);
+        setPC(RAX);
+        finish(k);
+        toEpilogue.push_back(e.jump());
+    }
+
+    // Epilogue: back to the dispatcher
+    for (std::size_t jump : toEpilogue)
+    {
+        e.bind(jump);
+    }
+    storeAllocated();
+    e.adjustStack(false);
+    e.ret();
+
+    // Out of space: drop everything and start over
+    if (e.bytes.size() > CODE_BUFFER_SIZE - codeSize)
+    {
+        flush();
+    }
+    const std::uint8_t *function = install(e.bytes);
+    if (!function)
+    {
+        entry.uncompilable = true;
+        return;
+    }
+
+    entry.function = function;
+    entry.length = static_cast<std::uint16_t>(block.size());
+}
+#else
+bool JitBackend::buildDispatcher(CPU &cpu)
+{
+    (void)cpu;
+    return false;
+}
+
+void JitBackend::compile(CPU &cpu, std::uint16_t address)
+{
+    (void)cpu;
+    entries[address].uncompilable = true;
+}
+#endif
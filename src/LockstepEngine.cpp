@@ -0,0 +1,556 @@
+#include "LockstepEngine.hpp"
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Byte vectors with the widest instruction set the build targets.
+    // All operations work lane-wise on unsigned bytes.
+#if defined(__AVX2__)
+    using Vec = __m256i;
+    constexpr std::size_t VEC_BYTES = 32;
+
+    inline Vec load(const std::uint8_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+    inline void store(std::uint8_t *p, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+    inline Vec splat(std::uint8_t value) { return _mm256_set1_epi8(static_cast<char>(value)); }
+    inline Vec add(Vec a, Vec b) { return _mm256_add_epi8(a, b); }
+    inline Vec sub(Vec a, Vec b) { return _mm256_sub_epi8(a, b); }
+    inline Vec subSaturate(Vec a, Vec b) { return _mm256_subs_epu8(a, b); }
+    inline Vec bitAnd(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+    inline Vec bitOr(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+    inline Vec bitXor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+    inline Vec equal(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+    inline Vec maxUnsigned(Vec a, Vec b) { return _mm256_max_epu8(a, b); }
+    inline Vec shiftRight(Vec a, int bits) { return bitAnd(_mm256_srli_epi16(a, bits), splat(static_cast<std::uint8_t>(0xFF >> bits))); }
+    inline Vec select(Vec mask, Vec a, Vec b) { return _mm256_blendv_epi8(b, a, mask); }
+#elif defined(__SSE2__)
+    using Vec = __m128i;
+    constexpr std::size_t VEC_BYTES = 16;
+
+    inline Vec load(const std::uint8_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+    inline void store(std::uint8_t *p, Vec v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+    inline Vec splat(std::uint8_t value) { return _mm_set1_epi8(static_cast<char>(value)); }
+    inline Vec add(Vec a, Vec b) { return _mm_add_epi8(a, b); }
+    inline Vec sub(Vec a, Vec b) { return _mm_sub_epi8(a, b); }
+    inline Vec subSaturate(Vec a, Vec b) { return _mm_subs_epu8(a, b); }
+    inline Vec bitAnd(Vec a, Vec b) { return _mm_and_si128(a, b); }
+    inline Vec bitOr(Vec a, Vec b) { return _mm_or_si128(a, b); }
+    inline Vec bitXor(Vec a, Vec b) { return _mm_xor_si128(a, b); }
+    inline Vec equal(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+    inline Vec maxUnsigned(Vec a, Vec b) { return _mm_max_epu8(a, b); }
+    inline Vec shiftRight(Vec a, int bits) { return bitAnd(_mm_srli_epi16(a, bits), splat(static_cast<std::uint8_t>(0xFF >> bits))); }
+    inline Vec select(Vec mask, Vec a, Vec b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+#else
+    using Vec = std::uint8_t;
+    constexpr std::size_t VEC_BYTES = 1;
+
+    inline Vec load(const std::uint8_t *p) { return *p; }
+    inline void store(std::uint8_t *p, Vec v) { *p = v; }
+    inline Vec splat(std::uint8_t value) { return value; }
+    inline Vec add(Vec a, Vec b) { return static_cast<Vec>(a + b); }
+    inline Vec sub(Vec a, Vec b) { return static_cast<Vec>(a - b); }
+    inline Vec subSaturate(Vec a, Vec b) { return a > b ? static_cast<Vec>(a - b) : 0; }
+    inline Vec bitAnd(Vec a, Vec b) { return a & b; }
+    inline Vec bitOr(Vec a, Vec b) { return a | b; }
+    inline Vec bitXor(Vec a, Vec b) { return a ^ b; }
+    inline Vec equal(Vec a, Vec b) { return a == b ? 0xFF : 0x00; }
+    inline Vec maxUnsigned(Vec a, Vec b) { return a > b ? a : b; }
+    inline Vec shiftRight(Vec a, int bits) { return static_cast<Vec>(a >> bits); }
+    inline Vec select(Vec mask, Vec a, Vec b) { return static_cast<Vec>((mask & a) | (~mask & b)); }
+#endif
+
+    // 0xFF where a > b (unsigned)
+    inline Vec greater(Vec a, Vec b) { return bitXor(equal(maxUnsigned(a, b), b), splat(0xFF)); }
+}
+
+LockstepEngine::LockstepEngine(std::size_t lanes)
+    : laneCount(lanes),
+      laneCapacity((lanes + LANE_ALIGNMENT - 1) / LANE_ALIGNMENT * LANE_ALIGNMENT),
+      registers(16 * laneCapacity, 0),
+      indexRegisters(laneCapacity, 0),
+      programCounters(laneCapacity, 0),
+      delayTimers(laneCapacity, 0),
+      soundTimers(laneCapacity, 0),
+      keyMasks(laneCapacity, 0),
+      groupMask(laneCapacity, 0),
+      groupMaskFull(false),
+      allLanes(lanes),
+      nextInGroup(lanes, NO_LANE),
+      groupHead(0x10000, NO_LANE),
+      seeds(lanes, CPU::DEFAULT_RANDOM_SEED),
+      quirks(CPU::QUIRKS_NONE)
+{
+    static_assert(LANE_ALIGNMENT % VEC_BYTES == 0, "Lane padding must cover whole vectors");
+    for (std::size_t lane = 0; lane < laneCount; ++lane)
+    {
+        allLanes[lane] = static_cast<std::uint32_t>(lane);
+    }
+    createMachines();
+}
+
+void LockstepEngine::createMachines()
+{
+    machines.clear();
+    memories.clear();
+    std::fill(keyMasks.begin(), keyMasks.end(), 0);
+    for (std::size_t lane = 0; lane < laneCount; ++lane)
+    {
+        memories.push_back(std::make_unique<Memory>());
+        machines.push_back(std::make_unique<CPU>(memories.back().get()));
+        machines.back()->setBackend(CPU::Backend::Interpreter);
+        machines.back()->setQuirks(quirks);
+        machines.back()->setRandomGenerator(randomGenerator);
+        machines.back()->setRandomSeed(seeds[lane]);
+        machines.back()->reset();
+        loadLane(lane);
+    }
+
+    for (std::size_t address = 0; address < Memory::MEMORY_SIZE; ++address)
+    {
+        sharedImage[address] = laneCount > 0 ? memories[0]->readByte(static_cast<std::uint16_t>(address)) : 0;
+    }
+    written.fill(false);
+}
+
+bool LockstepEngine::loadROM(const char *filename)
+{
+    // Start from fresh machines so no lane keeps memory from an earlier run
+    createMachines();
+    if (laneCount == 0)
+    {
+        return true;
+    }
+
+    if (!memories[0]->loadROM(filename))
+    {
+        return false;
+    }
+
+    for (std::size_t address = 0; address < Memory::MEMORY_SIZE; ++address)
+    {
+        sharedImage[address] = memories[0]->readByte(static_cast<std::uint16_t>(address));
+    }
+
+    const std::size_t programSize = Memory::MEMORY_SIZE - Memory::PROGRAM_START;
+    for (std::size_t lane = 1; lane < laneCount; ++lane)
+    {
+        memories[lane]->loadProgram(&sharedImage[Memory::PROGRAM_START], programSize);
+    }
+    return true;
+}
+
+void LockstepEngine::setRandomSeed(std::size_t lane, std::uint32_t seed)
+{
+    seeds[lane] = seed;
+    machines[lane]->setRandomSeed(seed);
+    machines[lane]->reset();
+    keyMasks[lane] = 0;
+    loadLane(lane);
+}
+
+void LockstepEngine::setRandomGenerator(CPU::RandomGenerator generator)
+{
+    randomGenerator = generator;
+    for (std::size_t lane = 0; lane < laneCount; ++lane)
+    {
+        machines[lane]->setRandomGenerator(generator);
+        machines[lane]->reset();
+        keyMasks[lane] = 0;
+        loadLane(lane);
+    }
+}
+
+void LockstepEngine::setQuirks(CPU::Quirks newQuirks)
+{
+    quirks = newQuirks & CPU::QUIRKS_ALL;
+    for (const std::unique_ptr<CPU> &machine : machines)
+    {
+        machine->setQuirks(quirks);
+    }
+}
+
+void LockstepEngine::setKeys(std::size_t lane, std::uint16_t keyMask)
+{
+    keyMasks[lane] = keyMask;
+    auto &keys = machines[lane]->keys;
+    for (std::size_t key = 0; key < keys.size(); ++key)
+    {
+        keys[key] = (keyMask >> key) & 1;
+    }
+}
+
+void LockstepEngine::run(std::uint64_t cycles)
+{
+    for (std::uint64_t cycle = 0; cycle < cycles; ++cycle)
+    {
+        step();
+    }
+}
+
+void LockstepEngine::updateTimers()
+{
+    const Vec one = splat(1);
+    for (std::size_t i = 0; i < laneCapacity; i += VEC_BYTES)
+    {
+        store(&delayTimers[i], subSaturate(load(&delayTimers[i]), one));
+        store(&soundTimers[i], subSaturate(load(&soundTimers[i]), one));
+    }
+}
+
+const CPU &LockstepEngine::getMachine(std::size_t lane)
+{
+    storeLane(lane);
+    return *machines[lane];
+}
+
+void LockstepEngine::step()
+{
+    if (laneCount == 0)
+    {
+        return;
+    }
+
+    // Common case: every lane at the same address
+    const std::uint16_t firstPC = programCounters[0];
+    bool converged = true;
+    for (std::size_t lane = 1; lane < laneCount; ++lane)
+    {
+        converged &= programCounters[lane] == firstPC;
+    }
+
+    if (converged)
+    {
+        if (!groupMaskFull)
+        {
+            std::fill(groupMask.begin(), groupMask.begin() + laneCount, 0xFF);
+            groupMaskFull = true;
+        }
+        executeGroup(firstPC, allLanes);
+        return;
+    }
+
+    // Divergent lanes: bucket lanes by PC first (executing a group moves
+    // its PCs), then run one group per distinct PC
+    activePCs.clear();
+    for (std::size_t lane = laneCount; lane-- > 0;)
+    {
+        const std::uint16_t pc = programCounters[lane];
+        if (groupHead[pc] == NO_LANE)
+        {
+            activePCs.push_back(pc);
+        }
+        nextInGroup[lane] = groupHead[pc];
+        groupHead[pc] = static_cast<std::uint32_t>(lane);
+    }
+
+    std::fill(groupMask.begin(), groupMask.end(), 0x00);
+    groupMaskFull = false;
+    for (std::uint16_t pc : activePCs)
+    {
+        groupLanes.clear();
+        for (std::uint32_t lane = groupHead[pc]; lane != NO_LANE; lane = nextInGroup[lane])
+        {
+            groupLanes.push_back(lane);
+            groupMask[lane] = 0xFF;
+        }
+        groupHead[pc] = NO_LANE;
+
+        executeGroup(pc, groupLanes);
+
+        for (std::uint32_t lane : groupLanes)
+        {
+            groupMask[lane] = 0x00;
+        }
+    }
+}
+
+void LockstepEngine::executeGroup(std::uint16_t pc, const std::vector<std::uint32_t> &lanes)
+{
+    using Op = CPU::Operation;
+
+    // Code some lane has overwritten may differ between lanes
+    if (pc >= Memory::MEMORY_SIZE - 1 || written[pc] || written[pc + 1])
+    {
+        for (std::uint32_t lane : lanes)
+        {
+            executeScalar(lane);
+        }
+        return;
+    }
+
+    const std::uint16_t opcode = (sharedImage[pc] << 8) | sharedImage[pc + 1];
+    const CPU::Instruction in = CPU::decode(opcode);
+    const std::uint8_t *vx = row(in.x);
+    const std::uint8_t *vy = row(in.y);
+
+    // A taken skip also jumps over the address word of F000 NNNN (XO-CHIP);
+    // if a lane may have rewritten the next instruction, skips run per lane
+    const std::uint16_t next = static_cast<std::uint16_t>(pc + 2);
+    const std::uint16_t after = static_cast<std::uint16_t>(pc + 3);
+    const bool nextShared = !written[next] && !written[after];
+    const std::uint16_t skip = (sharedImage[next] == 0xF0 && sharedImage[after] == 0x00) ? 6 : 4;
+
+    switch (in.op)
+    {
+    case Op::LdImm:
+    case Op::AddImm:
+    case Op::LdReg:
+    case Op::OrReg:
+    case Op::AndReg:
+    case Op::XorReg:
+    case Op::AddReg:
+    case Op::SubReg:
+    case Op::Shr:
+    case Op::Subn:
+    case Op::Shl:
+    case Op::LdVxDt:
+    case Op::LdDtVx:
+    case Op::LdStVx:
+        executeVector(in);
+        for (std::uint32_t lane : lanes)
+        {
+            programCounters[lane] += 2;
+        }
+        break;
+
+    case Op::LdI:
+    case Op::AddI:
+    case Op::LdFont:
+        for (std::uint32_t lane : lanes)
+        {
+            if (in.op == Op::LdI)
+            {
+                indexRegisters[lane] = in.nnn;
+            }
+            else if (in.op == Op::AddI)
+            {
+                indexRegisters[lane] += vx[lane];
+            }
+            else
+            {
+                indexRegisters[lane] = Memory::FONT_START + (vx[lane] * 5);
+            }
+            programCounters[lane] += 2;
+        }
+        break;
+
+    case Op::Jp:
+    case Op::JpV0:
+    case Op::SeImm:
+    case Op::SneImm:
+    case Op::SeReg:
+    case Op::SneReg:
+        for (std::uint32_t lane : lanes)
+        {
+            if (!nextShared && in.op != Op::Jp && in.op != Op::JpV0)
+            {
+                executeScalar(lane);
+                continue;
+            }
+            switch (in.op)
+            {
+            case Op::Jp:
+                programCounters[lane] = in.nnn;
+                break;
+            case Op::JpV0:
+                programCounters[lane] = in.nnn + row((quirks & CPU::QUIRK_JUMP_VX) ? in.x : 0)[lane];
+                break;
+            case Op::SeImm:
+                programCounters[lane] += (vx[lane] == in.nn) ? skip : 2;
+                break;
+            case Op::SneImm:
+                programCounters[lane] += (vx[lane] != in.nn) ? skip : 2;
+                break;
+            case Op::SeReg:
+                programCounters[lane] += (vx[lane] == vy[lane]) ? skip : 2;
+                break;
+            default:
+                programCounters[lane] += (vx[lane] != vy[lane]) ? skip : 2;
+                break;
+            }
+        }
+        break;
+
+    case Op::Skp:
+    case Op::Sknp:
+        for (std::uint32_t lane : lanes)
+        {
+            if (vx[lane] >= CPU::KEY_COUNT || !nextShared)
+            {
+                // Out-of-range key index or a rewritten next instruction:
+                // leave it to the interpreter
+                executeScalar(lane);
+                continue;
+            }
+            const bool held = (keyMasks[lane] >> vx[lane]) & 1;
+            programCounters[lane] += (held == (in.op == Op::Skp)) ? skip : 2;
+        }
+        break;
+
+    default:
+        // Draws, calls, returns, memory access, random numbers and key
+        // waits use the reference interpreter lane by lane
+        for (std::uint32_t lane : lanes)
+        {
+            executeScalar(lane);
+        }
+        break;
+    }
+}
+
+void LockstepEngine::executeVector(const CPU::Instruction &in)
+{
+    using Op = CPU::Operation;
+
+    std::uint8_t *vx = row(in.x);
+    std::uint8_t *vy = row(in.y);
+    std::uint8_t *vf = row(0xF);
+    const Vec one = splat(1);
+    const bool resetVF = (quirks & CPU::QUIRK_RESET_VF) && (in.op == Op::OrReg || in.op == Op::AndReg || in.op == Op::XorReg);
+    const std::uint8_t *shiftSource = (quirks & CPU::QUIRK_SHIFT_VY) ? vy : vx;
+
+    // Same order of register writes as the interpreter: VF before VX, and
+    // the result reads VX/VY again after VF has been written
+    for (std::size_t i = 0; i < laneCapacity; i += VEC_BYTES)
+    {
+        const Vec mask = load(&groupMask[i]);
+        const Vec x = load(vx + i);
+        const Vec y = load(vy + i);
+
+        switch (in.op)
+        {
+        case Op::LdImm:
+            store(vx + i, select(mask, splat(in.nn), x));
+            break;
+        case Op::AddImm:
+            store(vx + i, select(mask, add(x, splat(in.nn)), x));
+            break;
+        case Op::LdReg:
+            store(vx + i, select(mask, y, x));
+            break;
+        case Op::OrReg:
+            store(vx + i, select(mask, bitOr(x, y), x));
+            break;
+        case Op::AndReg:
+            store(vx + i, select(mask, bitAnd(x, y), x));
+            break;
+        case Op::XorReg:
+            store(vx + i, select(mask, bitXor(x, y), x));
+            break;
+        case Op::AddReg:
+        {
+            // Carry when x > 255 - y
+            const Vec sum = add(x, y);
+            store(vf + i, select(mask, bitAnd(greater(x, bitXor(y, splat(0xFF))), one), load(vf + i)));
+            store(vx + i, select(mask, sum, load(vx + i)));
+            break;
+        }
+        case Op::SubReg:
+        {
+            store(vf + i, select(mask, bitAnd(greater(x, y), one), load(vf + i)));
+            const Vec x2 = load(vx + i);
+            store(vx + i, select(mask, sub(x2, load(vy + i)), x2));
+            break;
+        }
+        case Op::Shr:
+        {
+            store(vf + i, select(mask, bitAnd(load(shiftSource + i), one), load(vf + i)));
+            const Vec x2 = load(vx + i);
+            store(vx + i, select(mask, shiftRight(load(shiftSource + i), 1), x2));
+            break;
+        }
+        case Op::Subn:
+        {
+            store(vf + i, select(mask, bitAnd(greater(y, x), one), load(vf + i)));
+            const Vec x2 = load(vx + i);
+            store(vx + i, select(mask, sub(load(vy + i), x2), x2));
+            break;
+        }
+        case Op::Shl:
+        {
+            store(vf + i, select(mask, shiftRight(load(shiftSource + i), 7), load(vf + i)));
+            const Vec x2 = load(vx + i);
+            const Vec source = load(shiftSource + i);
+            store(vx + i, select(mask, add(source, source), x2));
+            break;
+        }
+        case Op::LdVxDt:
+            store(vx + i, select(mask, load(&delayTimers[i]), x));
+            break;
+        case Op::LdDtVx:
+            store(&delayTimers[i], select(mask, x, load(&delayTimers[i])));
+            break;
+        case Op::LdStVx:
+            store(&soundTimers[i], select(mask, x, load(&soundTimers[i])));
+            break;
+        default:
+            break;
+        }
+
+        if (resetVF)
+        {
+            store(vf + i, select(mask, splat(0), load(vf + i)));
+        }
+    }
+}
+
+void LockstepEngine::executeScalar(std::size_t lane)
+{
+    CPU &cpu = *machines[lane];
+    storeLane(lane);
+
+    // Remember what the lane writes so later fetches from there are per lane
+    // (fetches and writes wrap at the end of memory)
+    const std::uint16_t pc = cpu.programCounter & Memory::ADDRESS_MASK;
+    const std::uint16_t opcode = (cpu.memory->readByte(pc) << 8) | cpu.memory->readByte(pc + 1);
+    const CPU::Instruction in = CPU::decode(opcode);
+    std::size_t length = 0;
+    if (in.op == CPU::Operation::Bcd)
+    {
+        length = 3;
+    }
+    else if (in.op == CPU::Operation::Store)
+    {
+        length = in.x + 1u;
+    }
+    else if (in.op == CPU::Operation::SaveRange)
+    {
+        length = (in.x <= in.y ? in.y - in.x : in.x - in.y) + 1u;
+    }
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        written[(cpu.indexRegister + i) & Memory::ADDRESS_MASK] = true;
+    }
+
+    cpu.interpretCycle();
+    loadLane(lane);
+}
+
+void LockstepEngine::storeLane(std::size_t lane)
+{
+    CPU &cpu = *machines[lane];
+    for (std::uint8_t x = 0; x < 16; ++x)
+    {
+        cpu.registers[x] = row(x)[lane];
+    }
+    cpu.indexRegister = indexRegisters[lane];
+    cpu.programCounter = programCounters[lane];
+    cpu.delayTimer = delayTimers[lane];
+    cpu.soundTimer = soundTimers[lane];
+}
+
+void LockstepEngine::loadLane(std::size_t lane)
+{
+    const CPU &cpu = *machines[lane];
+    for (std::uint8_t x = 0; x < 16; ++x)
+    {
+        row(x)[lane] = cpu.registers[x];
+    }
+    indexRegisters[lane] = cpu.indexRegister;
+    programCounters[lane] = cpu.programCounter;
+    delayTimers[lane] = cpu.delayTimer;
+    soundTimers[lane] = cpu.soundTimer;
+}
@@ -1,7 +1,9 @@
 #include "Memory.hpp"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <cstring>
+#include <vector>
 
 // CHIP-8 font set - each character is 4x5 pixels
 static constexpr std::uint8_t FONT_SET[80] = {
@@ -23,30 +25,80 @@ static constexpr std::uint8_t FONT_SET[80] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
+// SUPER-CHIP large font - each character is 8x10 pixels
+static constexpr std::uint8_t BIG_FONT_SET[160] = {
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+    0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+    0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+    0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+};
+static_assert(Memory::BIG_FONT_START >= Memory::FONT_START + sizeof(FONT_SET) &&
+                  Memory::BIG_FONT_START + sizeof(BIG_FONT_SET) <= Memory::PROGRAM_START,
+              "Fonts must not overlap each other or the program");
+
+// FNV-1a over a program image
+static std::uint64_t hashProgram(const std::uint8_t *data, std::size_t size)
+{
+    std::uint64_t hash = 0xCBF29CE484222325ULL; // FNV offset basis
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3ULL; // FNV prime
+    }
+    return hash;
+}
+
+Memory::Page Memory::zeroPage{{0}, {}};
+
 Memory::Memory()
 {
-    clear();
+    pages.fill(&zeroPage);
     loadFontSet();
 }
 
-std::uint8_t Memory::readByte(std::uint16_t address) const
+Memory::Memory(const Memory &other) : romHash(other.romHash), programSize(other.programSize)
+{
+    for (std::size_t i = 0; i < PAGE_COUNT; ++i)
+    {
+        pages[i] = retain(other.pages[i]);
+    }
+}
+
+Memory &Memory::operator=(const Memory &other)
 {
-    if (address >= MEMORY_SIZE)
+    for (std::size_t i = 0; i < PAGE_COUNT; ++i)
     {
-        std::cerr << "Memory read out of bounds: 0x" << std::hex << address << std::endl;
-        return 0;
+        if (pages[i] != other.pages[i])
+        {
+            Page *previous = pages[i];
+            pages[i] = retain(other.pages[i]);
+            release(previous);
+            notifyWrite(static_cast<std::uint16_t>(i * PAGE_SIZE), PAGE_SIZE);
+        }
     }
-    return ram[address];
+    romHash = other.romHash;
+    programSize = other.programSize;
+    return *this;
 }
 
-void Memory::writeByte(std::uint16_t address, std::uint8_t value)
+Memory::~Memory()
 {
-    if (address >= MEMORY_SIZE)
+    for (Page *page : pages)
     {
-        std::cerr << "Memory write out of bounds: 0x" << std::hex << address << std::endl;
-        return;
+        release(page);
     }
-    ram[address] = value;
 }
 
 bool Memory::loadROM(const char *filename)
@@ -73,8 +125,9 @@ bool Memory::loadROM(const char *filename)
         return false;
     }
 
-    // Load ROM into memory starting at PROGRAM_START
-    if (!file.read(reinterpret_cast<char *>(&ram[PROGRAM_START]), fileSize))
+    // Read the whole ROM before touching memory
+    std::vector<std::uint8_t> rom(static_cast<std::size_t>(fileSize));
+    if (!file.read(reinterpret_cast<char *>(rom.data()), fileSize))
     {
         std::cerr << "Error: Failed to read ROM file" << std::endl;
         file.close();
@@ -82,21 +135,179 @@ bool Memory::loadROM(const char *filename)
     }
 
     file.close();
+    copyIn(PROGRAM_START, rom.data(), rom.size());
+    romHash = hashProgram(rom.data(), rom.size());
+    programSize = rom.size();
+    notifyWrite(PROGRAM_START, rom.size());
     std::cout << "ROM loaded successfully: " << filename
               << " (" << fileSize << " bytes)" << std::endl;
     return true;
 }
 
+bool Memory::loadProgram(const std::uint8_t *data, std::size_t size)
+{
+    if (size > MEMORY_SIZE - PROGRAM_START)
+    {
+        std::cerr << "Error: Program too large. Max size: " << MEMORY_SIZE - PROGRAM_START
+                  << " bytes, program size: " << size << " bytes" << std::endl;
+        return false;
+    }
+
+    copyIn(PROGRAM_START, data, size);
+    romHash = hashProgram(data, size);
+    programSize = size;
+    notifyWrite(PROGRAM_START, size);
+    return true;
+}
+
+void Memory::saveState(std::uint8_t *out) const
+{
+    for (const Page *page : pages)
+    {
+        out = std::copy(page->bytes.begin(), page->bytes.end(), out);
+    }
+}
+
+void Memory::loadState(const std::uint8_t *in)
+{
+    // Compare a page at a time; usually nothing changed, and unchanged
+    // pages stay shared
+    std::size_t first = MEMORY_SIZE;
+    std::size_t last = 0;
+    for (std::size_t i = 0; i < PAGE_COUNT; ++i)
+    {
+        const std::uint8_t *source = in + i * PAGE_SIZE;
+        const std::array<std::uint8_t, PAGE_SIZE> &bytes = pages[i]->bytes;
+        if (std::memcmp(bytes.data(), source, PAGE_SIZE) == 0)
+        {
+            continue;
+        }
+
+        std::size_t low = 0;
+        while (bytes[low] == source[low])
+        {
+            ++low;
+        }
+        std::size_t high = PAGE_SIZE - 1;
+        while (bytes[high] == source[high])
+        {
+            --high;
+        }
+        first = std::min(first, i * PAGE_SIZE + low);
+        last = i * PAGE_SIZE + high;
+
+        Page *page = makeWritable(i);
+        std::copy(source + low, source + high + 1, page->bytes.begin() + low);
+    }
+
+    if (first < MEMORY_SIZE)
+    {
+        notifyWrite(static_cast<std::uint16_t>(first), last - first + 1);
+    }
+}
+
+void Memory::writeBytes(std::uint16_t address, const std::uint8_t *values, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const std::uint16_t target = static_cast<std::uint16_t>(address + i);
+        Page *&page = pages[target / PAGE_SIZE];
+        if (page->references.load(std::memory_order_acquire) != 1)
+        {
+            page = makeWritable(target / PAGE_SIZE);
+        }
+        page->bytes[target % PAGE_SIZE] = values[i];
+    }
+
+    // A store that runs past the end of memory changed two ranges
+    const std::size_t head = std::min(count, MEMORY_SIZE - address);
+    notifyWrite(address, head);
+    if (count > head)
+    {
+        notifyWrite(0, count - head);
+    }
+}
+
 void Memory::clear()
 {
-    ram.fill(0);
+    for (Page *&page : pages)
+    {
+        release(page);
+        page = &zeroPage;
+    }
+    notifyWrite(0, MEMORY_SIZE);
 }
 
-void Memory::loadFontSet()
+bool Memory::operator==(const Memory &other) const
 {
-    // Load font set into memory starting at FONT_START
-    for (std::size_t i = 0; i < sizeof(FONT_SET); ++i)
+    for (std::size_t i = 0; i < PAGE_COUNT; ++i)
+    {
+        if (pages[i] != other.pages[i] && pages[i]->bytes != other.pages[i]->bytes)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+Memory::Page *Memory::makeWritable(std::size_t index)
+{
+    Page *page = pages[index];
+    if (page->references.load(std::memory_order_acquire) == 1)
+    {
+        return page;
+    }
+
+    Page *copy = new Page{{1}, page->bytes};
+    release(page);
+    pages[index] = copy;
+    return copy;
+}
+
+void Memory::copyIn(std::size_t address, const std::uint8_t *data, std::size_t size)
+{
+    while (size > 0)
     {
-        ram[FONT_START + i] = FONT_SET[i];
+        const std::size_t offset = address % PAGE_SIZE;
+        const std::size_t count = std::min(size, PAGE_SIZE - offset);
+        Page *page = makeWritable(address / PAGE_SIZE);
+        std::copy(data, data + count, page->bytes.begin() + offset);
+        address += count;
+        data += count;
+        size -= count;
     }
+}
+
+Memory::Page *Memory::retain(Page *page)
+{
+    if (page != &zeroPage)
+    {
+        page->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    return page;
+}
+
+void Memory::release(Page *page)
+{
+    // The last holder frees the page; acq_rel orders every other holder's
+    // use of it before the delete
+    if (page != &zeroPage && page->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete page;
+    }
+}
+
+void Memory::notifyWrite(std::uint16_t address, std::size_t length)
+{
+    if (observer)
+    {
+        observer->onMemoryWrite(address, length);
+    }
+}
+
+void Memory::loadFontSet()
+{
+    // Load font set into memory starting at FONT_START
+    copyIn(FONT_START, FONT_SET, sizeof(FONT_SET));
+    copyIn(BIG_FONT_START, BIG_FONT_SET, sizeof(BIG_FONT_SET));
 }
\ No newline at end of file
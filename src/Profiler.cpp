@@ -0,0 +1,210 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    // Indexed by CPU::Operation
+    constexpr const char *OPERATION_NAMES[] = {
+        "---- OTHER", "00E0 CLS", "00EE RET", "1NNN JP", "2NNN CALL", "3XNN SE",
+        "4XNN SNE", "5XY0 SE", "6XNN LD", "7XNN ADD", "8XY0 LD", "8XY1 OR",
+        "8XY2 AND", "8XY3 XOR", "8XY4 ADD", "8XY5 SUB", "8XY6 SHR", "8XY7 SUBN",
+        "8XYE SHL", "9XY0 SNE", "ANNN LD", "BNNN JP", "CXNN RND", "DXYN DRW",
+        "EX9E SKP", "EXA1 SKNP", "FX07 LD", "FX0A LD", "FX15 LD", "FX18 LD",
+        "FX1E ADD", "FX29 LD", "FX33 BCD", "FX55 LD", "FX65 LD",
+        "00CN SCD", "00FB SCR", "00FC SCL", "00FD EXIT", "00FE LOW",
+        "00FF HIGH", "FX30 LD", "FX75 LD", "FX85 LD", "00DN SCU",
+        "5XY2 SAVE", "5XY3 LOAD", "F000 LD", "FN01 PLN", "F002 AUD",
+        "FX3A PIT"};
+    static_assert(sizeof(OPERATION_NAMES) / sizeof(OPERATION_NAMES[0]) ==
+                      static_cast<std::size_t>(CPU::Operation::Count),
+                  "One name per operation");
+
+    struct Loop
+    {
+        std::uint16_t start;        // Target of the backward jump
+        std::uint16_t end;          // Address of the backward jump
+        std::uint64_t iterations;   // Times the jump was taken
+        std::uint64_t instructions; // Executions of addresses in [start, end]
+    };
+
+    double percent(std::uint64_t part, std::uint64_t whole)
+    {
+        return whole ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+    }
+}
+
+Profiler::Profiler()
+{
+    // Cost of the two clock reads around every instruction
+    clockOverhead = ~0ULL;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const std::uint64_t start = readClock();
+        clockOverhead = std::min(clockOverhead, readClock() - start);
+    }
+
+    reset();
+}
+
+void Profiler::reset()
+{
+    operations.fill(OperationStats());
+    pcHits.fill(0);
+    backEdges.fill(0);
+    backEdgeTargets.fill(0);
+    startTime = std::chrono::steady_clock::now();
+    startTicks = readClock();
+}
+
+const char *Profiler::operationName(CPU::Operation op)
+{
+    const std::size_t index = static_cast<std::size_t>(op);
+    return index < static_cast<std::size_t>(CPU::Operation::Count) ? OPERATION_NAMES[index] : "?";
+}
+
+std::uint64_t Profiler::getInstructionCount() const
+{
+    std::uint64_t total = 0;
+    for (const OperationStats &stats : operations)
+    {
+        total += stats.count;
+    }
+    return total;
+}
+
+void Profiler::writeReport(std::ostream &out, const Memory &memory, std::size_t top) const
+{
+    const std::uint64_t instructions = getInstructionCount();
+    std::uint64_t totalTicks = 0;
+    for (const OperationStats &stats : operations)
+    {
+        totalTicks += stats.ticks;
+    }
+
+    // Convert clock ticks to nanoseconds using the time since reset()
+    const double elapsedNs = std::chrono::duration<double, std::nano>(
+                                 std::chrono::steady_clock::now() - startTime)
+                                 .count();
+    const std::uint64_t elapsedTicks = readClock() - startTicks;
+    const double nsPerTick = elapsedTicks ? elapsedNs / static_cast<double>(elapsedTicks) : 0.0;
+
+    const auto flags = out.flags();
+    out << std::fixed;
+    out << "CHIP-8 profile" << std::endl;
+    out << "instructions: " << instructions << std::endl;
+    out << "handler_time_ms: " << std::setprecision(3) << totalTicks * nsPerTick / 1e6 << std::endl;
+    out << std::endl;
+
+    // Opcode mix, most executed first
+    std::vector<std::size_t> order;
+    for (std::size_t i = 0; i < operations.size(); ++i)
+    {
+        if (operations[i].count != 0)
+        {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b)
+              { return operations[a].count > operations[b].count; });
+
+    out << "Opcode mix" << std::endl;
+    out << "  operation        count   count%    ns/op   time%" << std::endl;
+    for (std::size_t index : order)
+    {
+        const OperationStats &stats = operations[index];
+        out << "  " << std::left << std::setw(10) << OPERATION_NAMES[index] << std::right
+            << std::setw(13) << stats.count
+            << std::setw(8) << std::setprecision(2) << percent(stats.count, instructions) << "%"
+            << std::setw(9) << std::setprecision(2) << stats.ticks * nsPerTick / static_cast<double>(stats.count)
+            << std::setw(7) << std::setprecision(2) << percent(stats.ticks, totalTicks) << "%" << std::endl;
+    }
+    out << std::endl;
+
+    // Hot PCs
+    std::vector<std::uint16_t> pcs;
+    for (std::size_t pc = 0; pc < pcHits.size(); ++pc)
+    {
+        if (pcHits[pc] != 0)
+        {
+            pcs.push_back(static_cast<std::uint16_t>(pc));
+        }
+    }
+    std::sort(pcs.begin(), pcs.end(), [this](std::uint16_t a, std::uint16_t b)
+              { return pcHits[a] > pcHits[b]; });
+    if (pcs.size() > top)
+    {
+        pcs.resize(top);
+    }
+
+    out << "Hot PCs" << std::endl;
+    out << "  pc     opcode  operation          hits     hits%" << std::endl;
+    for (std::uint16_t pc : pcs)
+    {
+        const std::uint16_t opcode = static_cast<std::uint16_t>(
+            (memory.readByte(pc) << 8) |
+            (static_cast<std::size_t>(pc) + 1 < Memory::MEMORY_SIZE ? memory.readByte(pc + 1) : 0));
+        out << "  0x" << std::hex << std::setfill('0') << std::setw(3) << pc
+            << "  " << std::setw(4) << opcode << std::dec << std::setfill(' ')
+            << "    " << std::left << std::setw(10) << operationName(CPU::decode(opcode).op) << std::right
+            << std::setw(13) << pcHits[pc]
+            << std::setw(9) << std::setprecision(2) << percent(pcHits[pc], instructions) << "%" << std::endl;
+    }
+    out << std::endl;
+
+    // Hot loops: the body of a backward jump is everything from its target to the jump
+    std::vector<Loop> loops;
+    for (std::size_t pc = 0; pc < backEdges.size(); ++pc)
+    {
+        if (backEdges[pc] == 0)
+        {
+            continue;
+        }
+        Loop loop{backEdgeTargets[pc], static_cast<std::uint16_t>(pc), backEdges[pc], 0};
+        for (std::size_t address = loop.start; address <= loop.end; ++address)
+        {
+            loop.instructions += pcHits[address];
+        }
+        loops.push_back(loop);
+    }
+    std::sort(loops.begin(), loops.end(), [](const Loop &a, const Loop &b)
+              { return a.instructions > b.instructions; });
+    if (loops.size() > top)
+    {
+        loops.resize(top);
+    }
+
+    out << "Hot loops" << std::endl;
+    out << "  range          iterations  instructions  instructions%" << std::endl;
+    for (const Loop &loop : loops)
+    {
+        out << "  0x" << std::hex << std::setfill('0') << std::setw(3) << loop.start
+            << "-0x" << std::setw(3) << loop.end << std::dec << std::setfill(' ')
+            << std::setw(14) << loop.iterations
+            << std::setw(14) << loop.instructions
+            << std::setw(14) << std::setprecision(2) << percent(loop.instructions, instructions) << "%" << std::endl;
+    }
+
+    out.flags(flags);
+}
+
+bool Profiler::saveReport(const std::string &path, const Memory &memory, std::string &error) const
+{
+    if (path == "-")
+    {
+        writeReport(std::cout, memory);
+        return true;
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        error = "cannot create profile report: " + path;
+        return false;
+    }
+    writeReport(file, memory);
+    return true;
+}
@@ -0,0 +1,376 @@
+#include "Recompiler.hpp"
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+    using Op = CPU::Operation;
+
+    std::string hex(std::uint32_t value, int digits)
+    {
+        std::ostringstream text;
+        text << "0x" << std::uppercase << std::hex << std::setfill('0') << std::setw(digits) << value;
+        return text.str();
+    }
+
+    // V register as an element of the state's register array
+    std::string reg(std::uint8_t index)
+    {
+        return "v[" + hex(index & 0xF, 1) + "]";
+    }
+
+    // Instructions that end a block by setting the program counter
+    bool isTerminator(Op op)
+    {
+        switch (op)
+        {
+        case Op::Jp:
+        case Op::SeImm:
+        case Op::SneImm:
+        case Op::SeReg:
+        case Op::SneReg:
+        case Op::JpV0:
+        case Op::Skp:
+        case Op::Sknp:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool isSkip(Op op)
+    {
+        return isTerminator(op) && op != Op::Jp && op != Op::JpV0;
+    }
+}
+
+bool Recompiler::isNative(CPU::Operation op)
+{
+    switch (op)
+    {
+    case Op::Cls:
+    case Op::LdImm:
+    case Op::AddImm:
+    case Op::LdReg:
+    case Op::OrReg:
+    case Op::AndReg:
+    case Op::XorReg:
+    case Op::AddReg:
+    case Op::SubReg:
+    case Op::Shr:
+    case Op::Subn:
+    case Op::Shl:
+    case Op::LdI:
+    case Op::Rnd:
+    case Op::Drw:
+    case Op::LdVxDt:
+    case Op::LdDtVx:
+    case Op::LdStVx:
+    case Op::AddI:
+    case Op::LdFont:
+    case Op::Plane:
+    case Op::Load:
+        return true;
+    default:
+        return isTerminator(op);
+    }
+}
+
+void Recompiler::recompile(const Memory &memory, const Analyzer &analysis, CPU::Quirks newQuirks)
+{
+    blocks.clear();
+    interpreted = 0;
+    quirks = newQuirks;
+
+    // Split every analyzed block into runs of native instructions; the
+    // instructions in between run on the interpreter
+    for (const Analyzer::Block &analyzed : analysis.getBlocks())
+    {
+        Block block{0, 0, {}};
+        auto finish = [this, &block]()
+        {
+            if (!block.instructions.empty())
+            {
+                blocks.push_back(block);
+                block.instructions.clear();
+            }
+        };
+
+        for (std::uint16_t address : analyzed.instructions)
+        {
+            const Op op = CPU::decode(memory.readWord(address), quirks).op;
+            if (!isNative(op))
+            {
+                finish();
+                interpreted++;
+                continue;
+            }
+
+            if (block.instructions.empty())
+            {
+                block.start = address;
+            }
+            block.instructions.push_back(address);
+
+            // A skip also depends on the first word of the instruction it skips
+            const std::uint32_t end = static_cast<std::uint32_t>(address) + (isSkip(op) ? 4 : 2);
+            block.size = static_cast<std::uint16_t>(end - block.start);
+            if (isTerminator(op) || block.instructions.size() == MAX_BLOCK_LENGTH)
+            {
+                finish();
+            }
+        }
+        finish();
+    }
+}
+
+void Recompiler::writeInstruction(std::ostream &out, const Memory &memory, std::uint16_t address) const
+{
+    const CPU::Instruction in = CPU::decode(memory.readWord(address), quirks);
+    const std::uint16_t next = static_cast<std::uint16_t>(address + 2);
+    const bool overLong = memory.readByte(static_cast<std::uint16_t>(address + 2)) == 0xF0 &&
+                          memory.readByte(static_cast<std::uint16_t>(address + 3)) == 0x00;
+    const std::string skipped = hex(static_cast<std::uint16_t>(address + (overLong ? 6 : 4)), 3);
+    const std::string vx = reg(in.x);
+    const std::string vy = reg(in.y);
+    const std::string shifted = reg((quirks & CPU::QUIRK_SHIFT_VY) ? in.y : in.x);
+    const bool resetVF = (quirks & CPU::QUIRK_RESET_VF) != 0;
+
+    // Each statement mirrors the decoded handler, in the same order
+    std::vector<std::string> lines;
+    switch (in.op)
+    {
+    case Op::Cls:
+        lines = {"s->clearDisplay(s);"};
+        break;
+    case Op::LdImm:
+        lines = {vx + " = " + hex(in.nn, 2) + ";"};
+        break;
+    case Op::AddImm:
+        lines = {vx + " += " + hex(in.nn, 2) + ";"};
+        break;
+    case Op::LdReg:
+        lines = {vx + " = " + vy + ";"};
+        break;
+    case Op::OrReg:
+    case Op::AndReg:
+    case Op::XorReg:
+    {
+        const char *assign = in.op == Op::OrReg ? " |= " : in.op == Op::AndReg ? " &= " : " ^= ";
+        lines = {vx + assign + vy + ";"};
+        if (resetVF)
+        {
+            lines.push_back("v[0xF] = 0;");
+        }
+        break;
+    }
+    case Op::AddReg:
+        lines = {"sum = " + vx + " + " + vy + ";",
+                 "v[0xF] = sum > 255 ? 1 : 0;",
+                 vx + " = static_cast<std::uint8_t>(sum);"};
+        break;
+    case Op::SubReg:
+        lines = {"v[0xF] = " + vx + " > " + vy + " ? 1 : 0;",
+                 vx + " -= " + vy + ";"};
+        break;
+    case Op::Shr:
+        lines = {"v[0xF] = " + shifted + " & 0x1;",
+                 vx + " = " + shifted + " >> 1;"};
+        break;
+    case Op::Subn:
+        lines = {"v[0xF] = " + vy + " > " + vx + " ? 1 : 0;",
+                 vx + " = static_cast<std::uint8_t>(" + vy + " - " + vx + ");"};
+        break;
+    case Op::Shl:
+        lines = {"v[0xF] = (" + shifted + " & 0x80) >> 7;",
+                 vx + " = static_cast<std::uint8_t>(" + shifted + " << 1);"};
+        break;
+    case Op::LdI:
+        lines = {"s->indexRegister = " + hex(in.nnn, 3) + ";"};
+        break;
+    case Op::Rnd:
+        lines = {"s->random(s, " + hex(in.x, 1) + ", " + hex(in.nn, 2) + ");"};
+        break;
+    case Op::Drw:
+        lines = {"s->draw(s, " + hex(address, 3) + ", " + hex(in.x, 1) + ", " + hex(in.y, 1) + ", " +
+                 std::to_string(in.n) + ");"};
+        break;
+    case Op::LdVxDt:
+        lines = {vx + " = s->delayTimer;"};
+        break;
+    case Op::LdDtVx:
+        lines = {"s->delayTimer = " + vx + ";"};
+        break;
+    case Op::LdStVx:
+        lines = {"s->soundTimer = " + vx + ";"};
+        break;
+    case Op::AddI:
+        lines = {"s->indexRegister += " + vx + ";"};
+        break;
+    case Op::LdFont:
+        lines = {"s->indexRegister = static_cast<std::uint16_t>(" + hex(Memory::FONT_START, 2) + " + " + vx +
+                 " * 5);"};
+        break;
+    case Op::Plane:
+        lines = {"s->selectPlanes(s, " + hex(in.x, 1) + ");"};
+        break;
+    case Op::Load:
+        lines = {"s->load(s, " + hex(address, 3) + ", " + hex(in.x, 1) + ");"};
+        break;
+    case Op::Jp:
+        lines = {"s->programCounter = " + hex(in.nnn, 3) + ";"};
+        break;
+    case Op::SeImm:
+    case Op::SneImm:
+        lines = {"s->programCounter = " + vx + (in.op == Op::SeImm ? " == " : " != ") + hex(in.nn, 2) + " ? " +
+                 skipped + " : " + hex(next, 3) + ";"};
+        break;
+    case Op::SeReg:
+    case Op::SneReg:
+        lines = {"s->programCounter = " + vx + (in.op == Op::SeReg ? " == " : " != ") + vy + " ? " + skipped +
+                 " : " + hex(next, 3) + ";"};
+        break;
+    case Op::JpV0:
+        lines = {"s->programCounter = static_cast<std::uint16_t>(" + hex(in.nnn, 3) + " + " +
+                 reg((quirks & CPU::QUIRK_JUMP_VX) ? in.x : 0) + ");"};
+        break;
+    case Op::Skp:
+        lines = {"if (" + vx + " > 0xF) s->keyIndex(s, " + hex(address, 3) + ");",
+                 "s->programCounter = s->keys[" + vx + " & 0xF] ? " + skipped + " : " + hex(next, 3) + ";"};
+        break;
+    case Op::Sknp:
+        lines = {"if (" + vx + " > 0xF) s->keyIndex(s, " + hex(address, 3) + ");",
+                 "s->programCounter = s->keys[" + vx + " & 0xF] ? " + hex(next, 3) + " : " + skipped + ";"};
+        break;
+    default:
+        break;
+    }
+
+    std::ostringstream comment;
+    comment << std::uppercase << std::hex << std::setfill('0') << std::setw(4) << address << "  "
+            << std::setw(4) << memory.readWord(address) << "  " << Analyzer::disassemble(memory, address);
+    out << "            // " << comment.str() << "\n";
+    for (const std::string &line : lines)
+    {
+        out << "            " << line << "\n";
+    }
+}
+
+void Recompiler::writeSource(std::ostream &out, const Memory &memory, const std::string &name) const
+{
+    std::size_t instructions = 0;
+    for (const Block &block : blocks)
+    {
+        instructions += block.instructions.size();
+    }
+
+    out << "// Generated by chip8_recompile from " << name << "; do not edit.\n"
+        << "// ROM hash " << std::hex << std::setfill('0') << std::setw(16) << memory.getROMHash() << std::dec
+        << std::setfill(' ') << ", quirks " << CPU::quirksName(quirks) << ": " << blocks.size() << " blocks, "
+        << instructions << " instructions (" << interpreted << " left to the interpreter).\n"
+        << "//\n"
+        << "// Build it as a shared object and run it with the aot backend, e.g.\n"
+        << "//   c++ -std=c++17 -O2 -shared -fPIC -I <emulator>/include module.cpp -o module.so\n"
+        << "//   chip8_headless rom.ch8 --backend aot --module ./module.so\n"
+        << "\n"
+        << "#include \"AotAbi.hpp\"\n"
+        << "\n"
+        << "namespace\n"
+        << "{\n";
+
+    if (!blocks.empty())
+    {
+        // The bytes each block was translated from, checked before it runs
+        out << "    const std::uint8_t BYTES[] = {";
+        std::size_t count = 0;
+        for (const Block &block : blocks)
+        {
+            for (std::uint16_t i = 0; i < block.size; ++i)
+            {
+                out << (count % 16 == 0 ? "\n        " : " ")
+                    << hex(memory.readByte(static_cast<std::uint16_t>(block.start + i)), 2) << ",";
+                count++;
+            }
+        }
+        out << "\n    };\n";
+    }
+
+    for (const Block &block : blocks)
+    {
+        // Cases enter the block at each instruction; each instruction but
+        // the last returns once the budget is spent
+        std::ostringstream body;
+        const std::size_t length = block.instructions.size();
+        for (std::size_t i = 0; i < length; ++i)
+        {
+            const std::uint16_t address = block.instructions[i];
+            const std::string next = hex(static_cast<std::uint16_t>(address + 2), 3);
+            body << "        case " << i << ":\n";
+            writeInstruction(body, memory, address);
+            if (i + 1 < length)
+            {
+                body << "            if (++done == budget)\n"
+                     << "            {\n"
+                     << "                s->programCounter = " << next << ";\n"
+                     << "                return done;\n"
+                     << "            }\n"
+                     << "            [[fallthrough]];\n";
+            }
+            else
+            {
+                if (!isTerminator(CPU::decode(memory.readWord(address), quirks).op))
+                {
+                    body << "            s->programCounter = " << next << ";\n";
+                }
+                body << "            return done + 1;\n";
+            }
+        }
+
+        const std::string code = body.str();
+        out << "\n"
+            << "    std::uint32_t block_" << hex(block.start, 4).substr(2) << "(Chip8AotState *s, std::uint32_t first, "
+            << (length > 1 ? "std::uint32_t budget" : "std::uint32_t") << ")\n"
+            << "    {\n";
+        if (code.find("v[") != std::string::npos)
+        {
+            out << "        std::uint8_t *const v = s->registers;\n";
+        }
+        if (code.find("sum = ") != std::string::npos)
+        {
+            out << "        unsigned sum;\n";
+        }
+        out << "        std::uint32_t done = 0;\n"
+            << "        switch (first)\n"
+            << "        {\n"
+            << code
+            << "        }\n"
+            << "        return 0;\n"
+            << "    }\n";
+    }
+
+    if (!blocks.empty())
+    {
+        out << "\n    const Chip8AotBlock BLOCKS[] = {\n";
+        std::size_t offset = 0;
+        for (const Block &block : blocks)
+        {
+            out << "        {" << hex(block.start, 4) << ", " << block.instructions.size() << ", " << block.size
+                << ", BYTES + " << offset << ", block_"
+                << hex(block.start, 4).substr(2) << "},\n";
+            offset += block.size;
+        }
+        out << "    };\n";
+    }
+
+    out << "\n"
+        << "    const Chip8AotModule MODULE = {CHIP8_AOT_ABI_VERSION, " << hex(quirks, 2) << ", "
+        << "0x" << std::hex << std::setfill('0') << std::setw(16) << memory.getROMHash()
+        << std::dec << std::setfill(' ') << "ULL, " << blocks.size() << ", " << (blocks.empty() ? "nullptr" : "BLOCKS")
+        << "};\n"
+        << "}\n"
+        << "\n"
+        << "extern \"C\" CHIP8_AOT_EXPORT const Chip8AotModule *CHIP8_AOT_ENTRY_POINT()\n"
+        << "{\n"
+        << "    return &MODULE;\n"
+        << "}\n";
+}
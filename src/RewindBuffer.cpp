@@ -0,0 +1,225 @@
+#include "RewindBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Zero runs shorter than this stay inside a literal run; a new token
+    // pair would cost more than the zeros themselves
+    constexpr std::size_t MIN_ZERO_RUN = 3;
+
+    // Record framing: a 32-bit length before and after each delta, so the
+    // ring can be walked from either end
+    constexpr std::size_t LENGTH_BYTES = 4;
+    constexpr std::size_t RECORD_OVERHEAD = 2 * LENGTH_BYTES;
+
+    std::size_t putVarint(std::uint8_t *out, std::size_t value)
+    {
+        std::size_t length = 0;
+        while (value >= 0x80)
+        {
+            out[length++] = static_cast<std::uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        out[length++] = static_cast<std::uint8_t>(value);
+        return length;
+    }
+
+    std::size_t getVarint(const std::uint8_t *&in)
+    {
+        std::size_t value = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            const std::uint8_t byte = *in++;
+            value |= static_cast<std::size_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+    }
+}
+
+RewindBuffer::RewindBuffer(std::size_t capacity)
+    : ring(capacity), head(0), tail(0), used(0), frameCount(0),
+      latest(CPU::STATE_SIZE), scratch(CPU::STATE_SIZE),
+      encoded(2 * CPU::STATE_SIZE), hasLatest(false)
+{
+}
+
+void RewindBuffer::clear()
+{
+    head = 0;
+    tail = 0;
+    used = 0;
+    frameCount = 0;
+    hasLatest = false;
+}
+
+void RewindBuffer::push(const CPU &cpu)
+{
+    cpu.saveState(scratch.data(), scratch.size());
+    if (!hasLatest)
+    {
+        latest.swap(scratch);
+        hasLatest = true;
+        return;
+    }
+
+    // Delta that turns the new state back into the previous one
+    const std::size_t length = encodeDelta(scratch.data(), latest.data());
+    const std::size_t record = length + RECORD_OVERHEAD;
+    latest.swap(scratch);
+
+    if (record > ring.size())
+    {
+        // Cannot keep even one frame of history
+        head = tail = used = frameCount = 0;
+        return;
+    }
+    while (used + record > ring.size())
+    {
+        dropOldest();
+    }
+
+    std::uint8_t framing[LENGTH_BYTES];
+    for (std::size_t i = 0; i < LENGTH_BYTES; ++i)
+    {
+        framing[i] = static_cast<std::uint8_t>(length >> (8 * i));
+    }
+    writeRing(head, framing, LENGTH_BYTES);
+    writeRing(head + LENGTH_BYTES, encoded.data(), length);
+    writeRing(head + LENGTH_BYTES + length, framing, LENGTH_BYTES);
+
+    head = (head + record) % ring.size();
+    used += record;
+    frameCount++;
+}
+
+bool RewindBuffer::rewind(CPU &cpu)
+{
+    if (frameCount == 0)
+    {
+        return false;
+    }
+
+    // Newest record ends at head
+    const std::size_t size = ring.size();
+    const std::size_t length = readLength((head + size - LENGTH_BYTES) % size);
+    const std::size_t start = (head + size - length - RECORD_OVERHEAD) % size;
+    readRing(start + LENGTH_BYTES, encoded.data(), length);
+    applyDelta(encoded.data(), latest.data());
+
+    head = start;
+    used -= length + RECORD_OVERHEAD;
+    frameCount--;
+
+    return cpu.loadState(latest.data(), latest.size());
+}
+
+std::size_t RewindBuffer::encodeDelta(const std::uint8_t *from, const std::uint8_t *to)
+{
+    // Pairs of (zero run, literal run) over from XOR to; literals hold the XOR
+    std::uint8_t *out = encoded.data();
+    std::size_t position = 0;
+    const std::size_t size = CPU::STATE_SIZE;
+
+    while (position < size)
+    {
+        // Most of a state (memory above all) does not change between
+        // frames, so skip equal bytes a word at a time first
+        std::size_t zeros = 0;
+        while (position + zeros + 8 <= size && std::memcmp(from + position + zeros, to + position + zeros, 8) == 0)
+        {
+            zeros += 8;
+        }
+        while (position + zeros < size && from[position + zeros] == to[position + zeros])
+        {
+            ++zeros;
+        }
+        position += zeros;
+
+        std::size_t literal = 0;
+        for (;;)
+        {
+            while (position + literal < size && from[position + literal] != to[position + literal])
+            {
+                ++literal;
+            }
+
+            // Absorb short zero gaps into the literal
+            std::size_t gap = 0;
+            while (gap < MIN_ZERO_RUN && position + literal + gap < size &&
+                   from[position + literal + gap] == to[position + literal + gap])
+            {
+                ++gap;
+            }
+            if (gap == MIN_ZERO_RUN || position + literal + gap >= size || literal == 0)
+            {
+                break;
+            }
+            literal += gap;
+        }
+
+        out += putVarint(out, zeros);
+        out += putVarint(out, literal);
+        for (std::size_t i = 0; i < literal; ++i)
+        {
+            *out++ = from[position + i] ^ to[position + i];
+        }
+        position += literal;
+    }
+
+    return static_cast<std::size_t>(out - encoded.data());
+}
+
+void RewindBuffer::applyDelta(const std::uint8_t *delta, std::uint8_t *state) const
+{
+    std::size_t position = 0;
+    while (position < CPU::STATE_SIZE)
+    {
+        position += getVarint(delta);
+        const std::size_t literal = getVarint(delta);
+        for (std::size_t i = 0; i < literal; ++i)
+        {
+            state[position++] ^= *delta++;
+        }
+    }
+}
+
+void RewindBuffer::writeRing(std::size_t offset, const std::uint8_t *data, std::size_t length)
+{
+    offset %= ring.size();
+    const std::size_t first = std::min(length, ring.size() - offset);
+    std::memcpy(&ring[offset], data, first);
+    std::memcpy(&ring[0], data + first, length - first);
+}
+
+void RewindBuffer::readRing(std::size_t offset, std::uint8_t *data, std::size_t length) const
+{
+    offset %= ring.size();
+    const std::size_t first = std::min(length, ring.size() - offset);
+    std::memcpy(data, &ring[offset], first);
+    std::memcpy(data + first, &ring[0], length - first);
+}
+
+std::uint32_t RewindBuffer::readLength(std::size_t offset) const
+{
+    std::uint8_t framing[LENGTH_BYTES];
+    readRing(offset, framing, LENGTH_BYTES);
+
+    std::uint32_t length = 0;
+    for (std::size_t i = 0; i < LENGTH_BYTES; ++i)
+    {
+        length |= static_cast<std::uint32_t>(framing[i]) << (8 * i);
+    }
+    return length;
+}
+
+void RewindBuffer::dropOldest()
+{
+    const std::size_t record = readLength(tail) + RECORD_OVERHEAD;
+    tail = (tail + record) % ring.size();
+    used -= record;
+    frameCount--;
+}
@@ -0,0 +1,77 @@
+#include "Scheduler.hpp"
+#include <algorithm>
+#include <cmath>
+
+Scheduler::Scheduler(std::uint32_t instructionsPerSecond)
+{
+    setInstructionsPerSecond(instructionsPerSecond);
+    start(Clock::now());
+}
+
+void Scheduler::setInstructionsPerSecond(std::uint32_t rate)
+{
+    instructionsPerSecond = std::min(std::max<std::uint32_t>(rate, 1), MAX_INSTRUCTIONS_PER_SECOND);
+    cycleRemainder = 0;
+}
+
+void Scheduler::setSpeed(double factor, Clock::time_point now)
+{
+    factor = std::min(std::max(factor, MIN_SPEED), MAX_SPEED);
+    if (factor == speed)
+    {
+        return;
+    }
+
+    // Keep the time already waited toward the next frame, at the new rate
+    const double progress = std::chrono::duration<double>(now - origin).count() * TIMER_RATE * speed -
+                            static_cast<double>(framesSinceOrigin);
+    speed = factor;
+    origin = now - std::chrono::duration_cast<Clock::duration>(
+                       std::chrono::duration<double>(std::min(std::max(progress, 0.0), 1.0) / (TIMER_RATE * speed)));
+    framesSinceOrigin = 0;
+}
+
+void Scheduler::start(Clock::time_point now)
+{
+    origin = now;
+    framesSinceOrigin = 0;
+}
+
+std::uint32_t Scheduler::advance(Clock::time_point now)
+{
+    if (now < nextDeadline())
+    {
+        return 0;
+    }
+
+    const double elapsedFrames = std::chrono::duration<double>(now - origin).count() * TIMER_RATE * speed;
+    // The next deadline has passed, whatever the rounding of elapsedFrames
+    const std::uint64_t reached = std::max(static_cast<std::uint64_t>(std::floor(elapsedFrames)),
+                                           framesSinceOrigin + 1);
+
+    std::uint64_t due = reached - framesSinceOrigin;
+    if (due > maxCatchUpFrames)
+    {
+        // Skip the excess but stay on the same deadline grid
+        droppedFrames += due - maxCatchUpFrames;
+        framesSinceOrigin += due - maxCatchUpFrames;
+        due = maxCatchUpFrames;
+    }
+    framesSinceOrigin += due;
+    return static_cast<std::uint32_t>(due);
+}
+
+std::uint64_t Scheduler::nextFrameCycles()
+{
+    cycleRemainder += instructionsPerSecond;
+    const std::uint64_t cycles = cycleRemainder / TIMER_RATE;
+    cycleRemainder %= TIMER_RATE;
+    return cycles;
+}
+
+Scheduler::Clock::duration Scheduler::framePeriod(std::uint64_t frames) const
+{
+    // Rounded up, so a frame is never reported due before its deadline
+    return std::chrono::ceil<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(frames) / (TIMER_RATE * speed)));
+}
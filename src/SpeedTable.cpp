@@ -0,0 +1,86 @@
+#include "SpeedTable.hpp"
+#include "Scheduler.hpp"
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+    bool parseNumber(const std::string &text, int base, std::uint64_t &value)
+    {
+        std::size_t parsed = 0;
+        try
+        {
+            value = std::stoull(text, &parsed, base);
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+        return parsed == text.size() && text[0] != '-';
+    }
+}
+
+bool SpeedTable::load(const std::string &path, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        error = "cannot open speed table: " + path;
+        return false;
+    }
+    return parse(file, error);
+}
+
+bool SpeedTable::parse(std::istream &in, std::string &error)
+{
+    speeds.clear();
+
+    std::string line;
+    std::size_t lineNumber = 0;
+    while (std::getline(in, line))
+    {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        std::string hashText;
+        std::string rateText;
+        std::string extra;
+        if (!(fields >> hashText))
+        {
+            continue; // Blank or comment-only line
+        }
+        if (!(fields >> rateText) || (fields >> extra))
+        {
+            error = "speed table line " + std::to_string(lineNumber) + ": expected <rom hash> <instructions per second>";
+            return false;
+        }
+
+        std::uint64_t hash = 0;
+        std::uint64_t rate = 0;
+        if (!parseNumber(hashText, 16, hash))
+        {
+            error = "speed table line " + std::to_string(lineNumber) + ": bad ROM hash";
+            return false;
+        }
+        if (!parseNumber(rateText, 10, rate) || rate == 0 || rate > Scheduler::MAX_INSTRUCTIONS_PER_SECOND)
+        {
+            error = "speed table line " + std::to_string(lineNumber) + ": bad instructions per second";
+            return false;
+        }
+        speeds[hash] = static_cast<std::uint32_t>(rate);
+    }
+
+    return true;
+}
+
+bool SpeedTable::lookup(std::uint64_t romHash, std::uint32_t &instructionsPerSecond) const
+{
+    const auto entry = speeds.find(romHash);
+    if (entry == speeds.end())
+    {
+        return false;
+    }
+    instructionsPerSecond = entry->second;
+    return true;
+}
@@ -0,0 +1,543 @@
+#include "ThreadedBackend.hpp"
+#include "Analyzer.hpp"
+
+// GCC and Clang support labels as values, which gives direct threading.
+// Other compilers fall back to a switch over the operation.
+#if defined(__GNUC__) || defined(__clang__)
+#define CHIP8_COMPUTED_GOTO 1
+#else
+#define CHIP8_COMPUTED_GOTO 0
+#endif
+
+void ThreadedBackend::run(CPU &cpu, std::uint64_t cycles)
+{
+    static constexpr std::array<Runner, CPU::QUIRK_COMBINATIONS> RUNNERS =
+        makeRunners(std::make_index_sequence<CPU::QUIRK_COMBINATIONS>());
+    (this->*RUNNERS[cpu.quirks])(cpu, cycles);
+}
+
+template <CPU::Quirks Q>
+void ThreadedBackend::runQuirks(CPU &cpu, std::uint64_t cycles)
+{
+    std::uint8_t *v = cpu.registers.data();
+    const ThreadedOp *op = nullptr;
+    Block *block = nullptr;
+
+#if CHIP8_COMPUTED_GOTO
+    // Indexed by CPU::Operation; operations that never appear in threaded code have no label
+    static const void *const LABEL_TABLE[] = {
+        nullptr,         // Fallback
+        &&op_Cls,        // Cls
+        &&op_Ret,        // Ret
+        &&op_Jp,         // Jp
+        &&op_Call,       // Call
+        &&op_SeImm,      // SeImm
+        &&op_SneImm,     // SneImm
+        &&op_SeReg,      // SeReg
+        &&op_LdImm,      // LdImm
+        &&op_AddImm,     // AddImm
+        &&op_LdReg,      // LdReg
+        &&op_OrReg,      // OrReg
+        &&op_AndReg,     // AndReg
+        &&op_XorReg,     // XorReg
+        &&op_AddReg,     // AddReg
+        &&op_SubReg,     // SubReg
+        &&op_Shr,        // Shr
+        &&op_Subn,       // Subn
+        &&op_Shl,        // Shl
+        &&op_SneReg,     // SneReg
+        &&op_LdI,        // LdI
+        &&op_JpV0,       // JpV0
+        &&op_Rnd,        // Rnd
+        &&op_Drw,        // Drw
+        &&op_Skp,        // Skp
+        &&op_Sknp,       // Sknp
+        &&op_LdVxDt,     // LdVxDt
+        nullptr,         // LdKey
+        &&op_LdDtVx,     // LdDtVx
+        &&op_LdStVx,     // LdStVx
+        &&op_AddI,       // AddI
+        &&op_LdFont,     // LdFont
+        nullptr,         // Bcd
+        nullptr,         // Store
+        &&op_Load,       // Load
+        nullptr,         // ScrollDown
+        nullptr,         // ScrollRight
+        nullptr,         // ScrollLeft
+        nullptr,         // Exit
+        nullptr,         // Lores
+        nullptr,         // Hires
+        nullptr,         // LdBigFont
+        nullptr,         // StoreFlags
+        nullptr,         // LoadFlags
+        nullptr,         // ScrollUp
+        nullptr,         // SaveRange
+        nullptr,         // LoadRange
+        nullptr,         // LdILong
+        &&op_Plane,      // Plane
+        nullptr,         // Audio
+        nullptr,         // Pitch
+        &&op_EndOfBlock, // END_OF_BLOCK
+    };
+    static_assert(sizeof(LABEL_TABLE) / sizeof(LABEL_TABLE[0]) ==
+                      static_cast<std::size_t>(CPU::Operation::Count) + 1,
+                  "LABEL_TABLE must have one entry per Operation plus END_OF_BLOCK");
+
+#define OP(name) op_##name:
+#define DISPATCH() goto *op->target
+#else
+    const void *const *LABEL_TABLE = nullptr;
+
+#define OP(name) case CPU::Operation::name:
+#define DISPATCH() goto dispatch
+#endif
+
+    if (!pending.empty())
+    {
+        compilePending(cpu, LABEL_TABLE);
+    }
+
+#define NEXT()      \
+    do              \
+    {               \
+        ++op;       \
+        DISPATCH(); \
+    } while (0)
+
+nextBlock:
+    if (cycles == 0)
+    {
+        return;
+    }
+
+    if (cpu.programCounter >= Memory::MEMORY_SIZE - 1)
+    {
+        cpu.interpretCycle();
+        cycles--;
+        goto nextBlock;
+    }
+
+    block = blocks[cpu.programCounter].get();
+    if (!block)
+    {
+        block = compile(cpu, cpu.programCounter, LABEL_TABLE);
+    }
+
+    // Not enough budget left for the whole block: single-step instead
+    if (block->length > cycles)
+    {
+        cpu.emulateCycle();
+        cycles--;
+        goto nextBlock;
+    }
+    cycles -= block->length;
+    cpu.opcode = block->lastOpcode;
+
+    op = block->ops.data();
+#if CHIP8_COMPUTED_GOTO
+    DISPATCH();
+#else
+dispatch:
+    switch (op->op)
+    {
+#endif
+
+    OP(Cls)
+    cpu.clearDisplay();
+    NEXT();
+
+    OP(LdImm)
+    v[op->x] = op->nn;
+    NEXT();
+
+    OP(AddImm)
+    v[op->x] += op->nn;
+    NEXT();
+
+    OP(LdReg)
+    v[op->x] = v[op->y];
+    NEXT();
+
+    OP(OrReg)
+    v[op->x] |= v[op->y];
+    if constexpr (Q & CPU::QUIRK_RESET_VF)
+    {
+        v[0xF] = 0;
+    }
+    NEXT();
+
+    OP(AndReg)
+    v[op->x] &= v[op->y];
+    if constexpr (Q & CPU::QUIRK_RESET_VF)
+    {
+        v[0xF] = 0;
+    }
+    NEXT();
+
+    OP(XorReg)
+    v[op->x] ^= v[op->y];
+    if constexpr (Q & CPU::QUIRK_RESET_VF)
+    {
+        v[0xF] = 0;
+    }
+    NEXT();
+
+    OP(AddReg)
+    {
+        std::uint16_t sum = v[op->x] + v[op->y];
+        v[0xF] = (sum > 255) ? 1 : 0;
+        v[op->x] = static_cast<std::uint8_t>(sum);
+    }
+    NEXT();
+
+    OP(SubReg)
+    v[0xF] = (v[op->x] > v[op->y]) ? 1 : 0;
+    v[op->x] -= v[op->y];
+    NEXT();
+
+    OP(Shr)
+    {
+        const std::uint8_t source = (Q & CPU::QUIRK_SHIFT_VY) ? op->y : op->x;
+        v[0xF] = v[source] & 0x1;
+        v[op->x] = v[source] >> 1;
+    }
+    NEXT();
+
+    OP(Subn)
+    v[0xF] = (v[op->y] > v[op->x]) ? 1 : 0;
+    v[op->x] = v[op->y] - v[op->x];
+    NEXT();
+
+    OP(Shl)
+    {
+        const std::uint8_t source = (Q & CPU::QUIRK_SHIFT_VY) ? op->y : op->x;
+        v[0xF] = (v[source] & 0x80) >> 7;
+        v[op->x] = static_cast<std::uint8_t>(v[source] << 1);
+    }
+    NEXT();
+
+    OP(LdI)
+    cpu.indexRegister = op->nnn;
+    NEXT();
+
+    OP(Rnd)
+    v[op->x] = cpu.generateRandomByte() & op->nn;
+    NEXT();
+
+    OP(Drw)
+    cpu.programCounter = op->address; // For fault reports
+    v[0xF] = cpu.drawSprite<(Q & CPU::QUIRK_CLIP_SPRITES) != 0>(v[op->x], v[op->y], op->n) ? 1 : 0;
+    NEXT();
+
+    OP(LdVxDt)
+    v[op->x] = cpu.delayTimer;
+    NEXT();
+
+    OP(LdDtVx)
+    cpu.delayTimer = v[op->x];
+    NEXT();
+
+    OP(LdStVx)
+    cpu.soundTimer = v[op->x];
+    NEXT();
+
+    OP(AddI)
+    cpu.indexRegister += v[op->x];
+    NEXT();
+
+    OP(LdFont)
+    cpu.indexRegister = Memory::FONT_START + (v[op->x] * 5);
+    NEXT();
+
+    OP(Plane)
+    cpu.selectPlanes(op->x);
+    NEXT();
+
+    OP(Load)
+    cpu.programCounter = op->address; // For fault reports
+    cpu.checkAccess(cpu.indexRegister, op->x + 1u);
+    for (std::uint8_t i = 0; i <= op->x; ++i)
+    {
+        v[i] = cpu.memory->readByte(cpu.indexRegister + i);
+    }
+    if constexpr (Q & CPU::QUIRK_INCREMENT_I)
+    {
+        cpu.indexRegister += op->x + 1;
+    }
+    NEXT();
+
+    // Terminators: set the program counter and chain to the next block
+
+    OP(Ret)
+    if (cpu.stackPointer > 0)
+    {
+        cpu.stackPointer--;
+        cpu.programCounter = cpu.stack[cpu.stackPointer];
+    }
+    else
+    {
+        // Underflow is reported by the decoded handler
+        cpu.programCounter = op->address;
+        cpu.emulateCycle();
+    }
+    goto nextBlock;
+
+    OP(Jp)
+    cpu.programCounter = op->nnn;
+    goto nextBlock;
+
+    OP(Call)
+    if (cpu.stackPointer < cpu.stack.size())
+    {
+        cpu.stack[cpu.stackPointer] = op->address + 2;
+        cpu.stackPointer++;
+        cpu.programCounter = op->nnn;
+    }
+    else
+    {
+        // Overflow is reported by the decoded handler
+        cpu.programCounter = op->address;
+        cpu.emulateCycle();
+    }
+    goto nextBlock;
+
+    OP(SeImm)
+    cpu.programCounter = op->address + ((v[op->x] == op->nn) ? op->skip : 2);
+    goto nextBlock;
+
+    OP(SneImm)
+    cpu.programCounter = op->address + ((v[op->x] != op->nn) ? op->skip : 2);
+    goto nextBlock;
+
+    OP(SeReg)
+    cpu.programCounter = op->address + ((v[op->x] == v[op->y]) ? op->skip : 2);
+    goto nextBlock;
+
+    OP(SneReg)
+    cpu.programCounter = op->address + ((v[op->x] != v[op->y]) ? op->skip : 2);
+    goto nextBlock;
+
+    OP(JpV0)
+    cpu.programCounter = op->nnn + v[(Q & CPU::QUIRK_JUMP_VX) ? op->x : 0];
+    goto nextBlock;
+
+    OP(Skp)
+    cpu.programCounter = op->address; // For fault reports
+    cpu.programCounter += cpu.isKeyHeld(v[op->x]) ? op->skip : 2;
+    goto nextBlock;
+
+    OP(Sknp)
+    cpu.programCounter = op->address; // For fault reports
+    cpu.programCounter += cpu.isKeyHeld(v[op->x]) ? 2 : op->skip;
+    goto nextBlock;
+
+#if CHIP8_COMPUTED_GOTO
+op_EndOfBlock:
+#else
+    default:
+#endif
+    cpu.programCounter = op->nnn;
+    if (block->hasHandler)
+    {
+        // The terminator may write memory and invalidate this block,
+        // so run it from a copy and don't touch the block afterwards
+        const CPU::Instruction terminator = block->terminator;
+        terminator.handler(cpu, terminator);
+    }
+    goto nextBlock;
+#if !CHIP8_COMPUTED_GOTO
+    }
+#endif
+
+#undef OP
+#undef DISPATCH
+#undef NEXT
+}
+
+void ThreadedBackend::invalidate(std::uint16_t address, std::size_t length)
+{
+    // Any block starting up to MAX_BLOCK_LENGTH instructions earlier may
+    // cover the range; a block ending in a skip also depends on the first
+    // word of the instruction after it
+    const std::size_t reach = MAX_BLOCK_LENGTH * 2 + 2;
+    std::size_t first = address >= reach ? address - reach : 0;
+    std::size_t last = static_cast<std::size_t>(address) + length;
+    if (last > blocks.size())
+    {
+        last = blocks.size();
+    }
+
+    // Stores to data pages, where no block ever started, need no scan
+    bool translated = false;
+    for (std::size_t page = first / Memory::PAGE_SIZE; page * Memory::PAGE_SIZE < last; ++page)
+    {
+        translated = translated || translatedPages[page];
+    }
+    if (!translated)
+    {
+        return;
+    }
+
+    for (std::size_t start = first; start < last; ++start)
+    {
+        const Block *block = blocks[start].get();
+        if (block && static_cast<std::size_t>(block->start) + block->length * 2 + 2 > address)
+        {
+            blocks[start].reset();
+        }
+    }
+}
+
+void ThreadedBackend::translate(CPU &cpu, const Analyzer &analysis)
+{
+    (void)cpu;
+    for (const Analyzer::Block &block : analysis.getBlocks())
+    {
+        pending.push_back(block.instructions);
+    }
+}
+
+void ThreadedBackend::compilePending(CPU &cpu, const void *const *labels)
+{
+    // Threaded blocks also end at key waits and memory writes, so one
+    // analyzed block may become several
+    for (const std::vector<std::uint16_t> &instructions : pending)
+    {
+        std::size_t i = 0;
+        while (i < instructions.size())
+        {
+            const std::uint16_t address = instructions[i];
+            Block *block = blocks[address].get();
+            if (!block)
+            {
+                block = compile(cpu, address, labels);
+            }
+            i += block->length;
+        }
+    }
+    pending.clear();
+    pending.shrink_to_fit();
+}
+
+bool ThreadedBackend::isBodyOperation(CPU::Operation op)
+{
+    using Op = CPU::Operation;
+
+    switch (op)
+    {
+    case Op::Cls:
+    case Op::LdImm:
+    case Op::AddImm:
+    case Op::LdReg:
+    case Op::OrReg:
+    case Op::AndReg:
+    case Op::XorReg:
+    case Op::AddReg:
+    case Op::SubReg:
+    case Op::Shr:
+    case Op::Subn:
+    case Op::Shl:
+    case Op::LdI:
+    case Op::Rnd:
+    case Op::Drw:
+    case Op::LdVxDt:
+    case Op::LdDtVx:
+    case Op::LdStVx:
+    case Op::AddI:
+    case Op::LdFont:
+    case Op::Plane:
+    case Op::Load:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool ThreadedBackend::isThreadedTerminator(CPU::Operation op)
+{
+    using Op = CPU::Operation;
+
+    switch (op)
+    {
+    case Op::Ret:
+    case Op::Jp:
+    case Op::Call:
+    case Op::SeImm:
+    case Op::SneImm:
+    case Op::SeReg:
+    case Op::SneReg:
+    case Op::JpV0:
+    case Op::Skp:
+    case Op::Sknp:
+        return true;
+    default:
+        // Key waits, memory writes and unknown opcodes use their decoded handler
+        return false;
+    }
+}
+
+ThreadedBackend::Block *ThreadedBackend::compile(CPU &cpu, std::uint16_t address, const void *const *labels)
+{
+    auto block = std::make_unique<Block>();
+    block->start = address;
+    block->length = 0;
+    block->lastOpcode = 0;
+    block->hasHandler = false;
+
+    auto makeOp = [labels, &cpu](CPU::Operation op, const CPU::Instruction &instruction, std::uint16_t pc)
+    {
+        ThreadedOp threaded;
+        threaded.op = op;
+        threaded.target = labels ? labels[static_cast<std::size_t>(op)] : nullptr;
+        threaded.x = instruction.x;
+        threaded.y = instruction.y;
+        threaded.n = instruction.n;
+        threaded.nn = instruction.nn;
+        threaded.nnn = instruction.nnn;
+        threaded.address = pc;
+        threaded.skip = static_cast<std::uint8_t>(cpu.skipLength(pc));
+        return threaded;
+    };
+
+    std::uint16_t pc = address;
+    bool terminated = false;
+    while (block->length < MAX_BLOCK_LENGTH && pc < Memory::MEMORY_SIZE - 1)
+    {
+        const std::uint16_t opcode = (cpu.memory->readByte(pc) << 8) | cpu.memory->readByte(pc + 1);
+        const CPU::Instruction instruction = CPU::decode(opcode, cpu.quirks);
+        block->length++;
+        block->lastOpcode = opcode;
+
+        if (isBodyOperation(instruction.op))
+        {
+            block->ops.push_back(makeOp(instruction.op, instruction, pc));
+            pc += 2;
+            continue;
+        }
+
+        if (isThreadedTerminator(instruction.op))
+        {
+            block->ops.push_back(makeOp(instruction.op, instruction, pc));
+        }
+        else
+        {
+            block->hasHandler = true;
+            block->terminator = instruction;
+        }
+        terminated = true;
+        break;
+    }
+
+    if (!terminated || block->hasHandler)
+    {
+        // Leave PC at the next instruction (or at the handled terminator)
+        CPU::Instruction none{};
+        none.nnn = pc;
+        block->ops.push_back(makeOp(END_OF_BLOCK, none, pc));
+    }
+
+    Block *result = block.get();
+    blocks[address] = std::move(block);
+    translatedPages[address / Memory::PAGE_SIZE] = true;
+    return result;
+}
@@ -0,0 +1,98 @@
+#include "WavWriter.hpp"
+
+namespace
+{
+    constexpr std::uint32_t HEADER_BYTES = 44;
+    constexpr std::uint16_t CHANNELS = 1;
+    constexpr std::uint16_t BITS_PER_SAMPLE = 16;
+    constexpr std::uint16_t BLOCK_ALIGN = CHANNELS * BITS_PER_SAMPLE / 8;
+
+    // WAV fields are little-endian whatever the host is
+    void put16(std::uint8_t *out, std::uint16_t value)
+    {
+        out[0] = static_cast<std::uint8_t>(value);
+        out[1] = static_cast<std::uint8_t>(value >> 8);
+    }
+
+    void put32(std::uint8_t *out, std::uint32_t value)
+    {
+        put16(out, static_cast<std::uint16_t>(value));
+        put16(out + 2, static_cast<std::uint16_t>(value >> 16));
+    }
+
+    void writeHeader(std::ofstream &file, unsigned sampleRate, std::uint32_t dataBytes)
+    {
+        std::uint8_t header[HEADER_BYTES] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                                             'f', 'm', 't', ' ', 0, 0, 0, 0, 0, 0, 0, 0,
+                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                             'd', 'a', 't', 'a', 0, 0, 0, 0};
+        put32(header + 4, HEADER_BYTES - 8 + dataBytes);
+        put32(header + 16, 16); // fmt chunk size
+        put16(header + 20, 1);  // PCM
+        put16(header + 22, CHANNELS);
+        put32(header + 24, sampleRate);
+        put32(header + 28, sampleRate * BLOCK_ALIGN);
+        put16(header + 32, BLOCK_ALIGN);
+        put16(header + 34, BITS_PER_SAMPLE);
+        put32(header + 40, dataBytes);
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+    }
+}
+
+WavWriter::~WavWriter()
+{
+    if (file.is_open())
+    {
+        std::string error;
+        close(error);
+    }
+}
+
+bool WavWriter::open(const std::string &filePath, unsigned rate, std::string &error)
+{
+    file.open(filePath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        error = "cannot create WAV file: " + filePath;
+        return false;
+    }
+
+    path = filePath;
+    sampleRate = rate;
+    sampleCount = 0;
+    writeHeader(file, sampleRate, 0);
+    return true;
+}
+
+void WavWriter::write(const std::int16_t *samples, std::size_t count)
+{
+    std::uint8_t bytes[1024];
+    while (count != 0)
+    {
+        const std::size_t chunk = count < sizeof(bytes) / 2 ? count : sizeof(bytes) / 2;
+        for (std::size_t i = 0; i < chunk; ++i)
+        {
+            put16(bytes + 2 * i, static_cast<std::uint16_t>(samples[i]));
+        }
+        file.write(reinterpret_cast<const char *>(bytes), static_cast<std::streamsize>(2 * chunk));
+        samples += chunk;
+        count -= chunk;
+        sampleCount += chunk;
+    }
+}
+
+bool WavWriter::close(std::string &error)
+{
+    // RIFF sizes are 32-bit; longer recordings keep a saturated size
+    const std::uint64_t dataBytes = sampleCount * BLOCK_ALIGN;
+    file.seekp(0);
+    writeHeader(file, sampleRate,
+                static_cast<std::uint32_t>(dataBytes < 0xFFFFFFFFu - HEADER_BYTES ? dataBytes : 0xFFFFFFFFu - HEADER_BYTES));
+    file.close();
+    if (!file)
+    {
+        error = "failed to write WAV file: " + path;
+        return false;
+    }
+    return true;
+}
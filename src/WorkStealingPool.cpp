@@ -0,0 +1,112 @@
+#include "WorkStealingPool.hpp"
+#include <exception>
+#include <memory>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+    : threadCount(threads)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (threadCount == 0)
+    {
+        threadCount = 1;
+    }
+}
+
+void WorkStealingPool::run(std::size_t count, const std::function<void(std::size_t)> &task)
+{
+    const std::size_t workers = count < threadCount ? count : threadCount;
+    if (workers == 0)
+    {
+        return;
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    for (std::size_t i = 0; i < workers; ++i)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        queues[i % workers]->tasks.push_back(i);
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+
+    // No tasks are added once workers start, so a worker that finds every
+    // queue empty is done
+    auto worker = [&](std::size_t self)
+    {
+        std::size_t index = 0;
+        for (;;)
+        {
+            bool found = popOwn(*queues[self], index);
+            for (std::size_t offset = 1; !found && offset < workers; ++offset)
+            {
+                found = steal(*queues[(self + offset) % workers], index);
+            }
+            if (!found)
+            {
+                return;
+            }
+
+            try
+            {
+                task(index);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError)
+                {
+                    firstError = std::current_exception();
+                }
+            }
+        }
+    };
+
+    // The calling thread is worker 0
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < workers; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    if (firstError)
+    {
+        std::rethrow_exception(firstError);
+    }
+}
+
+bool WorkStealingPool::popOwn(Queue &queue, std::size_t &task)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(Queue &queue, std::size_t &task)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
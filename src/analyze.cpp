@@ -0,0 +1,129 @@
+/**
+ * @file analyze.cpp
+ * @brief CHIP-8 Emulator - Static ROM analyzer
+ *
+ * Disassembles a ROM without running it:
+ * - Recovers the control-flow graph from the entry point
+ * - Separates reachable code from data (sprites, tables)
+ * - Flags stores that write over code (self-modifying programs)
+ * - Prints a commented listing, or the same analysis as JSON
+ *
+ * Only links against chip8_core, so it runs on display-less servers.
+ */
+
+#include "Analyzer.hpp"
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    /**
+     * @brief Command line options for the analyzer
+     */
+    struct Options
+    {
+        std::string romPath;
+        std::string outputPath; ///< Report destination, empty = stdout
+        CPU::Quirks quirks = CPU::QUIRKS_NONE;
+        bool json = false;
+    };
+
+    void printUsage(const char *program)
+    {
+        std::cout << "CHIP-8 ROM Analyzer" << std::endl;
+        std::cout << "Usage: " << program << " <ROM_FILE> [options]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --json          Write the analysis as JSON instead of a listing" << std::endl;
+        std::cout << "  --quirks LIST   Variant the ROM runs on, e.g. vip or schip,increment-i" << std::endl;
+        std::cout << "  --output FILE   Write the report to FILE instead of stdout" << std::endl;
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (std::strcmp(arg, "--json") == 0)
+            {
+                options.json = true;
+            }
+            else if (std::strcmp(arg, "--quirks") == 0 && hasValue)
+            {
+                if (!CPU::parseQuirks(argv[++i], options.quirks))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--output") == 0 && hasValue)
+            {
+                options.outputPath = argv[++i];
+            }
+            else if (arg[0] != '-' && options.romPath.empty())
+            {
+                options.romPath = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !options.romPath.empty();
+    }
+}
+
+/**
+ * @brief Analyzer entry point
+ * @param argc Number of command line arguments
+ * @param argv Array of command line arguments
+ * @return 0 on success, 1 on error
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // loadROM() reports on stdout; keep stdout for the report itself
+    Memory memory;
+    std::streambuf *report = std::cout.rdbuf(std::cerr.rdbuf());
+    const bool loaded = memory.loadROM(options.romPath.c_str());
+    std::cout.rdbuf(report);
+    if (!loaded)
+    {
+        return 1;
+    }
+
+    Analyzer analyzer;
+    analyzer.analyze(memory, options.quirks);
+
+    std::ofstream file;
+    if (!options.outputPath.empty())
+    {
+        file.open(options.outputPath);
+        if (!file.is_open())
+        {
+            std::cerr << "Error: Could not write " << options.outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = file.is_open() ? static_cast<std::ostream &>(file) : std::cout;
+
+    if (options.json)
+    {
+        analyzer.writeJson(out, memory, options.romPath);
+    }
+    else
+    {
+        analyzer.writeText(out, memory, options.romPath);
+    }
+    return out.good() ? 0 : 1;
+}
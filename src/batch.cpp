@@ -0,0 +1,202 @@
+/**
+ * @file batch.cpp
+ * @brief CHIP-8 Emulator - Parallel batch runner
+ *
+ * Runs every job in a job list headlessly, spread over all cores:
+ * - Each job names a ROM, a frame count and an optional input script
+ * - Jobs run on independent machines, so results are reproducible
+ * - Prints each job's framebuffer hash, registers and cycle count,
+ *   followed by the aggregate throughput
+ *
+ * Only links against chip8_core, so it runs on display-less servers.
+ */
+
+#include "BatchEngine.hpp"
+#include "CPU.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /**
+     * @brief Command line options for the batch runner
+     */
+    struct Options
+    {
+        std::string jobListPath;
+        std::size_t threads = 0; ///< 0 = one per hardware thread
+        BatchJob defaults;       ///< Backend, quirks, cycles per frame, seed and generator for every job
+    };
+
+    void printUsage(const char *program)
+    {
+        std::cout << "CHIP-8 Batch Runner" << std::endl;
+        std::cout << "Usage: " << program << " <JOB_LIST> [options]" << std::endl;
+        std::cout << "Job list: one \"<rom> <frames> [input_script [quirks]]\" per line" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --threads N           Worker threads (default: one per hardware thread)" << std::endl;
+        std::cout << "  --cycles-per-frame N  CPU cycles per 60Hz timer tick (default "
+                  << BatchJob().cyclesPerFrame << ")" << std::endl;
+        std::cout << "  --backend NAME        interpreter, cached (default), threaded or jit" << std::endl;
+        std::cout << "  --quirks LIST         Default variant behaviors, e.g. vip or schip,shift-vy" << std::endl;
+        std::cout << "  --seed N              Random seed for CXNN (default " << CPU::DEFAULT_RANDOM_SEED << ")" << std::endl;
+        std::cout << "  --random NAME         CXNN generator: xorshift (default) or counter" << std::endl;
+    }
+
+    bool parseCount(const char *text, std::uint64_t &value)
+    {
+        char *end = nullptr;
+        unsigned long long parsed = std::strtoull(text, &end, 10);
+        if (end == text || *end != '\0')
+        {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            std::uint64_t value = 0;
+
+            if (std::strcmp(arg, "--threads") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], value))
+                {
+                    return false;
+                }
+                options.threads = static_cast<std::size_t>(value);
+            }
+            else if (std::strcmp(arg, "--cycles-per-frame") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], value) || value == 0)
+                {
+                    return false;
+                }
+                options.defaults.cyclesPerFrame = value;
+            }
+            else if (std::strcmp(arg, "--backend") == 0 && hasValue)
+            {
+                if (!CPU::parseBackendName(argv[++i], options.defaults.backend))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--quirks") == 0 && hasValue)
+            {
+                if (!CPU::parseQuirks(argv[++i], options.defaults.quirks))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--seed") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], value) || value > UINT32_MAX)
+                {
+                    return false;
+                }
+                options.defaults.seed = static_cast<std::uint32_t>(value);
+            }
+            else if (std::strcmp(arg, "--random") == 0 && hasValue)
+            {
+                if (!CPU::parseRandomGenerator(argv[++i], options.defaults.random))
+                {
+                    return false;
+                }
+            }
+            else if (arg[0] != '-' && options.jobListPath.empty())
+            {
+                options.jobListPath = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !options.jobListPath.empty();
+    }
+
+    void printResult(std::size_t index, const BatchJob &job, const BatchResult &result)
+    {
+        std::cout << "job " << index << ": " << job.romPath;
+        if (!result.ok)
+        {
+            std::cout << " error: " << result.error << std::endl;
+            return;
+        }
+
+        std::cout << std::hex << std::setfill('0')
+                  << " hash=0x" << std::setw(16) << result.framebufferHash
+                  << " pc=0x" << std::setw(3) << result.programCounter
+                  << " i=0x" << std::setw(3) << result.indexRegister
+                  << " v=";
+        for (std::uint8_t value : result.registers)
+        {
+            std::cout << std::setw(2) << static_cast<int>(value);
+        }
+        std::cout << std::dec << std::setfill(' ')
+                  << " frames=" << result.frames
+                  << " cycles=" << result.cycles
+                  << " faults=" << result.faults << std::endl;
+    }
+}
+
+/**
+ * @brief Batch runner entry point
+ * @param argc Number of command line arguments
+ * @param argv Array of command line arguments
+ * @return 0 if every job ran, 1 on error
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<BatchJob> jobs;
+    std::string error;
+    if (!BatchEngine::loadJobList(options.jobListPath, options.defaults, jobs, error))
+    {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+
+    BatchEngine engine(options.threads);
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<BatchResult> results = engine.run(jobs);
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::uint64_t totalCycles = 0;
+    std::size_t failed = 0;
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        printResult(i, jobs[i], results[i]);
+        totalCycles += results[i].cycles;
+        failed += results[i].ok ? 0 : 1;
+    }
+
+    std::cout << "jobs: " << jobs.size() << std::endl;
+    std::cout << "failed: " << failed << std::endl;
+    std::cout << "threads: " << engine.getThreadCount() << std::endl;
+    std::cout << "elapsed_sec: " << std::fixed << std::setprecision(6) << seconds << std::endl;
+    std::cout << "cycles: " << totalCycles << std::endl;
+    std::cout << "cycles_per_sec: " << std::fixed << std::setprecision(0)
+              << (seconds > 0.0 ? static_cast<double>(totalCycles) / seconds : 0.0) << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
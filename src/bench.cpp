@@ -0,0 +1,658 @@
+/**
+ * @file bench.cpp
+ * @brief CHIP-8 Emulator - Benchmark suite
+ *
+ * Times the hot paths of the emulator and prints the results as JSON so
+ * that two builds can be compared:
+ * - Micro: CPU cycles per opcode class (one instruction repeated in a
+ *   loop), DXYN with different heights and at the display edges,
+ *   Memory::readByte/writeByte, and Graphics::render into a hidden window
+ *   (when built with raylib)
+ * - Macro: every ROM in src/rom for a fixed number of cycles on every
+ *   execution backend, and on the aot backend for ROMs with a recompiled
+ *   module
+ *
+ * Each measurement is the best of several repetitions.
+ */
+
+#include "AotModule.hpp"
+#include "CPU.hpp"
+#include "Memory.hpp"
+#ifdef CHIP8_BENCH_GRAPHICS
+#include "Graphics.hpp"
+#endif
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef CHIP8_ROM_DIR
+#define CHIP8_ROM_DIR "src/rom"
+#endif
+#ifndef CHIP8_AOT_DIR
+#define CHIP8_AOT_DIR "bin/aot"
+#endif
+#ifndef CHIP8_BUILD_TYPE
+#define CHIP8_BUILD_TYPE ""
+#endif
+
+namespace
+{
+    constexpr std::uint64_t DEFAULT_MICRO_CYCLES = 1000000;
+    constexpr std::uint64_t DEFAULT_MACRO_CYCLES = 5000000;
+    constexpr std::uint64_t DEFAULT_REPEAT = 3;
+    constexpr std::uint64_t CYCLES_PER_FRAME = 9; ///< Matches the GUI
+
+    // Micro programs: setup, then BODY_LENGTH copies of the instruction, then
+    // a jump back to the first copy
+    constexpr std::uint16_t BODY_LENGTH = 128;
+    constexpr std::uint16_t SUBROUTINE = 0xE00;  ///< Holds a lone 00EE
+    constexpr std::uint16_t SCRATCH = 0xF00;     ///< Target of memory writes
+
+    /**
+     * @brief Command line options for the benchmark suite
+     */
+    struct Options
+    {
+        std::uint64_t microCycles = DEFAULT_MICRO_CYCLES;
+        std::uint64_t macroCycles = DEFAULT_MACRO_CYCLES;
+        std::uint64_t repeat = DEFAULT_REPEAT;
+        std::vector<CPU::Backend> microBackends{CPU::Backend::Cached};
+        std::string romDir = CHIP8_ROM_DIR;
+        std::string moduleDir = CHIP8_AOT_DIR; ///< Recompiled <rom>.so modules for the aot backend
+        std::string filter; ///< Only run benchmarks whose name contains this
+        std::string outputPath; ///< Empty = stdout
+    };
+
+    /**
+     * @brief One instruction timed in a loop
+     */
+    struct MicroCase
+    {
+        const char *name;
+        std::vector<std::uint16_t> setup; ///< Run once before timing
+        std::uint16_t opcode;
+        bool chain = false;       ///< NNN is filled with the next address (jumps)
+        bool holdKey0 = false;    ///< Key 0 held (EX9E/EXA1 paths)
+    };
+
+    struct MicroResult
+    {
+        std::string name;
+        std::string backend;
+        std::uint64_t iterations = 0;
+        double nsPerOp = 0.0;
+    };
+
+    struct MacroResult
+    {
+        std::string rom;
+        std::string backend;
+        std::uint64_t cycles = 0;
+        double seconds = 0.0;
+        std::uint64_t framebufferHash = 0;
+    };
+
+    // Keeps measured loads from being optimized away
+    volatile std::uint32_t sink;
+
+    const std::vector<MicroCase> &microCases()
+    {
+        static const std::vector<MicroCase> cases = {
+            {"00e0_cls", {}, 0x00E0},
+            {"1nnn_jp", {}, 0x1000, true},
+            {"2nnn_00ee_call_ret", {}, static_cast<std::uint16_t>(0x2000 | SUBROUTINE)},
+            {"3xnn_se", {0x6000}, 0x3001},
+            {"4xnn_sne", {0x6000}, 0x4000},
+            {"5xy0_se", {0x6000, 0x6101}, 0x5010},
+            {"6xnn_ld", {}, 0x6A42},
+            {"7xnn_add", {}, 0x7A01},
+            {"8xy0_ld", {}, 0x8AB0},
+            {"8xy1_or", {}, 0x8AB1},
+            {"8xy2_and", {}, 0x8AB2},
+            {"8xy3_xor", {}, 0x8AB3},
+            {"8xy4_add", {0x6A80, 0x6B90}, 0x8AB4},
+            {"8xy5_sub", {0x6B01}, 0x8AB5},
+            {"8xy6_shr", {}, 0x8AB6},
+            {"8xy7_subn", {}, 0x8AB7},
+            {"8xye_shl", {}, 0x8ABE},
+            {"9xy0_sne", {0x6000, 0x6100}, 0x9010},
+            {"annn_ld", {}, 0xA123},
+            {"bnnn_jp", {0x6000}, 0xB000, true},
+            {"cxnn_rnd", {}, 0xCAFF},
+            {"dxyn_h1", {0xA050, 0x6000, 0x6100}, 0xD011},
+            {"dxyn_h5", {0xA050, 0x6000, 0x6100}, 0xD015},
+            {"dxyn_h15", {0xA050, 0x6000, 0x6100}, 0xD01F},
+            {"dxyn_h5_unaligned", {0xA050, 0x6003, 0x6100}, 0xD015},
+            {"dxyn_h5_wrap_x", {0xA050, 0x603D, 0x6100}, 0xD015},
+            {"dxyn_h15_wrap_y", {0xA050, 0x6000, 0x611A}, 0xD01F},
+            {"dxyn_h15_wrap_xy", {0xA050, 0x603D, 0x611A}, 0xD01F},
+            {"dxyn_h5_two_planes", {0xA050, 0x6000, 0x6100, 0xF301}, 0xD015},
+            {"ex9e_skp", {0x6000}, 0xE09E},
+            {"exa1_sknp", {0x6000}, 0xE0A1, false, true},
+            {"fx07_ld", {}, 0xFA07},
+            {"fx15_ld", {0x6000}, 0xF015},
+            {"fx18_ld", {0x6000}, 0xF018},
+            {"fx1e_add", {0x6101}, 0xF11E},
+            {"fx29_ld", {0x6005}, 0xF029},
+            {"fx33_bcd", {static_cast<std::uint16_t>(0xA000 | SCRATCH), 0x60FF}, 0xF033},
+            {"fx55_ld", {static_cast<std::uint16_t>(0xA000 | SCRATCH)}, 0xFF55},
+            {"fx65_ld", {static_cast<std::uint16_t>(0xA000 | SCRATCH)}, 0xFF65},
+            {"f000_nnnn_ld", {}, 0xF000}, // Pairs: each F000 loads the next as NNNN
+            {"fn01_plane", {}, 0xF301},
+        };
+        return cases;
+    }
+
+    void printUsage(const char *program)
+    {
+        std::cout << "CHIP-8 Benchmark Suite" << std::endl;
+        std::cout << "Usage: " << program << " [options]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --micro-cycles N  Cycles per opcode benchmark (default " << DEFAULT_MICRO_CYCLES << ")" << std::endl;
+        std::cout << "  --macro-cycles N  Cycles per ROM and backend (default " << DEFAULT_MACRO_CYCLES << ")" << std::endl;
+        std::cout << "  --repeat N        Repetitions; the best is reported (default " << DEFAULT_REPEAT << ")" << std::endl;
+        std::cout << "  --backend NAME    Backend for opcode benchmarks: interpreter, cached (default)," << std::endl;
+        std::cout << "                    threaded, jit or all" << std::endl;
+        std::cout << "  --rom-dir DIR     ROMs for the macro benchmarks (default " << CHIP8_ROM_DIR << ")" << std::endl;
+        std::cout << "  --module-dir DIR  Recompiled ROM modules; ROMs with one also run on aot" << std::endl;
+        std::cout << "                    (default " << CHIP8_AOT_DIR << ")" << std::endl;
+        std::cout << "  --filter TEXT     Only run benchmarks whose name contains TEXT" << std::endl;
+        std::cout << "  --output FILE     Write the JSON report to FILE instead of stdout" << std::endl;
+    }
+
+    bool parseCount(const char *text, std::uint64_t &value)
+    {
+        char *end = nullptr;
+        unsigned long long parsed = std::strtoull(text, &end, 10);
+        if (end == text || *end != '\0')
+        {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (std::strcmp(arg, "--micro-cycles") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.microCycles) || options.microCycles == 0)
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--macro-cycles") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.macroCycles) || options.macroCycles == 0)
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--repeat") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.repeat) || options.repeat == 0)
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--backend") == 0 && hasValue)
+            {
+                const char *name = argv[++i];
+                CPU::Backend backend;
+                if (std::strcmp(name, "all") == 0)
+                {
+                    options.microBackends = {CPU::Backend::Interpreter, CPU::Backend::Cached,
+                                             CPU::Backend::Threaded, CPU::Backend::Jit};
+                }
+                else if (CPU::parseBackendName(name, backend))
+                {
+                    options.microBackends = {backend};
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--rom-dir") == 0 && hasValue)
+            {
+                options.romDir = argv[++i];
+            }
+            else if (std::strcmp(arg, "--module-dir") == 0 && hasValue)
+            {
+                options.moduleDir = argv[++i];
+            }
+            else if (std::strcmp(arg, "--filter") == 0 && hasValue)
+            {
+                options.filter = argv[++i];
+            }
+            else if (std::strcmp(arg, "--output") == 0 && hasValue)
+            {
+                options.outputPath = argv[++i];
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool selected(const Options &options, const std::string &name)
+    {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    /**
+     * @brief Assemble the loop program for a micro case
+     * @param microCase Instruction to repeat
+     * @param program Receives the image to load at PROGRAM_START
+     */
+    void buildProgram(const MicroCase &microCase, std::vector<std::uint8_t> &program)
+    {
+        std::vector<std::uint16_t> words = microCase.setup;
+        const std::uint16_t bodyStart = static_cast<std::uint16_t>(Memory::PROGRAM_START + 2 * words.size());
+        for (std::uint16_t i = 0; i < BODY_LENGTH; ++i)
+        {
+            const std::uint16_t address = static_cast<std::uint16_t>(bodyStart + 2 * i);
+            words.push_back(microCase.chain
+                                ? static_cast<std::uint16_t>(microCase.opcode | (address + 2))
+                                : microCase.opcode);
+        }
+        words.push_back(static_cast<std::uint16_t>(0x1000 | bodyStart));
+
+        program.assign(SUBROUTINE + 2 - Memory::PROGRAM_START, 0);
+        for (std::size_t i = 0; i < words.size(); ++i)
+        {
+            program[2 * i] = static_cast<std::uint8_t>(words[i] >> 8);
+            program[2 * i + 1] = static_cast<std::uint8_t>(words[i]);
+        }
+        program[SUBROUTINE - Memory::PROGRAM_START] = 0x00;
+        program[SUBROUTINE - Memory::PROGRAM_START + 1] = 0xEE;
+    }
+
+    MicroResult runMicroCase(const MicroCase &microCase, CPU::Backend backend, const Options &options)
+    {
+        std::vector<std::uint8_t> program;
+        buildProgram(microCase, program);
+
+        // Machines are large (decode cache, translations), keep them off the stack
+        auto memory = std::make_unique<Memory>();
+        auto cpu = std::make_unique<CPU>(memory.get());
+        cpu->setBackend(backend);
+        cpu->setIdleSkipping(false);
+        memory->loadProgram(program.data(), program.size());
+        cpu->getKeys()[0] = microCase.holdKey0 ? 1 : 0;
+
+        // Setup, then one pass of warm-up so block backends have translated the loop
+        cpu->run(microCase.setup.size());
+        cpu->run(std::min<std::uint64_t>(options.microCycles, 16 * BODY_LENGTH));
+
+        double best = 0.0;
+        for (std::uint64_t i = 0; i < options.repeat; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            cpu->run(options.microCycles);
+            const double seconds = secondsSince(start);
+            best = i == 0 ? seconds : std::min(best, seconds);
+        }
+
+        MicroResult result;
+        result.name = microCase.name;
+        result.backend = CPU::backendName(cpu->getBackend());
+        result.iterations = options.microCycles;
+        result.nsPerOp = best * 1e9 / static_cast<double>(options.microCycles);
+        return result;
+    }
+
+    /**
+     * @brief Time a memory access loop
+     * @param operation Body run once per access, given the address
+     */
+    template <typename Operation>
+    MicroResult runMemoryCase(const char *name, const Options &options, Operation operation)
+    {
+        double best = 0.0;
+        for (std::uint64_t i = 0; i < options.repeat; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (std::uint64_t n = 0; n < options.microCycles; ++n)
+            {
+                operation(static_cast<std::uint16_t>(n & (Memory::MEMORY_SIZE - 1)));
+            }
+            const double seconds = secondsSince(start);
+            best = i == 0 ? seconds : std::min(best, seconds);
+        }
+
+        MicroResult result;
+        result.name = name;
+        result.backend = "-";
+        result.iterations = options.microCycles;
+        result.nsPerOp = best * 1e9 / static_cast<double>(options.microCycles);
+        return result;
+    }
+
+    void runMemoryCases(const Options &options, std::vector<MicroResult> &results)
+    {
+        auto memory = std::make_unique<Memory>();
+
+        if (selected(options, "memory_read"))
+        {
+            std::uint32_t sum = 0;
+            results.push_back(runMemoryCase("memory_read", options,
+                                            [&](std::uint16_t address)
+                                            { sum += memory->readByte(address); }));
+            sink = sum;
+        }
+        if (selected(options, "memory_write"))
+        {
+            results.push_back(runMemoryCase("memory_write", options,
+                                            [&](std::uint16_t address)
+                                            { memory->writeByte(address, static_cast<std::uint8_t>(address)); }));
+        }
+        if (selected(options, "memory_write_observed"))
+        {
+            // With a CPU attached every write invalidates decoded instructions
+            auto cpu = std::make_unique<CPU>(memory.get());
+            results.push_back(runMemoryCase("memory_write_observed", options,
+                                            [&](std::uint16_t address)
+                                            { memory->writeByte(address, static_cast<std::uint8_t>(address)); }));
+        }
+    }
+
+#ifdef CHIP8_BENCH_GRAPHICS
+    void runRenderCase(const Options &options, std::vector<MicroResult> &results)
+    {
+        if (!selected(options, "graphics_render"))
+        {
+            return;
+        }
+
+        Graphics graphics;
+        if (!graphics.initialize("chip8_bench", true))
+        {
+            return;
+        }
+        graphics.setTargetFPS(0); // Unthrottled
+
+        // Alternate between two busy frames so every upload changes the texture
+        std::array<std::array<std::uint64_t, CPU::DISPLAY_WORDS>, 2> frames;
+        for (std::size_t i = 0; i < CPU::DISPLAY_WORDS; ++i)
+        {
+            frames[0][i] = 0xA5A5A5A5A5A5A5A5ULL >> (i / CPU::DISPLAY_ROW_WORDS % 8);
+            frames[1][i] = ~frames[0][i];
+        }
+
+        // Low resolution, then the four times larger SUPER-CHIP frame
+        struct Mode
+        {
+            const char *name;
+            int width;
+            int height;
+        };
+        const Mode modes[] = {
+            {"graphics_render", static_cast<int>(CPU::LORES_WIDTH), static_cast<int>(CPU::LORES_HEIGHT)},
+            {"graphics_render_hires", static_cast<int>(CPU::HIRES_WIDTH), static_cast<int>(CPU::HIRES_HEIGHT)}};
+
+        const std::uint64_t renders = std::max<std::uint64_t>(options.microCycles / 1000, 100);
+        for (const Mode &mode : modes)
+        {
+            double best = 0.0;
+            for (std::uint64_t i = 0; i < options.repeat; ++i)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                for (std::uint64_t n = 0; n < renders; ++n)
+                {
+                    graphics.render(frames[n & 1].data(), mode.width, mode.height);
+                }
+                const double seconds = secondsSince(start);
+                best = i == 0 ? seconds : std::min(best, seconds);
+            }
+
+            MicroResult result;
+            result.name = mode.name;
+            result.backend = "-";
+            result.iterations = renders;
+            result.nsPerOp = best * 1e9 / static_cast<double>(renders);
+            results.push_back(result);
+        }
+        graphics.shutdown();
+    }
+#endif
+
+    bool readFile(const std::filesystem::path &path, std::vector<std::uint8_t> &data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    MacroResult runMacroCase(const std::string &romName, const std::vector<std::uint8_t> &rom,
+                             CPU::Backend backend, const AotModule *module, const Options &options)
+    {
+        MacroResult result;
+        result.rom = romName;
+        result.cycles = options.macroCycles;
+
+        for (std::uint64_t i = 0; i < options.repeat; ++i)
+        {
+            // Fresh machine each time, so every repetition does the same work
+            auto memory = std::make_unique<Memory>();
+            auto cpu = std::make_unique<CPU>(memory.get());
+            cpu->setBackend(backend);
+            cpu->setAotModule(module);
+            cpu->setIdleSkipping(false); // Time the backend, not the idle loop detector
+            memory->loadProgram(rom.data(), rom.size());
+
+            const auto start = std::chrono::steady_clock::now();
+            for (std::uint64_t done = 0; done < options.macroCycles; done += CYCLES_PER_FRAME)
+            {
+                cpu->run(std::min(CYCLES_PER_FRAME, options.macroCycles - done));
+                cpu->updateTimers();
+            }
+            const double seconds = secondsSince(start);
+
+            result.seconds = i == 0 ? seconds : std::min(result.seconds, seconds);
+            result.backend = CPU::backendName(cpu->getBackend());
+            result.framebufferHash = cpu->getDisplayHash();
+        }
+        return result;
+    }
+
+    bool runMacroCases(const Options &options, std::vector<MacroResult> &results)
+    {
+        std::vector<std::filesystem::path> roms;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(options.romDir, error))
+        {
+            if (entry.is_regular_file() && entry.path().extension() == ".ch8")
+            {
+                roms.push_back(entry.path());
+            }
+        }
+        if (error)
+        {
+            std::cerr << "Error: cannot read ROM directory: " << options.romDir << std::endl;
+            return false;
+        }
+        std::sort(roms.begin(), roms.end());
+
+        const CPU::Backend backends[] = {CPU::Backend::Interpreter, CPU::Backend::Cached,
+                                         CPU::Backend::Threaded, CPU::Backend::Jit};
+        for (const auto &path : roms)
+        {
+            std::vector<std::uint8_t> rom;
+            if (!readFile(path, rom))
+            {
+                std::cerr << "Error: cannot read ROM: " << path.string() << std::endl;
+                return false;
+            }
+            for (CPU::Backend backend : backends)
+            {
+                const std::string name = "rom_" + path.filename().string() + "_" + CPU::backendName(backend);
+                if (selected(options, name))
+                {
+                    results.push_back(runMacroCase(path.filename().string(), rom, backend, nullptr, options));
+                }
+            }
+
+            // The aot backend only runs ROMs that were recompiled
+            const std::filesystem::path modulePath =
+                std::filesystem::path(options.moduleDir) / (path.stem().string() + ".so");
+            const std::string name = "rom_" + path.filename().string() + "_aot";
+            if (selected(options, name) && std::filesystem::exists(modulePath, error))
+            {
+                AotModule module;
+                std::string reason;
+                if (!module.load(modulePath.string(), reason))
+                {
+                    std::cerr << "Error: " << reason << std::endl;
+                    return false;
+                }
+                results.push_back(runMacroCase(path.filename().string(), rom, CPU::Backend::Aot, &module, options));
+            }
+        }
+        return true;
+    }
+
+    std::string jsonString(const std::string &text)
+    {
+        std::string quoted = "\"";
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+            {
+                quoted += '\\';
+            }
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    void writeReport(std::ostream &out, const Options &options,
+                     const std::vector<MicroResult> &micro, const std::vector<MacroResult> &macro)
+    {
+        out << "{\n";
+        out << "  \"suite\": \"chip8_bench\",\n";
+        out << "  \"build_type\": " << jsonString(CHIP8_BUILD_TYPE) << ",\n";
+#ifdef __VERSION__
+        out << "  \"compiler\": " << jsonString(__VERSION__) << ",\n";
+#endif
+#ifdef CHIP8_BENCH_GRAPHICS
+        out << "  \"graphics\": true,\n";
+#else
+        out << "  \"graphics\": false,\n";
+#endif
+        out << "  \"repeat\": " << options.repeat << ",\n";
+
+        out << std::fixed;
+        out << "  \"micro\": [";
+        for (std::size_t i = 0; i < micro.size(); ++i)
+        {
+            const MicroResult &result = micro[i];
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\"name\": " << jsonString(result.name)
+                << ", \"backend\": " << jsonString(result.backend)
+                << ", \"iterations\": " << result.iterations
+                << ", \"ns_per_op\": " << std::setprecision(3) << result.nsPerOp << "}";
+        }
+        out << (micro.empty() ? "],\n" : "\n  ],\n");
+
+        out << "  \"macro\": [";
+        for (std::size_t i = 0; i < macro.size(); ++i)
+        {
+            const MacroResult &result = macro[i];
+            const double cyclesPerSecond = result.seconds > 0.0 ? result.cycles / result.seconds : 0.0;
+            std::ostringstream hash;
+            hash << "0x" << std::hex << std::setw(16) << std::setfill('0') << result.framebufferHash;
+
+            out << (i == 0 ? "\n" : ",\n")
+                << "    {\"rom\": " << jsonString(result.rom)
+                << ", \"backend\": " << jsonString(result.backend)
+                << ", \"cycles\": " << result.cycles
+                << ", \"seconds\": " << std::setprecision(6) << result.seconds
+                << ", \"cycles_per_sec\": " << std::setprecision(0) << cyclesPerSecond
+                << ", \"framebuffer_hash\": " << jsonString(hash.str()) << "}";
+        }
+        out << (macro.empty() ? "]\n" : "\n  ]\n");
+        out << "}\n";
+    }
+}
+
+/**
+ * @brief Benchmark suite entry point
+ * @param argc Number of command line arguments
+ * @param argv Array of command line arguments
+ * @return 0 on success, 1 on error
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<MicroResult> micro;
+    for (CPU::Backend backend : options.microBackends)
+    {
+        for (const MicroCase &microCase : microCases())
+        {
+            if (selected(options, microCase.name))
+            {
+                micro.push_back(runMicroCase(microCase, backend, options));
+            }
+        }
+    }
+    runMemoryCases(options, micro);
+#ifdef CHIP8_BENCH_GRAPHICS
+    runRenderCase(options, micro);
+#endif
+
+    std::vector<MacroResult> macro;
+    if (!runMacroCases(options, macro))
+    {
+        return 1;
+    }
+
+    if (options.outputPath.empty())
+    {
+        writeReport(std::cout, options, micro, macro);
+        return 0;
+    }
+
+    std::ofstream file(options.outputPath);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: cannot create " << options.outputPath << std::endl;
+        return 1;
+    }
+    writeReport(file, options, micro, macro);
+    return 0;
+}
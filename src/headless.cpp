@@ -0,0 +1,830 @@
+/**
+ * @file headless.cpp
+ * @brief CHIP-8 Emulator - Headless batch runner
+ *
+ * Runs a ROM without a window, input or frame pacing:
+ * - Executes a fixed number of frames or CPU cycles at full speed
+ * - Ticks the timers once per emulated frame
+ * - Reports throughput (cycles/sec) and a hash of the final framebuffer
+ * - Selects the execution backend and can check it against the reference
+ *   interpreter (--verify) or report its speedup over it (--compare)
+ * - Translates the statically analyzed blocks at load (--pretranslate)
+ * - Runs a ROM recompiled ahead of time by chip8_recompile (--module)
+ * - Runs many seeded instances of the ROM on the SIMD lockstep engine (--lanes)
+ * - Records a rewind history and checks stepping back through it (--rewind)
+ * - Replays a recorded input movie with its seed and timing (--replay)
+ * - Writes the generated sound to a WAV file (--wav)
+ * - Writes an opcode mix / hot PC / hot loop report (--profile, needs a
+ *   core built with -DCHIP8_PROFILER=ON)
+ *
+ * Only links against chip8_core, so it runs on display-less servers.
+ */
+
+#include "Analyzer.hpp"
+#include "AotModule.hpp"
+#include "AudioGenerator.hpp"
+#include "CPU.hpp"
+#include "FaultLog.hpp"
+#include "InputScript.hpp"
+#include "LockstepEngine.hpp"
+#include "Profiler.hpp"
+#include "RewindBuffer.hpp"
+#include "Memory.hpp"
+#include "WavWriter.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr std::uint64_t DEFAULT_FRAMES = 600;         ///< 10 seconds of emulated time at 60Hz
+    constexpr std::uint64_t DEFAULT_CYCLES_PER_FRAME = 9; ///< Matches the GUI (≈540Hz at 60FPS)
+
+    /**
+     * @brief Command line options for the headless runner
+     */
+    struct Options
+    {
+        std::string romPath;
+        std::uint64_t frames = DEFAULT_FRAMES;
+        std::uint64_t cycles = 0; ///< Total cycle budget, overrides frames when non-zero
+        std::uint64_t cyclesPerFrame = DEFAULT_CYCLES_PER_FRAME;
+        CPU::Backend backend = CPU::Backend::Cached;
+        CPU::Quirks quirks = CPU::QUIRKS_NONE;
+        std::uint32_t seed = CPU::DEFAULT_RANDOM_SEED; ///< CXNN seed (of lane 0 with --lanes)
+        CPU::RandomGenerator random = CPU::RandomGenerator::Xorshift;
+        bool verify = false;  ///< Lockstep check against the reference interpreter
+        bool compare = false; ///< Also time the reference interpreter
+        bool pretranslate = false; ///< Translate analyzed blocks before running
+        std::string modulePath;    ///< Recompiled module for the aot backend, empty = none
+        const AotModule *module = nullptr; ///< The loaded module
+        std::uint64_t lanes = 0; ///< Machines on the lockstep engine, 0 = single CPU
+        std::uint64_t rewind = 0; ///< Frames to step back after the run, 0 = no history
+        std::string replayPath;   ///< Input movie to replay, empty = no input
+        InputScript input;        ///< Keys held in each frame (from the movie)
+        std::string profilePath;  ///< Profile report destination, empty = no profiling
+        std::string wavPath;      ///< Sound output file, empty = no sound
+    };
+
+    /**
+     * @brief Outcome of one headless session
+     */
+    struct RunResult
+    {
+        std::uint64_t cycles = 0;
+        std::uint64_t frames = 0;
+        double seconds = 0.0;
+        bool diverged = false; ///< Set when --verify found a mismatch
+        bool halted = false;   ///< Set when the machine halted for good before the end
+        std::uint64_t haltFrame = 0; ///< Frame at which it halted
+        std::uint64_t faults = 0; ///< Fault events raised by the machine
+    };
+
+    void printUsage(const char *program)
+    {
+        std::cout << "CHIP-8 Headless Runner" << std::endl;
+        std::cout << "Usage: " << program << " <ROM_FILE> [options]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --frames N            Run N emulated frames (default " << DEFAULT_FRAMES << ")" << std::endl;
+        std::cout << "  --cycles N            Run N CPU cycles instead of a frame count" << std::endl;
+        std::cout << "  --cycles-per-frame N  CPU cycles per 60Hz timer tick (default "
+                  << DEFAULT_CYCLES_PER_FRAME << ")" << std::endl;
+        std::cout << "  --backend NAME        interpreter, cached (default), threaded, jit or aot" << std::endl;
+        std::cout << "  --module FILE         Recompiled module (chip8_recompile) run by --backend aot" << std::endl;
+        std::cout << "  --pretranslate        Translate the statically analyzed blocks at load (threaded, jit)" << std::endl;
+        std::cout << "  --quirks LIST         Variant behaviors: a profile (";
+        for (const CPU::QuirkProfile *profile = CPU::quirkProfiles(); profile->name; ++profile)
+        {
+            std::cout << (profile == CPU::quirkProfiles() ? "" : ", ") << profile->name;
+        }
+        std::cout << ")" << std::endl;
+        std::cout << "                        and/or flags (shift-vy, jump-vx, increment-i, reset-vf," << std::endl;
+        std::cout << "                        clip-sprites), comma-separated" << std::endl;
+        std::cout << "  --seed N              Random seed for CXNN (default " << CPU::DEFAULT_RANDOM_SEED << ")" << std::endl;
+        std::cout << "  --random NAME         CXNN generator: xorshift (default) or counter" << std::endl;
+        std::cout << "  --verify              Check every frame against the reference interpreter" << std::endl;
+        std::cout << "  --compare             Also run the reference interpreter and report the speedup" << std::endl;
+        std::cout << "  --rewind N            Record every frame, then rewind N frames and check the" << std::endl;
+        std::cout << "                        result against a fresh run of that many fewer frames" << std::endl;
+        std::cout << "  --lanes N             Run N instances (seeds from --seed up) on the SIMD lockstep engine;" << std::endl;
+        std::cout << "                        --verify/--compare check/time them against N scalar CPUs" << std::endl;
+        std::cout << "  --replay FILE         Feed the keys of an input movie; its seed, generator," << std::endl;
+        std::cout << "                        quirks, cycles per frame and length replace the options above" << std::endl;
+        std::cout << "  --profile FILE        Write an opcode/hot PC/hot loop profile to FILE (\"-\" = stdout);" << std::endl;
+        std::cout << "                        needs a build with -DCHIP8_PROFILER=ON" << std::endl;
+        std::cout << "  --wav FILE            Write the sound of every frame to FILE (16-bit mono, "
+                  << AudioGenerator::SAMPLE_RATE << "Hz)" << std::endl;
+    }
+
+    bool parseCount(const char *text, std::uint64_t &value)
+    {
+        char *end = nullptr;
+        unsigned long long parsed = std::strtoull(text, &end, 10);
+        if (end == text || *end != '\0')
+        {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (std::strcmp(arg, "--frames") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.frames))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--cycles") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.cycles))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--cycles-per-frame") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.cyclesPerFrame) || options.cyclesPerFrame == 0)
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--backend") == 0 && hasValue)
+            {
+                if (!CPU::parseBackendName(argv[++i], options.backend))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--quirks") == 0 && hasValue)
+            {
+                if (!CPU::parseQuirks(argv[++i], options.quirks))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--seed") == 0 && hasValue)
+            {
+                std::uint64_t value = 0;
+                if (!parseCount(argv[++i], value) || value > UINT32_MAX)
+                {
+                    return false;
+                }
+                options.seed = static_cast<std::uint32_t>(value);
+            }
+            else if (std::strcmp(arg, "--random") == 0 && hasValue)
+            {
+                if (!CPU::parseRandomGenerator(argv[++i], options.random))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--lanes") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.lanes) || options.lanes == 0)
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--rewind") == 0 && hasValue)
+            {
+                if (!parseCount(argv[++i], options.rewind))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--replay") == 0 && hasValue)
+            {
+                options.replayPath = argv[++i];
+            }
+            else if (std::strcmp(arg, "--profile") == 0 && hasValue)
+            {
+                options.profilePath = argv[++i];
+            }
+            else if (std::strcmp(arg, "--wav") == 0 && hasValue)
+            {
+                options.wavPath = argv[++i];
+            }
+            else if (std::strcmp(arg, "--verify") == 0)
+            {
+                options.verify = true;
+            }
+            else if (std::strcmp(arg, "--compare") == 0)
+            {
+                options.compare = true;
+            }
+            else if (std::strcmp(arg, "--module") == 0 && hasValue)
+            {
+                options.modulePath = argv[++i];
+            }
+            else if (std::strcmp(arg, "--pretranslate") == 0)
+            {
+                options.pretranslate = true;
+            }
+            else if (arg[0] != '-' && options.romPath.empty())
+            {
+                options.romPath = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !options.romPath.empty();
+    }
+
+    /**
+     * @brief Load the --module shared object for the aot backend
+     * @param options Session options; module is set when one was loaded
+     * @param module Holds the loaded module for the whole session
+     * @return true if there is no module or it loaded
+     */
+    bool loadModule(Options &options, AotModule &module)
+    {
+        if (options.modulePath.empty())
+        {
+            return true;
+        }
+        if (options.backend != CPU::Backend::Aot)
+        {
+            std::cerr << "Error: --module needs --backend aot" << std::endl;
+            return false;
+        }
+
+        std::string error;
+        if (!module.load(options.modulePath, error))
+        {
+            std::cerr << "Error: " << error << std::endl;
+            return false;
+        }
+        if (module.getQuirks() != options.quirks)
+        {
+            std::cerr << "Warning: " << options.modulePath << " was recompiled for quirks "
+                      << CPU::quirksName(module.getQuirks()) << " and will not be used" << std::endl;
+        }
+        options.module = &module;
+        return true;
+    }
+
+    /**
+     * @brief Load the --replay movie and let it override seed, quirks and timing
+     * @param options Session options, updated from the movie
+     * @return true if there is no movie or it loaded
+     */
+    bool loadReplay(Options &options)
+    {
+        if (options.replayPath.empty())
+        {
+            return true;
+        }
+
+        std::string error;
+        if (!options.input.load(options.replayPath, error))
+        {
+            std::cerr << "Error: " << error << std::endl;
+            return false;
+        }
+
+        // Movies without @seed were recorded with the default seed
+        options.seed = options.input.getSeed();
+        if (options.input.hasRandomGenerator())
+        {
+            options.random = options.input.getRandomGenerator();
+        }
+        if (options.input.hasQuirks())
+        {
+            options.quirks = options.input.getQuirks();
+        }
+        if (options.input.getCyclesPerFrame() != 0)
+        {
+            options.cyclesPerFrame = options.input.getCyclesPerFrame();
+        }
+        if (options.input.getFrameCount() != 0)
+        {
+            options.frames = options.input.getFrameCount();
+            options.cycles = 0;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check that the loaded ROM is the one the movie was recorded on
+     */
+    bool checkReplayROM(const Options &options, std::uint64_t romHash)
+    {
+        if (!options.input.hasROMHash() || options.input.getROMHash() == romHash)
+        {
+            return true;
+        }
+        std::cerr << "Error: " << options.replayPath << " was recorded with a different ROM" << std::endl;
+        return false;
+    }
+
+    /**
+     * @brief Check two lists of fault events for the same faults in the same order
+     */
+    bool sameFaults(const std::vector<CPU::FaultEvent> &a, const std::vector<CPU::FaultEvent> &b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                          [](const CPU::FaultEvent &x, const CPU::FaultEvent &y)
+                          {
+                              return x.type == y.type && x.pc == y.pc && x.address == y.address &&
+                                     x.opcode == y.opcode;
+                          });
+    }
+
+    /**
+     * @brief Run the configured number of cycles on a machine
+     * @param cpu Machine to run
+     * @param options Session options
+     * @param reference Optional reference machine stepped in lockstep and
+     *                  compared after every frame
+     * @param history Optional rewind history, fed the state after every frame
+     * @param wav Optional sound output, fed the samples of every frame
+     */
+    RunResult runSession(CPU &cpu, const Options &options, CPU *reference, RewindBuffer *history = nullptr,
+                         WavWriter *wav = nullptr)
+    {
+        RunResult result;
+        FaultLog faults;
+        FaultLog referenceFaults;
+        std::vector<CPU::FaultEvent> machineEvents;   // Faults of the current frame, with a reference
+        std::vector<CPU::FaultEvent> referenceEvents;
+        AudioGenerator sound;
+        std::array<std::int16_t, AudioGenerator::SAMPLES_PER_FRAME> samples;
+        if (history)
+        {
+            history->push(cpu);
+        }
+
+        const std::uint64_t totalCycles = options.cycles != 0
+                                              ? options.cycles
+                                              : options.frames * options.cyclesPerFrame;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        while (result.cycles < totalCycles)
+        {
+            // Keys change only on frame boundaries, as in the GUI
+            if (result.cycles % options.cyclesPerFrame == 0)
+            {
+                options.input.apply(result.frames, cpu.getKeys());
+                if (reference)
+                {
+                    options.input.apply(result.frames, reference->getKeys());
+                }
+            }
+
+            // A machine halted for good only counts its timers down from here;
+            // finish at once unless every frame has to be observed
+            if (result.cycles % options.cyclesPerFrame == 0 && !reference && !history && !wav &&
+                options.profilePath.empty() && cpu.isHalted() && !options.input.changesAfter(result.frames))
+            {
+                const std::uint64_t remaining = totalCycles - result.cycles;
+                const std::uint64_t frames = remaining / options.cyclesPerFrame;
+                cpu.run(remaining);
+                for (std::uint64_t i = 0; i < std::min<std::uint64_t>(frames, 255); ++i)
+                {
+                    cpu.updateTimers();
+                }
+                result.halted = true;
+                result.haltFrame = result.frames;
+                result.cycles = totalCycles;
+                result.frames += frames;
+                break;
+            }
+
+            // Run one frame worth of cycles (or whatever is left of the budget)
+            std::uint64_t frameCycles = totalCycles - result.cycles;
+            if (frameCycles > options.cyclesPerFrame)
+            {
+                frameCycles = options.cyclesPerFrame;
+            }
+
+            cpu.run(frameCycles);
+            result.cycles += frameCycles;
+
+            // Timers tick at 60Hz, i.e. once per completed emulated frame
+            const bool frameComplete = frameCycles == options.cyclesPerFrame;
+            if (frameComplete)
+            {
+                if (wav)
+                {
+                    sound.renderFrame(cpu, samples.data());
+                    wav->write(samples.data(), samples.size());
+                }
+                cpu.updateTimers();
+                faults.drain(cpu, &std::cerr, reference ? &machineEvents : nullptr);
+                result.frames++;
+                if (history)
+                {
+                    history->push(cpu);
+                }
+            }
+
+            if (reference)
+            {
+                reference->run(frameCycles);
+                if (frameComplete)
+                {
+                    reference->updateTimers();
+                }
+                if (!cpu.hasSameState(*reference))
+                {
+                    std::cerr << "Divergence from reference interpreter after cycle "
+                              << result.cycles << " (frame " << result.frames << ")" << std::endl;
+                    result.diverged = true;
+                    break;
+                }
+
+                // Every backend reports the same faults, in the same order
+                faults.drain(cpu, &std::cerr, &machineEvents);
+                referenceFaults.drain(*reference, nullptr, &referenceEvents);
+                if (!sameFaults(machineEvents, referenceEvents) ||
+                    cpu.getDroppedFaults() != reference->getDroppedFaults())
+                {
+                    std::cerr << "Faults differ from reference interpreter after cycle "
+                              << result.cycles << " (frame " << result.frames << ")" << std::endl;
+                    result.diverged = true;
+                    break;
+                }
+                machineEvents.clear();
+                referenceEvents.clear();
+            }
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+        result.seconds = std::chrono::duration<double>(end - start).count();
+
+        faults.drain(cpu, &std::cerr);
+        result.faults = faults.getTotal() + faults.getDropped();
+        return result;
+    }
+
+    double cyclesPerSecond(const RunResult &result)
+    {
+        return result.seconds > 0.0 ? static_cast<double>(result.cycles) / result.seconds : 0.0;
+    }
+
+    /**
+     * @brief Run options.lanes seeded instances on the lockstep engine
+     *
+     * Lane N uses random seed options.seed + N. With --verify or
+     * --compare the same instances also run as separate CPUs using the
+     * selected backend; --verify compares every lane after every frame.
+     * @param options Session options
+     * @return Process exit code
+     */
+    int runLockstep(const Options &options)
+    {
+        const std::uint32_t seed = options.seed;
+        const std::size_t lanes = static_cast<std::size_t>(options.lanes);
+        const std::uint64_t frames = options.cycles != 0
+                                         ? (options.cycles + options.cyclesPerFrame - 1) / options.cyclesPerFrame
+                                         : options.frames;
+
+        LockstepEngine engine(lanes);
+        engine.setQuirks(options.quirks);
+        engine.setRandomGenerator(options.random);
+        for (std::size_t lane = 0; lane < lanes; ++lane)
+        {
+            engine.setRandomSeed(lane, seed + static_cast<std::uint32_t>(lane));
+        }
+        if (!engine.loadROM(options.romPath.c_str()) ||
+            !checkReplayROM(options, engine.getROMHash()))
+        {
+            return 1;
+        }
+
+        // Scalar machines for --verify and --compare
+        std::vector<std::unique_ptr<Memory>> memories;
+        std::vector<std::unique_ptr<CPU>> machines;
+        if (options.verify || options.compare)
+        {
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+            {
+                memories.push_back(std::make_unique<Memory>());
+                machines.push_back(std::make_unique<CPU>(memories.back().get()));
+                machines.back()->setBackend(options.backend);
+                machines.back()->setAotModule(options.module);
+                machines.back()->setQuirks(options.quirks);
+                machines.back()->setRandomGenerator(options.random);
+                machines.back()->setRandomSeed(seed + static_cast<std::uint32_t>(lane));
+                machines.back()->reset();
+            }
+
+            // Load the file once and copy the program to the other machines
+            if (!memories[0]->loadROM(options.romPath.c_str()))
+            {
+                return 1;
+            }
+            std::vector<std::uint8_t> program(Memory::MEMORY_SIZE - Memory::PROGRAM_START);
+            for (std::size_t i = 0; i < program.size(); ++i)
+            {
+                program[i] = memories[0]->readByte(static_cast<std::uint16_t>(Memory::PROGRAM_START + i));
+            }
+            for (std::size_t lane = 1; lane < lanes; ++lane)
+            {
+                memories[lane]->loadProgram(program.data(), program.size());
+            }
+        }
+
+        bool diverged = false;
+        double seconds = 0.0;
+        double scalarSeconds = 0.0;
+        std::uint64_t frame = 0;
+        for (; frame < frames && !diverged; ++frame)
+        {
+            const std::uint16_t keyMask = options.input.keyMaskAt(frame);
+            for (std::size_t lane = 0; lane < lanes; ++lane)
+            {
+                engine.setKeys(lane, keyMask);
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            engine.run(options.cyclesPerFrame);
+            engine.updateTimers();
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (machines.empty())
+            {
+                continue;
+            }
+
+            start = std::chrono::steady_clock::now();
+            for (auto &machine : machines)
+            {
+                options.input.apply(frame, machine->getKeys());
+                machine->run(options.cyclesPerFrame);
+                machine->updateTimers();
+            }
+            scalarSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            for (std::size_t lane = 0; options.verify && lane < lanes; ++lane)
+            {
+                if (!engine.getMachine(lane).hasSameState(*machines[lane]))
+                {
+                    std::cerr << "Divergence in lane " << lane << " at frame " << frame + 1 << std::endl;
+                    diverged = true;
+                    break;
+                }
+            }
+        }
+
+        const std::uint64_t cycles = frame * options.cyclesPerFrame * lanes;
+        std::cout << "rom: " << options.romPath << std::endl;
+        std::cout << "engine: lockstep" << std::endl;
+        std::cout << "lanes: " << lanes << std::endl;
+        std::cout << "quirks: " << CPU::quirksName(engine.getQuirks()) << std::endl;
+        std::cout << "frames: " << frame << std::endl;
+        std::cout << "cycles: " << cycles << std::endl;
+        std::cout << "elapsed_sec: " << std::fixed << std::setprecision(6) << seconds << std::endl;
+        std::cout << "cycles_per_sec: " << std::fixed << std::setprecision(0)
+                  << (seconds > 0.0 ? cycles / seconds : 0.0) << std::endl;
+        std::cout << "framebuffer_hash: 0x" << std::hex << std::setw(16) << std::setfill('0')
+                  << engine.getMachine(0).getDisplayHash() << std::dec << std::setfill(' ') << std::endl;
+
+        if (options.verify)
+        {
+            std::cout << "verify: " << (diverged ? "FAILED" : "ok") << std::endl;
+        }
+        if (!machines.empty())
+        {
+            std::cout << "scalar_backend: " << CPU::backendName(machines[0]->getBackend()) << std::endl;
+            std::cout << "scalar_cycles_per_sec: " << std::fixed << std::setprecision(0)
+                      << (scalarSeconds > 0.0 ? cycles / scalarSeconds : 0.0) << std::endl;
+            std::cout << "speedup_vs_scalar: " << std::fixed << std::setprecision(2)
+                      << (seconds > 0.0 ? scalarSeconds / seconds : 0.0) << "x" << std::endl;
+        }
+        return diverged ? 1 : 0;
+    }
+}
+
+/**
+ * @brief Headless runner entry point
+ * @param argc Number of command line arguments
+ * @param argv Array of command line arguments
+ * @return 0 on success, 1 on error
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // The replay may change the quirks the module is checked against
+    AotModule module;
+    if (!loadReplay(options) || !loadModule(options, module))
+    {
+        return 1;
+    }
+
+    if (options.lanes != 0)
+    {
+        if (!options.wavPath.empty())
+        {
+            std::cerr << "Error: --wav is not supported with --lanes" << std::endl;
+            return 1;
+        }
+        return runLockstep(options);
+    }
+
+    Memory memory;
+    CPU cpu(&memory);
+    cpu.setBackend(options.backend);
+    cpu.setAotModule(options.module);
+    cpu.setQuirks(options.quirks);
+    cpu.setRandomGenerator(options.random);
+    cpu.setRandomSeed(options.seed);
+
+    if (!memory.loadROM(options.romPath.c_str()) || !checkReplayROM(options, memory.getROMHash()))
+    {
+        return 1;
+    }
+
+    std::size_t pretranslated = 0;
+    if (options.pretranslate)
+    {
+        Analyzer analysis;
+        analysis.analyze(memory, options.quirks);
+        cpu.translate(analysis);
+        pretranslated = analysis.getBlocks().size();
+    }
+
+    // Heap: the PC histograms are large
+    std::unique_ptr<Profiler> profiler;
+    if (!options.profilePath.empty())
+    {
+        profiler = std::make_unique<Profiler>();
+        if (!cpu.setProfiler(profiler.get()))
+        {
+            std::cerr << "Error: profiling is not built in (configure with -DCHIP8_PROFILER=ON)" << std::endl;
+            return 1;
+        }
+    }
+
+    // Reference machine for --verify and --compare
+    Memory referenceMemory;
+    CPU reference(&referenceMemory);
+    reference.setBackend(CPU::Backend::Interpreter);
+    reference.setIdleSkipping(false); // Also checks that skipped idle loops change nothing
+    reference.setQuirks(options.quirks);
+    reference.setRandomGenerator(options.random);
+    reference.setRandomSeed(options.seed);
+    if ((options.verify || options.compare) && !referenceMemory.loadROM(options.romPath.c_str()))
+    {
+        return 1;
+    }
+
+    WavWriter wav;
+    if (!options.wavPath.empty())
+    {
+        std::string error;
+        if (!wav.open(options.wavPath, AudioGenerator::SAMPLE_RATE, error))
+        {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+
+    RewindBuffer history(options.rewind != 0 ? RewindBuffer::DEFAULT_CAPACITY : 0);
+    const RunResult result = runSession(cpu, options, options.verify ? &reference : nullptr,
+                                        options.rewind != 0 ? &history : nullptr,
+                                        wav.isOpen() ? &wav : nullptr);
+    cpu.setProfiler(nullptr);
+
+    std::cout << "rom: " << options.romPath << std::endl;
+    std::cout << "rom_hash: " << std::hex << std::setw(16) << std::setfill('0')
+              << memory.getROMHash() << std::dec << std::setfill(' ') << std::endl;
+    if (!options.replayPath.empty())
+    {
+        std::cout << "replay: " << options.replayPath << std::endl;
+    }
+    std::cout << "backend: " << CPU::backendName(cpu.getBackend()) << std::endl;
+    std::cout << "quirks: " << CPU::quirksName(cpu.getQuirks()) << std::endl;
+    if (options.module)
+    {
+        std::cout << "module: " << options.modulePath << " (" << options.module->getBlockCount() << " blocks)"
+                  << std::endl;
+    }
+    if (options.pretranslate)
+    {
+        std::cout << "pretranslated_blocks: " << pretranslated << std::endl;
+    }
+    std::cout << "frames: " << result.frames << std::endl;
+    std::cout << "cycles: " << result.cycles << std::endl;
+    std::cout << "elapsed_sec: " << std::fixed << std::setprecision(6) << result.seconds << std::endl;
+    std::cout << "cycles_per_sec: " << std::fixed << std::setprecision(0) << cyclesPerSecond(result) << std::endl;
+    std::cout << "framebuffer_hash: 0x" << std::hex << std::setw(16) << std::setfill('0')
+              << cpu.getDisplayHash() << std::dec << std::setfill(' ') << std::endl;
+    std::cout << "faults: " << result.faults << std::endl;
+    if (result.halted)
+    {
+        std::cout << "halted_at_frame: " << result.haltFrame << std::endl;
+    }
+
+    if (options.verify)
+    {
+        std::cout << "verify: " << (result.diverged ? "FAILED" : "ok") << std::endl;
+    }
+
+    if (wav.isOpen())
+    {
+        std::cout << "wav: " << options.wavPath << std::endl;
+        std::cout << "wav_samples: " << wav.getSampleCount() << std::endl;
+        std::string error;
+        if (!wav.close(error))
+        {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+
+    if (profiler)
+    {
+        std::string error;
+        if (!profiler->saveReport(options.profilePath, memory, error))
+        {
+            std::cerr << "Error: " << error << std::endl;
+            return 1;
+        }
+    }
+
+    bool rewindFailed = false;
+    if (options.rewind != 0)
+    {
+        const std::size_t historyBytes = history.getUsedBytes();
+        const std::size_t historyFrames = history.getFrameCount();
+
+        std::uint64_t rewound = 0;
+        const auto start = std::chrono::steady_clock::now();
+        while (rewound < options.rewind && history.rewind(cpu))
+        {
+            rewound++;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // A fresh machine run for the remaining frames must match
+        Memory replayMemory;
+        CPU replay(&replayMemory);
+        replay.setQuirks(options.quirks);
+        replay.setRandomGenerator(options.random);
+        replay.setRandomSeed(options.seed);
+        if (!replayMemory.loadROM(options.romPath.c_str()))
+        {
+            return 1;
+        }
+        Options replayOptions = options;
+        replayOptions.cycles = 0;
+        replayOptions.frames = result.frames - rewound;
+        runSession(replay, replayOptions, nullptr);
+        rewindFailed = !cpu.hasSameState(replay);
+
+        std::cout << "rewind_history_frames: " << historyFrames << std::endl;
+        std::cout << "rewind_history_bytes: " << historyBytes << std::endl;
+        std::cout << "rewind_bytes_per_frame: " << std::fixed << std::setprecision(1)
+                  << (historyFrames ? static_cast<double>(historyBytes) / historyFrames : 0.0) << std::endl;
+        std::cout << "rewind_frames: " << rewound << std::endl;
+        std::cout << "rewind_usec_per_frame: " << std::fixed << std::setprecision(2)
+                  << (rewound ? seconds * 1e6 / rewound : 0.0) << std::endl;
+        std::cout << "rewind: " << (rewindFailed ? "FAILED" : "ok") << std::endl;
+    }
+
+    if (options.compare && !options.verify)
+    {
+        const RunResult baseline = runSession(reference, options, nullptr);
+        const double speedup = cyclesPerSecond(baseline) > 0.0
+                                   ? cyclesPerSecond(result) / cyclesPerSecond(baseline)
+                                   : 0.0;
+        std::cout << "interpreter_cycles_per_sec: " << std::fixed << std::setprecision(0)
+                  << cyclesPerSecond(baseline) << std::endl;
+        std::cout << "speedup_vs_interpreter: " << std::fixed << std::setprecision(2) << speedup << "x" << std::endl;
+        if (!cpu.hasSameState(reference))
+        {
+            std::cout << "final_state_matches_interpreter: no" << std::endl;
+            return 1;
+        }
+        std::cout << "final_state_matches_interpreter: yes" << std::endl;
+    }
+
+    return (result.diverged || rewindFailed) ? 1 : 0;
+}
+
@@ -4,24 +4,155 @@
  *
  * This is a simple CHIP-8 emulator implementation featuring:
  * - Complete CHIP-8 instruction set
- * - 64x32 pixel display with scaling
+ * - 64x32 pixel display with scaling (128x64 in SUPER-CHIP mode, two
+ *   XO-CHIP bitplanes)
  * - 16-key hexadecimal keypad input
  * - ROM loading capabilities
- * - No sound output (sound timer functionality removed)
+ * - Sound: the sound timer beep and XO-CHIP pattern audio
  *
  * The emulator consists of:
  * - CPU: Handles instruction execution and timing
- * - Memory: Manages 4KB RAM and ROM loading
- * - Graphics: Renders 64x32 pixel display using Raylib
+ * - Memory: Manages 64KB RAM and ROM loading
+ * - Graphics: Renders the 64x32 or 128x64 pixel display using Raylib
  * - Input: Handles 16-key hexadecimal keypad input
+ * - Audio: Generates each frame's samples and streams them to the device
+ *
+ * Emulation runs on its own thread, paced by a Scheduler (configurable
+ * instructions per second, 60Hz timers, fast-forward and slow motion), and
+ * hands finished frames to the render (main) thread through a lock-free
+ * triple buffer;
+ * held keys travel the other way in one atomic word. A slow present does
+ * not stall emulation, and the two sides need not run at the same rate.
  */
 
+#include "AudioGenerator.hpp"
+#include "AudioOutput.hpp"
 #include "CPU.hpp"
+#include "FaultLog.hpp"
 #include "Memory.hpp"
 #include "Graphics.hpp"
 #include "Input.hpp"
+#include "InputScript.hpp"
+#include "Profiler.hpp"
+#include "RewindBuffer.hpp"
+#include "Scheduler.hpp"
+#include "SpeedTable.hpp"
+#include "TripleBuffer.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+
+static_assert(Graphics::ROW_WORDS == static_cast<int>(CPU::DISPLAY_ROW_WORDS) &&
+                  Graphics::MAX_HEIGHT == static_cast<int>(CPU::DISPLAY_HEIGHT),
+              "Graphics must use the CPU display layout");
+
+/**
+ * @brief Parse an RRGGBB hex color
+ * @param text Color text, with or without a leading '#'
+ * @param color Parsed color (opaque)
+ * @return true if the text is a valid color
+ */
+static bool parseColor(const char *text, Color &color)
+{
+    if (text[0] == '#')
+    {
+        ++text;
+    }
+
+    char *end = nullptr;
+    unsigned long value = std::strtoul(text, &end, 16);
+    if (std::strlen(text) != 6 || *end != '\0')
+    {
+        return false;
+    }
+
+    color.r = static_cast<unsigned char>((value >> 16) & 0xFF);
+    color.g = static_cast<unsigned char>((value >> 8) & 0xFF);
+    color.b = static_cast<unsigned char>(value & 0xFF);
+    color.a = 255;
+    return true;
+}
+
+/**
+ * @brief Parse an instructions-per-second rate
+ * @param text Decimal rate
+ * @param rate Parsed rate (1..Scheduler::MAX_INSTRUCTIONS_PER_SECOND)
+ * @return true if the text is a valid rate
+ */
+static bool parseRate(const char *text, std::uint32_t &rate)
+{
+    char *end = nullptr;
+    unsigned long value = std::strtoul(text, &end, 10);
+    if (end == text || *end != '\0' || value == 0 || value > Scheduler::MAX_INSTRUCTIONS_PER_SECOND)
+    {
+        return false;
+    }
+    rate = static_cast<std::uint32_t>(value);
+    return true;
+}
+
+/**
+ * @brief Parse the most frames to catch up after a stall
+ * @param text Decimal frame count, at least 1
+ * @param frames Parsed count
+ * @return true if the text is a valid count
+ */
+static bool parseCatchUp(const char *text, std::uint32_t &frames)
+{
+    char *end = nullptr;
+    unsigned long long value = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || text[0] == '-' || value == 0 || value > UINT32_MAX)
+    {
+        return false;
+    }
+    frames = static_cast<std::uint32_t>(value);
+    return true;
+}
+
+/**
+ * @brief Parse a random seed
+ * @param text Decimal seed, 0..2^32-1
+ * @param seed Parsed seed
+ * @return true if the text is a valid seed
+ */
+static bool parseSeed(const char *text, std::uint32_t &seed)
+{
+    char *end = nullptr;
+    unsigned long long value = std::strtoull(text, &end, 10);
+    if (end == text || *end != '\0' || text[0] == '-' || value > UINT32_MAX)
+    {
+        return false;
+    }
+    seed = static_cast<std::uint32_t>(value);
+    return true;
+}
+
+/**
+ * @brief Parse a speed factor
+ * @param text Factor such as 2 or 0.5
+ * @param speed Parsed factor (Scheduler::MIN_SPEED..Scheduler::MAX_SPEED)
+ * @return true if the text is a valid factor
+ */
+static bool parseSpeed(const char *text, double &speed)
+{
+    char *end = nullptr;
+    double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !(value >= Scheduler::MIN_SPEED && value <= Scheduler::MAX_SPEED))
+    {
+        return false;
+    }
+    speed = value;
+    return true;
+}
 
 /**
  * @class Emulator
@@ -30,12 +161,200 @@
 class Emulator
 {
 private:
-    static constexpr int CPU_CYCLES_PER_FRAME = 9; ///< CPU cycles to execute per frame (≈540Hz at 60FPS)
+    static constexpr double SLOW_MOTION_SPEED = 0.25; ///< Speed factor while slow motion is on
+    static constexpr std::chrono::milliseconds IDLE_TIMEOUT{100}; ///< Longest idle sleep between input checks
+
+    // Input bits above the keypad mask
+    static constexpr std::uint32_t KEYPAD_MASK = (1u << CPU::KEY_COUNT) - 1;
+    static constexpr std::uint32_t REWIND_HELD = 1u << CPU::KEY_COUNT;
+    static constexpr std::uint32_t FAST_FORWARD_HELD = REWIND_HELD << 1;
+    static constexpr std::uint32_t SLOW_MOTION_ON = REWIND_HELD << 2;
+    static constexpr std::uint32_t IDLE_ON = REWIND_HELD << 3; ///< Marks idleInput as set
+
+    /**
+     * @brief Display contents at the end of an emulated frame
+     */
+    struct Frame
+    {
+        std::array<std::array<std::uint64_t, CPU::DISPLAY_WORDS>, CPU::DISPLAY_PLANES> planes;
+        int width = CPU::LORES_WIDTH;
+        int height = CPU::LORES_HEIGHT;
+    };
 
     Memory memory;     ///< Memory management system
     CPU cpu;           ///< Central processing unit
     Graphics graphics; ///< Graphics rendering system
     Input input;       ///< Input handling system
+    AudioGenerator sound; ///< Turns the sound state into samples
+    AudioOutput speaker;  ///< Streams the samples to the audio device
+    std::array<std::int16_t, AudioGenerator::SAMPLES_PER_FRAME> samples; ///< One frame of sound
+    RewindBuffer history; ///< Per-frame states for rewinding
+    FaultLog faults;      ///< Rate-limited fault diagnostics
+    InputScript movie;    ///< Keys held in each frame, when recording
+    std::string moviePath; ///< Where to save the movie, empty = not recording
+    std::unique_ptr<Profiler> profiler; ///< Execution profile, when profiling
+    std::string profilePath;              ///< Where to write the profile report
+    std::uint64_t frame = 0;              ///< Emulated frames, stepped back by rewinds
+    Scheduler scheduler;                  ///< Emulated clock (emulation thread once running)
+    double baseSpeed = 1.0;               ///< Speed factor without fast-forward or slow motion
+    double fastForwardSpeed = 4.0;        ///< Speed factor while fast-forward is held
+
+    // Shared between the emulation and render threads
+    TripleBuffer<Frame> frames;             ///< Finished frames, emulation -> render
+    std::atomic<std::uint32_t> inputState{0}; ///< Held keys and control bits, render -> emulation
+    std::atomic<bool> running{false};       ///< Cleared to stop the emulation thread
+    std::atomic<std::uint64_t> droppedFrames{0}; ///< Frames the scheduler dropped, for the status line
+    std::atomic<std::uint32_t> idleInput{0}; ///< Input the emulation thread sleeps on, | IDLE_ON; 0 = running
+    std::mutex idleMutex;                   ///< Guards the idle wait against lost wake-ups
+    std::condition_variable idleWake;       ///< Signalled when the input changes or on exit
+
+    /**
+     * @brief Whether nothing can happen until the input changes (emulation thread)
+     *
+     * Halted (on FX0A or a jump to itself) with no key held and both timers
+     * stopped: frames would neither change the machine nor make a sound.
+     */
+    bool isIdle(std::uint32_t input) const
+    {
+        return (input & (KEYPAD_MASK | REWIND_HELD)) == 0 && cpu.isHalted() &&
+               cpu.getDelayTimer() == 0 && cpu.getSoundTimer() == 0;
+    }
+
+    /**
+     * @brief Publish new input and wake an idle emulation thread (render thread)
+     */
+    void setInput(std::uint32_t input)
+    {
+        if (inputState.exchange(input, std::memory_order_acq_rel) != input)
+        {
+            wakeEmulation();
+        }
+    }
+
+    void wakeEmulation()
+    {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+        }
+        idleWake.notify_one();
+    }
+
+    /**
+     * @brief Emulate one frame (emulation thread)
+     * @param input Keypad mask and control bits, as last published by the render thread
+     * @param cycles CPU cycles in this frame
+     */
+    void stepFrame(std::uint32_t input, std::uint64_t cycles)
+    {
+        if (input & REWIND_HELD)
+        {
+            // Step back one frame; stays on the oldest frame once history runs out
+            if (history.rewind(cpu))
+            {
+                frame--;
+                movie.truncate(frame);
+            }
+
+            // Rewinding is silent; keep the device fed so it does not underrun
+            samples.fill(0);
+            sound.reset();
+            speaker.push(samples.data(), samples.size());
+            return;
+        }
+
+        InputScript::applyKeyMask(static_cast<std::uint16_t>(input), cpu.getKeys());
+        movie.record(frame, static_cast<std::uint16_t>(input));
+
+        cpu.run(cycles);
+
+        // Sound for this frame, before the sound timer ticks down
+        sound.renderFrame(cpu, samples.data());
+        speaker.push(samples.data(), samples.size());
+
+        // Update timers at 60Hz (once per frame)
+        cpu.updateTimers();
+
+        // Report what the ROM did wrong this frame, without flooding the console
+        faults.drain(cpu, &std::cerr);
+
+        // Record the frame for rewinding
+        history.push(cpu);
+        frame++;
+    }
+
+    /**
+     * @brief Hand the current display to the render thread (emulation thread)
+     */
+    void publishFrame()
+    {
+        Frame &out = frames.writeBuffer();
+        out.planes[0] = cpu.getDisplayRows(0);
+        out.planes[1] = cpu.getDisplayRows(1);
+        out.width = static_cast<int>(cpu.getDisplayWidth());
+        out.height = static_cast<int>(cpu.getDisplayHeight());
+        frames.publish();
+    }
+
+    /**
+     * @brief Speed factor for the fast-forward and slow motion controls
+     */
+    double speedFor(std::uint32_t input) const
+    {
+        double speed = baseSpeed;
+        if (input & FAST_FORWARD_HELD)
+        {
+            speed *= fastForwardSpeed;
+        }
+        if (input & SLOW_MOTION_ON)
+        {
+            speed *= SLOW_MOTION_SPEED;
+        }
+        return speed;
+    }
+
+    /**
+     * @brief Emulation thread: run the frames the scheduler says are due, then sleep
+     */
+    void emulationLoop()
+    {
+        scheduler.start(Scheduler::Clock::now());
+        while (running.load(std::memory_order_acquire))
+        {
+            const std::uint32_t input = inputState.load(std::memory_order_acquire);
+            if (isIdle(input))
+            {
+                // Sleep instead of re-running FX0A; the render thread stops drawing meanwhile
+                idleInput.store(input | IDLE_ON, std::memory_order_release);
+                {
+                    std::unique_lock<std::mutex> lock(idleMutex);
+                    idleWake.wait_for(lock, IDLE_TIMEOUT, [this, input]
+                                      { return inputState.load(std::memory_order_acquire) != input ||
+                                               !running.load(std::memory_order_acquire); });
+                }
+                idleInput.store(0, std::memory_order_release);
+
+                // The idle time is not caught up; those frames would have done nothing
+                scheduler.start(Scheduler::Clock::now());
+                continue;
+            }
+
+            const Scheduler::Clock::time_point now = Scheduler::Clock::now();
+            scheduler.setSpeed(speedFor(input), now);
+
+            const std::uint32_t due = scheduler.advance(now);
+            droppedFrames.store(scheduler.getDroppedFrames(), std::memory_order_relaxed);
+            for (std::uint32_t i = 0; i < due; ++i)
+            {
+                stepFrame(input, scheduler.nextFrameCycles());
+            }
+            if (due != 0)
+            {
+                publishFrame();
+            }
+
+            std::this_thread::sleep_until(scheduler.nextDeadline());
+        }
+    }
 
 public:
     /**
@@ -63,6 +382,107 @@ public:
         return true;
     }
 
+    /**
+     * @brief Set display colors
+     * @param foreground Color of lit pixels
+     * @param background Color of unlit pixels
+     */
+    void setColors(Color foreground, Color background)
+    {
+        graphics.setColors(foreground, background);
+    }
+
+    /**
+     * @brief Select the variant behaviors of the CPU
+     * @param quirks Combination of CPU::QUIRK_* flags
+     */
+    void setQuirks(CPU::Quirks quirks)
+    {
+        cpu.setQuirks(quirks);
+    }
+
+    /**
+     * @brief Select the CXNN random number generator and its seed
+     * @param generator Generator (CPU::setRandomGenerator())
+     * @param seed Seed value
+     */
+    void setRandom(CPU::RandomGenerator generator, std::uint32_t seed)
+    {
+        cpu.setRandomGenerator(generator);
+        cpu.setRandomSeed(seed);
+    }
+
+    /**
+     * @brief Set the emulated CPU rate
+     * @param rate Instructions per second (the timers always run at 60Hz)
+     */
+    void setInstructionsPerSecond(std::uint32_t rate)
+    {
+        scheduler.setInstructionsPerSecond(rate);
+    }
+
+    /**
+     * @brief Whether the rate gives every frame the same number of cycles, as movies need
+     */
+    bool hasWholeCyclesPerFrame() const
+    {
+        return scheduler.hasWholeCyclesPerFrame();
+    }
+
+    /**
+     * @brief Set how many overdue frames run after a stall; the rest are dropped
+     * @param frames Frames to catch up, at least 1
+     */
+    void setMaxCatchUpFrames(std::uint32_t frames)
+    {
+        scheduler.setMaxCatchUpFrames(frames);
+    }
+
+    /**
+     * @brief Set the emulation speed relative to real time
+     * @param speed Normal speed factor (below 1 = slower)
+     * @param fastForward Extra factor while Tab is held
+     */
+    void setSpeed(double speed, double fastForward)
+    {
+        baseSpeed = speed;
+        fastForwardSpeed = fastForward;
+    }
+
+    /**
+     * @brief Hash of the loaded ROM, for per-ROM settings
+     */
+    std::uint64_t getROMHash() const
+    {
+        return memory.getROMHash();
+    }
+
+    /**
+     * @brief Record the session's input to a movie file on exit
+     * @param path Movie file path (see InputScript)
+     */
+    void recordTo(const std::string &path)
+    {
+        moviePath = path;
+    }
+
+    /**
+     * @brief Profile the session and write the report on exit
+     * @param path Report path ("-" for standard output)
+     * @return false if profiling is not built in
+     */
+    bool profileTo(const std::string &path)
+    {
+        profiler = std::make_unique<Profiler>();
+        if (!cpu.setProfiler(profiler.get()))
+        {
+            profiler.reset();
+            return false;
+        }
+        profilePath = path;
+        return true;
+    }
+
     /**
      * @brief Main emulation loop
      */
@@ -79,42 +499,114 @@ public:
         }
 
         std::cout << "Graphics initialized successfully." << std::endl;
+        if (!speaker.initialize())
+        {
+            std::cerr << "No audio device, running without sound." << std::endl;
+        }
         std::cout << "Controls:" << std::endl;
         std::cout << "  CHIP-8 Keypad    Keyboard" << std::endl;
         std::cout << "  1 2 3 C    ->    1 2 3 4" << std::endl;
         std::cout << "  4 5 6 D    ->    Q W E R" << std::endl;
         std::cout << "  7 8 9 E    ->    A S D F" << std::endl;
         std::cout << "  A 0 B F    ->    Z X C V" << std::endl;
+        std::cout << "  Hold Backspace to rewind" << std::endl;
+        std::cout << "  Hold Tab to fast-forward, F2 toggles slow motion" << std::endl;
+        std::cout << "Speed: " << scheduler.getInstructionsPerSecond() << " instructions/s";
+        if (baseSpeed != 1.0)
+        {
+            std::cout << " at " << baseSpeed << "x";
+        }
+        std::cout << std::endl;
         std::cout << std::endl;
 
         std::cout << "Entering main emulation loop..." << std::endl;
         int frame_count = 0;
+        history.push(cpu);
+        publishFrame();
+        frames.update();
+
+        running.store(true, std::memory_order_release);
+        std::thread emulation(&Emulator::emulationLoop, this);
 
-        // Main emulation loop
+        // Render loop: poll input, show the newest finished frame
+        std::array<std::uint8_t, CPU::KEY_COUNT> heldKeys{};
+        bool slowMotion = false;
         while (!graphics.shouldClose())
         {
             frame_count++;
             if (frame_count % 300 == 0) // Print every 5 seconds at 60 FPS
             {
-                std::cout << "Emulator running... Frame: " << frame_count << std::endl;
+                std::cout << "Emulator running... Frame: " << frame_count
+                          << ", dropped frames: " << droppedFrames.load(std::memory_order_relaxed) << std::endl;
             }
-            // Execute multiple CPU cycles per frame for proper speed
-            for (int i = 0; i < CPU_CYCLES_PER_FRAME; i++)
+
+            // Handle input
+            input.updateKeys(heldKeys.data());
+            if (input.wasSlowMotionToggled())
             {
-                cpu.emulateCycle();
+                slowMotion = !slowMotion;
             }
+            const std::uint32_t held = InputScript::keyMaskOf(heldKeys) |
+                                       (input.isRewindHeld() ? REWIND_HELD : 0) |
+                                       (input.isFastForwardHeld() ? FAST_FORWARD_HELD : 0) |
+                                       (slowMotion ? SLOW_MOTION_ON : 0);
+            setInput(held);
 
-            // Update timers at 60Hz (once per frame)
-            cpu.updateTimers();
-
-            // Handle input
-            auto &cpuKeys = cpu.getKeys();
-            input.updateKeys(cpuKeys.data());
+            // Emulation sleeps on FX0A with this very input: the frame cannot change until a
+            // key does. Checked before taking the frame, which is published before idling.
+            const bool sleeping = idleInput.load(std::memory_order_acquire) == (held | IDLE_ON);
+            if (!frames.update() && sleeping)
+            {
+                graphics.waitForEvents();
+                continue;
+            }
 
             // Render display
-            graphics.render(cpu.getDisplay().data());
+            const Frame &shown = frames.readBuffer();
+            graphics.render(shown.planes[0].data(), shown.width, shown.height, shown.planes[1].data());
+        }
+
+        running.store(false, std::memory_order_release);
+        wakeEmulation();
+        emulation.join();
+
+        if (!moviePath.empty())
+        {
+            movie.setROMHash(memory.getROMHash());
+            movie.setSeed(cpu.getRandomSeed());
+            movie.setRandomGenerator(cpu.getRandomGenerator());
+            movie.setQuirks(cpu.getQuirks());
+            movie.setCyclesPerFrame(scheduler.getInstructionsPerSecond() / Scheduler::TIMER_RATE);
+            movie.setFrameCount(frame);
+
+            std::string error;
+            if (movie.save(moviePath, error))
+            {
+                std::cout << "Input movie saved: " << moviePath << " (" << frame << " frames)" << std::endl;
+            }
+            else
+            {
+                std::cerr << "Error: " << error << std::endl;
+            }
         }
 
+        if (profiler)
+        {
+            cpu.setProfiler(nullptr);
+            std::string error;
+            if (!profiler->saveReport(profilePath, memory, error))
+            {
+                std::cerr << "Error: " << error << std::endl;
+            }
+        }
+
+        faults.writeSummary(std::cout);
+        if (speaker.getUnderruns() != 0 || speaker.getDropped() != 0)
+        {
+            std::cout << "Audio: " << speaker.getUnderruns() << " underruns, "
+                      << speaker.getDropped() << " samples dropped" << std::endl;
+        }
+        speaker.shutdown();
         std::cout << "Emulator shutting down..." << std::endl;
     }
 };
@@ -128,11 +620,97 @@ public:
 int main(int argc, char *argv[])
 {
     // Check command line arguments
-    if (argc != 2)
+    Color foreground = WHITE;
+    Color background = BLACK;
+    std::string recordPath;
+    std::string profilePath;
+    std::string speedTablePath;
+    std::uint32_t instructionsPerSecond = 0; // 0 = speed table or default
+    std::uint32_t catchUpFrames = Scheduler::DEFAULT_MAX_CATCH_UP_FRAMES;
+    double speed = 1.0;
+    double fastForward = 4.0;
+    CPU::Quirks quirks = CPU::QUIRKS_NONE;
+    std::uint32_t seed = CPU::DEFAULT_RANDOM_SEED;
+    CPU::RandomGenerator random = CPU::RandomGenerator::Xorshift;
+    bool validArguments = argc >= 2 && argv[1][0] != '-';
+    for (int i = 2; validArguments && i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--fg") == 0 && i + 1 < argc)
+        {
+            validArguments = parseColor(argv[++i], foreground);
+        }
+        else if (std::strcmp(argv[i], "--bg") == 0 && i + 1 < argc)
+        {
+            validArguments = parseColor(argv[++i], background);
+        }
+        else if (std::strcmp(argv[i], "--quirks") == 0 && i + 1 < argc)
+        {
+            validArguments = CPU::parseQuirks(argv[++i], quirks);
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            validArguments = parseSeed(argv[++i], seed);
+        }
+        else if (std::strcmp(argv[i], "--random") == 0 && i + 1 < argc)
+        {
+            validArguments = CPU::parseRandomGenerator(argv[++i], random);
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            recordPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+        {
+            profilePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--ips") == 0 && i + 1 < argc)
+        {
+            validArguments = parseRate(argv[++i], instructionsPerSecond);
+        }
+        else if (std::strcmp(argv[i], "--speed") == 0 && i + 1 < argc)
+        {
+            validArguments = parseSpeed(argv[++i], speed);
+        }
+        else if (std::strcmp(argv[i], "--fast-forward") == 0 && i + 1 < argc)
+        {
+            validArguments = parseSpeed(argv[++i], fastForward);
+        }
+        else if (std::strcmp(argv[i], "--speed-table") == 0 && i + 1 < argc)
+        {
+            speedTablePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--catch-up") == 0 && i + 1 < argc)
+        {
+            validArguments = parseCatchUp(argv[++i], catchUpFrames);
+        }
+        else
+        {
+            validArguments = false;
+        }
+    }
+
+    if (!validArguments)
     {
         std::cout << "CHIP-8 Emulator" << std::endl;
-        std::cout << "Usage: " << argv[0] << " <ROM_FILE>" << std::endl;
-        std::cout << "Example: " << argv[0] << " games/pong.ch8" << std::endl;
+        std::cout << "Usage: " << argv[0] << " <ROM_FILE> [--fg RRGGBB] [--bg RRGGBB] [--quirks LIST] [--record MOVIE] [--profile FILE]" << std::endl;
+        std::cout << "       [--ips N] [--speed FACTOR] [--fast-forward FACTOR] [--speed-table FILE]" << std::endl;
+        std::cout << "       [--catch-up N] [--seed N] [--random xorshift|counter]" << std::endl;
+        std::cout << "  --ips N             Instructions per second (default " << Scheduler::DEFAULT_INSTRUCTIONS_PER_SECOND
+                  << "; timers always run at " << Scheduler::TIMER_RATE << "Hz)" << std::endl;
+        std::cout << "  --speed FACTOR      Speed relative to real time, e.g. 0.5 (default 1)" << std::endl;
+        std::cout << "  --fast-forward F    Speed factor while Tab is held (default 4)" << std::endl;
+        std::cout << "  --speed-table FILE  Per-ROM instructions per second (lines of <rom hash> <rate>)" << std::endl;
+        std::cout << "  --catch-up N        Most overdue frames run after a stall, the rest are dropped (default "
+                  << Scheduler::DEFAULT_MAX_CATCH_UP_FRAMES << ")" << std::endl;
+        std::cout << "  --seed N            Random seed for CXNN (default " << CPU::DEFAULT_RANDOM_SEED << ")" << std::endl;
+        std::cout << "  --random NAME       CXNN generator: xorshift (default) or counter" << std::endl;
+        std::cout << "Quirk profiles:";
+        for (const CPU::QuirkProfile *profile = CPU::quirkProfiles(); profile->name; ++profile)
+        {
+            std::cout << " " << profile->name;
+        }
+        std::cout << std::endl;
+        std::cout << "Example: " << argv[0] << " games/pong.ch8 --fg 33FF66 --bg 101010" << std::endl;
         return 1;
     }
 
@@ -140,6 +718,18 @@ int main(int argc, char *argv[])
     {
         // Create emulator instance
         Emulator emulator;
+        emulator.setColors(foreground, background);
+        emulator.setQuirks(quirks);
+        emulator.setRandom(random, seed);
+        if (!recordPath.empty())
+        {
+            emulator.recordTo(recordPath);
+        }
+        if (!profilePath.empty() && !emulator.profileTo(profilePath))
+        {
+            std::cerr << "Error: profiling is not built in (configure with -DCHIP8_PROFILER=ON)" << std::endl;
+            return 1;
+        }
 
         // Load ROM
         const std::string romPath = argv[1];
@@ -148,6 +738,32 @@ int main(int argc, char *argv[])
             return 1;
         }
 
+        // --ips wins over the ROM's speed table entry, which wins over the default
+        if (instructionsPerSecond == 0 && !speedTablePath.empty())
+        {
+            SpeedTable table;
+            std::string error;
+            if (!table.load(speedTablePath, error))
+            {
+                std::cerr << "Error: " << error << std::endl;
+                return 1;
+            }
+            table.lookup(emulator.getROMHash(), instructionsPerSecond);
+        }
+        if (instructionsPerSecond == 0)
+        {
+            instructionsPerSecond = Scheduler::DEFAULT_INSTRUCTIONS_PER_SECOND;
+        }
+        emulator.setInstructionsPerSecond(instructionsPerSecond);
+        if (!recordPath.empty() && !emulator.hasWholeCyclesPerFrame())
+        {
+            std::cerr << "Error: --record needs a rate that is a multiple of " << Scheduler::TIMER_RATE
+                      << " (movies store whole cycles per frame)" << std::endl;
+            return 1;
+        }
+        emulator.setMaxCatchUpFrames(catchUpFrames);
+        emulator.setSpeed(speed, fastForward);
+
         // Run emulator
         emulator.run();
     }
@@ -0,0 +1,133 @@
+/**
+ * @file recompile.cpp
+ * @brief CHIP-8 Emulator - Ahead-of-time recompiler
+ *
+ * Translates a ROM into C++ source for the aot backend:
+ * - Finds the reachable basic blocks with the static analyzer
+ * - Writes one C++ function per block, for one quirk set
+ * - Leaves calls, returns, key waits, memory writes and code the analysis
+ *   cannot see (indirect jump targets) to the interpreter
+ *
+ * Build the output as a shared object and run it with
+ * chip8_headless --backend aot --module FILE. CMake does both for the
+ * bundled ROMs (CHIP8_AOT_MODULES) and for ROMs added with
+ * chip8_add_aot_module().
+ *
+ * Only links against chip8_core, so it runs on display-less servers.
+ */
+
+#include "Analyzer.hpp"
+#include "CPU.hpp"
+#include "Memory.hpp"
+#include "Recompiler.hpp"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace
+{
+    /**
+     * @brief Command line options for the recompiler
+     */
+    struct Options
+    {
+        std::string romPath;
+        std::string outputPath; ///< Source destination, empty = stdout
+        CPU::Quirks quirks = CPU::QUIRKS_NONE;
+    };
+
+    void printUsage(const char *program)
+    {
+        std::cout << "CHIP-8 Ahead-of-Time Recompiler" << std::endl;
+        std::cout << "Usage: " << program << " <ROM_FILE> [options]" << std::endl;
+        std::cout << "Options:" << std::endl;
+        std::cout << "  --quirks LIST   Variant to translate for, e.g. vip or schip,increment-i" << std::endl;
+        std::cout << "  --output FILE   Write the C++ source to FILE instead of stdout" << std::endl;
+    }
+
+    bool parseOptions(int argc, char *argv[], Options &options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char *arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (std::strcmp(arg, "--quirks") == 0 && hasValue)
+            {
+                if (!CPU::parseQuirks(argv[++i], options.quirks))
+                {
+                    return false;
+                }
+            }
+            else if (std::strcmp(arg, "--output") == 0 && hasValue)
+            {
+                options.outputPath = argv[++i];
+            }
+            else if (arg[0] != '-' && options.romPath.empty())
+            {
+                options.romPath = arg;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return !options.romPath.empty();
+    }
+}
+
+/**
+ * @brief Recompiler entry point
+ * @param argc Number of command line arguments
+ * @param argv Array of command line arguments
+ * @return 0 on success, 1 on error
+ */
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // loadROM() reports on stdout; keep stdout for the source itself
+    Memory memory;
+    std::streambuf *source = std::cout.rdbuf(std::cerr.rdbuf());
+    const bool loaded = memory.loadROM(options.romPath.c_str());
+    std::cout.rdbuf(source);
+    if (!loaded)
+    {
+        return 1;
+    }
+
+    Analyzer analysis;
+    analysis.analyze(memory, options.quirks);
+    Recompiler recompiler;
+    recompiler.recompile(memory, analysis, options.quirks);
+
+    std::ofstream file;
+    if (!options.outputPath.empty())
+    {
+        file.open(options.outputPath);
+        if (!file.is_open())
+        {
+            std::cerr << "Error: Could not write " << options.outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream &out = file.is_open() ? static_cast<std::ostream &>(file) : std::cout;
+    recompiler.writeSource(out, memory, options.romPath);
+    if (!out.good())
+    {
+        return 1;
+    }
+
+    if (file.is_open())
+    {
+        std::cout << options.romPath << ": " << recompiler.getBlocks().size() << " blocks, "
+                  << recompiler.getInterpreted() << " instructions left to the interpreter" << std::endl;
+    }
+    return 0;
+}